@@ -38,6 +38,24 @@ ClassyC is an experimental and recreational library not intended for production
        Override(int, estimate_price)                                 \
        Override(void, move, int speed, int distance)
    ```
+   - Data members that are rarely used can be kept out of the objects, so more objects fit in each cache line when looping over the hot ones: add `COLD_DATA(Data, class_name)` to `CLASS_class_name`, list the cold members in the x-macro `COLD_class_name(ColdData)` with `ColdData(member_type, member_name)` entries and use `COLD_BLOCK()` after `END_CONSTRUCTOR`.
+   - The objects only hold a pointer to the cold block of the class, allocated (zeroed) on the first access to `COLD(object, class_name)->member_name`, which returns NULL if the allocation fails. `COLD_PEEK(object, class_name)` returns the block without creating it (NULL if it was never accessed). The block is freed when the object is destroyed. `class_name` is the class that declares the cold members, also for objects of derived classes.
+   - The first `COLD` access is not thread-safe: it allocates the block without synchronization, so two threads creating it at once leak one block and may write to the wrong one. Create the block (with `COLD`) before sharing the object with other threads; `COLD` and `COLD_PEEK` are then plain reads of the pointer.
+   ```c
+   #define CLASS_Car(Base, Interface, Data, Event, Method, Override) \
+       Base(Vehicle)                                                 \
+       Data(int, km_total)                                           \
+       COLD_DATA(Data, Car)
+   #define COLD_Car(ColdData)                                        \
+       ColdData(char, owner[32])                                     \
+       ColdData(int, year_of_purchase)
+   // ... CONSTRUCTOR() ... END_CONSTRUCTOR
+   COLD_BLOCK()
+   // ...
+   if (COLD(my_car, Car)) { // NULL if the block couldn't be allocated
+       COLD(my_car, Car)->year_of_purchase = 2020;
+   }
+   ```
 4. **Use `CONSTRUCTOR(optional_parameters)` macro** and include any code to execute when a new instance (available as `self` in the constructor) is created.
    - Optionally, call `INIT_BASE([optional_parameters]);` to run the user-defined code in the `CONSTRUCTOR` of the base class.
    - If used, `INIT_BASE` should be called inside the `CONSTRUCTOR` body and before any custom initialization code.
@@ -58,6 +76,7 @@ ClassyC is an experimental and recreational library not intended for production
        }     
    END_CONSTRUCTOR
    ```
+   - Use `PACKED_CONSTRUCTOR(optional_parameters)` instead to pack the data members of the class itself, with no padding between them (GCC and Clang), for small objects stored in large numbers. A packed class is `SEALED`: it can't be a base class, and it can't implement interfaces (`Interface(...)` is a compile-time error), as they would hand out pointers to unaligned members. Accessing unaligned members may be slower on some targets, and their addresses must not be used as plain pointers.
 5. **Use `DESTRUCTOR()` macro** and include cleanup code before the `END_DESTRUCTOR` macro. Instance is available as `self`, and `is_base` reports if the destructor is being called by a derived class.
    ```c
    DESTRUCTOR() END_DESTRUCTOR
@@ -83,6 +102,16 @@ ClassyC is an experimental and recreational library not intended for production
        // ...
    END_METHOD
    ```
+   - Methods that are never overridden can be defined with `FINAL_METHOD(ret_type, method_name, ...)` instead, without declaring them in `CLASS_class_name`. They have no method pointer, so they cost no memory in the objects, and are called directly with `CALL_FINAL(class_name, method_name, object[, args])`, `class_name` being the class that defines them. A derived class can't declare a method with the name of a final method of a base class (with `Method`, `Override` or `FINAL_METHOD`): it is a compile-time error. Define final methods before using them; they can't implement interface methods.
+   - Use `SEALED()` in the definition of a class (e.g. before its constructor) to forbid deriving from it: using it as a base class is a compile-time error. Sealed classes can be listed in `CLASSYC_FINAL_CLASSES` (see `CLASSYC_STATIC_CALLS`).
+   ```c
+   SEALED()
+   FINAL_METHOD(void, park)
+       self->position = 0;
+   END_METHOD
+   // ...
+   CALL_FINAL(Car, park, my_car);
+   ```
 7. **Raise events from any method using `RAISE_EVENT(object, event_name[, args])`**. If the event has a registered handler, it will be called.
 
 ## Using a class
@@ -105,6 +134,62 @@ ClassyC is an experimental and recreational library not intended for production
    Elephant my_elephant;
    NEW_INPLACE(Elephant, &my_elephant);
    ```
+   `NEW_ALLOC` and `NEW_INPLACE` set all the object memory to zero before running the constructor.
+   For big objects, `NEW_ALLOC_NOZERO(ClassName, [ConstructorArgs])` and `NEW_INPLACE_NOZERO(ClassName, object_address, [ConstructorArgs])` skip it:
+   only the members managed by ClassyC (destructor, methods, interface casts and events) are set, so the constructor must set all the data members it uses.
+   Or use `NEW_IN_ARENA(arena_address, ClassName, [ConstructorArgs])` to create a new object in a `ClassyC_arena`, for objects that share the same lifetime.
+   The arena allocates the objects (aligned) by bumping a pointer inside large blocks, and returns NULL if it can't allocate memory.
+   `ARENA_RESET(arena_address)` destroys all the objects of the arena in reverse creation order and frees all its memory at once; then the arena can be used again.
+   Objects in an arena can be destroyed before the reset with `DESTROY(*object_ptr)`, but must not be freed with `DESTROY_FREE`.
+   ```c
+   ClassyC_arena request_arena;
+   ARENA_INIT(&request_arena, 64 * 1024); // Size of the memory blocks requested to the heap
+   Car *request_car = NEW_IN_ARENA(&request_arena, Car, 200);
+   // ...
+   ARENA_RESET(&request_arena);
+   ```
+   Or use `NEW_ARRAY(ClassName, count, [ConstructorArgs])` (GCC and Clang) to create `count` objects in one contiguous block.
+   The constructor runs once for each element, as for a single object, and `ConstructorArgs` are evaluated for each element (the framework part is set up once and copied to the rest of the elements).
+   `NEW_ARRAY` returns NULL if `count` is 0 or it can't allocate memory.
+   `DESTROY_ARRAY(array_ptr)` destroys all the elements in reverse order (skipping the ones already destroyed with `DESTROY(array_ptr[i])`), frees the memory and sets the pointer to NULL.
+   ```c
+   Car *fleet = NEW_ARRAY(Car, 100, 200);
+   fleet[42].move(&fleet[42], 100, 200);
+   DESTROY_ARRAY(fleet);
+   ```
+   For passes that read or write one or two data members of many objects, use a struct of arrays instead: `SOA(ClassName)` at global scope (after the class) defines `SOA_OF(ClassName)`, a collection with one array (column) per data member of the class and its base classes, so the passes only read the columns they use.
+   Rows are only data: they have no methods, events or destructors, and data members declared as arrays (e.g. `Data(char, name[16])`) are rejected at compile time.
+   `SOA_APPEND(ClassName, soa_ptr)` adds a zeroed row and `SOA_APPEND_OBJECT(ClassName, soa_ptr, object_ptr)` a copy of the data members of an object; both return the index of the row (`SIZE_MAX` if out of memory). `SOA_REMOVE(ClassName, soa_ptr, index)` moves the last row into the removed one, and returns false if there is no row at `index`. `SOA_VIEW(ClassName, soa_ptr, index)` returns a `SOA_VIEW_OF(ClassName)` with pointers to the members of a row, valid until the collection grows. `SOA_RESERVE(ClassName, soa_ptr, rows)` preallocates (false if out of memory) and `SOA_FREE(ClassName, soa_ptr)` frees the columns.
+   The columns are `soa.member_name`, indexed from 0 to `soa.count - 1`. Copy them to local `restrict` pointers (and the count to a local variable) so the compiler can vectorize the loops.
+   ```c
+   SOA(Car)
+   // ...
+   SOA_OF(Car) cars = { 0 };
+   size_t row = SOA_APPEND_OBJECT(Car, &cars, my_car);
+   *SOA_VIEW(Car, &cars, row).km_total += 120;
+   int *restrict position = cars.position;
+   const int *restrict km_total = cars.km_total;
+   for (size_t i = 0, count = cars.count; i < count; i++) {
+       position[i] += km_total[i];
+   }
+   SOA_FREE(Car, &cars);
+   ```
+   Or keep the objects of a class in a slot map, to refer to them with handles instead of pointers: `SLOT_MAP()` at global scope, after the class x-macro, gives the class a slot map, and `HANDLE_NEW(ClassName, [ConstructorArgs])` creates an object in it and returns a `ClassyC_handle`: a `uint32_t` packing a slot index (`HANDLE_INDEX(handle)`) and the generation of the slot (`HANDLE_GENERATION(handle)`), so handles are half the size of a pointer on 64-bit targets.
+   `HANDLE_GET(ClassName, handle)` returns the object in O(1), or NULL if it was destroyed: `HANDLE_DESTROY(ClassName, handle)` destroys the object and makes every copy of its handle stale, so no copy is left dangling. A zero handle is null.
+   `CLASSYC_HANDLE_INDEX_BITS` (20 by default) sets the split: a slot map holds up to 2^20 objects (`HANDLE_NEW` returns a null handle beyond that), and a slot can be reused 2^12 - 1 times before the generations of its handles repeat.
+   The live objects are kept contiguous, `SLOT_MAP_OBJECTS(ClassName)[i]` for `i` from 0 to `SLOT_MAP_COUNT(ClassName) - 1` (`SLOT_MAP_HANDLE(ClassName, i)` returns the handle of each one), so passes over all of them are cache friendly. Creating and destroying objects moves them: pointers returned by `HANDLE_GET` are valid until then, and constructors must not create objects of their own class with `HANDLE_NEW`.
+   Objects of a slot map must not be destroyed with `DESTROY_FREE` or `RELEASE`. `SLOT_MAP_RELEASE(ClassName)` destroys all of them and frees the slot map memory.
+   ```c
+   #define CLASS_Car(Base, Interface, Data, Event, Method, Override) // ...
+   SLOT_MAP()
+   // ...
+   ClassyC_handle car = HANDLE_NEW(Car, 200);
+   Car *car_ptr = HANDLE_GET(Car, car); // NULL once the car is destroyed
+   for (size_t i = 0; i < SLOT_MAP_COUNT(Car); i++) {
+       SLOT_MAP_OBJECTS(Car)[i].km_total += 10;
+   }
+   HANDLE_DESTROY(Car, car);
+   ```
 2. **Access data members directly (`object->member_name = value;`).**
    ```c
    my_car->km_total += 120;
@@ -116,6 +201,29 @@ ClassyC is an experimental and recreational library not intended for production
    ```c
    my_car->move(my_car, 100, 200);
    ```
+   - `CALL(object, method_name[, args])` is equivalent and also works in shared vtable mode (see `CLASSYC_SHARED_VTABLE`). The object expression is evaluated twice.
+   ```c
+   CALL(my_car, move, 100, 200);
+   ```
+   - `CALL_STATIC(class_name, method_name, object[, args])` calls the implementation of `class_name` directly, without reading any method pointer, so the compiler can inline it. Use it only when the object is known to be exactly of `class_name`: overrides in derived classes are not seen. Inherited methods and interface casts can be called too. See also `CLASSYC_STATIC_CALLS`.
+   ```c
+   int price = CALL_STATIC(Car, estimate_price, my_car);
+   ```
+   - For loops over objects of mixed classes handled through a base class, declare a closed hierarchy: list all the classes in the x-macro `HIERARCHY_base_class_name(Class)` and use `CLOSED_HIERARCHY(base_class_name)` after their definitions. Then `CLOSED_CALL(base_class_name, method_name, object[, args])` selects the class of the object and calls its implementation directly, so it can be inlined. Objects of classes not listed are called through their method pointers.
+   - With GCC and Clang, `CLOSED_CALL` is a `switch` on the number that `__COUNTER__` gives to every class (`ClassyC_class_name_uid`), which the compiler can turn into a jump table, and the object expression is evaluated once. Elsewhere it compares the type descriptor of the object with the ones of the listed classes, one by one, and evaluates the object expression several times.
+   - The classes of a closed hierarchy get dense ids, `ClassyC_class_name_hierarchy_id`, from 0 to `ClassyC_base_class_name_class_count - 1`. `CLASS_ID(base_class_name, object)` returns the id of the class of an object (-1 if not listed), for instance to `switch` on it. A class can be listed in only one closed hierarchy.
+   ```c
+   #define HIERARCHY_Vehicle(Class) Class(Vehicle) Class(Car)
+   CLOSED_HIERARCHY(Vehicle)
+   // ...
+   for (i = 0; i < vehicle_count; i++) {
+       total += CLOSED_CALL(Vehicle, estimate_price, vehicles[i]);
+   }
+   ```
+   - `BATCH_CALL(objects, count, method_name[, args])` calls a method on an array of object pointers grouped by implementation, so the indirect call target stays the same inside a group: it pays off for arrays of mixed classes too long for the branch predictor to learn their order. The array is read in chunks of `CLASSYC_BATCH_CHUNK` elements (256 by default, at most 65536), whose method pointers are read once and counting-sorted by implementation, in one pass. The array is not modified, and the objects of the same implementation are called in their order in the array. Up to `CLASSYC_BATCH_GROUPS` implementations (8 by default, at most 255) are grouped in each chunk, and the objects of any other one are called last. Return values are discarded and the `objects` expression is evaluated several times. `BATCH_REF_CALL(refs, count, method_name[, args])` does the same with an array of interface references.
+   ```c
+   BATCH_CALL(vehicles, vehicle_count, move, 10, 100);
+   ```
 4. **Define event handlers using `EVENT_HANDLER(class_name, event_name, handler_ID, ...) [code] END_EVENT_HANDLER`** in the global scope (outside of any function). `handler_ID` is a unique ID for the event handler (letters, numbers, `_`).
    - Within event handlers, the instance is accessed using the `self` pointer.
    ```c
@@ -126,10 +234,32 @@ ClassyC is an experimental and recreational library not intended for production
    END_EVENT_HANDLER
    ```
 5. **Register an event handler with an object using: `REGISTER_EVENT(class_name, event_name, handler_ID, object)`**.
-   - It is allowed only one event handler per event per object, but the same handler can be registered with multiple different objects.
-   - Only the last registered handler per event and object is retained. Subsequent calls to `REGISTER_EVENT` for the same event and object will overwrite the previous handler.
+   - The same handler can be registered with multiple different objects.
+   - `REGISTER_EVENT` replaces all the handlers of the event and object: only the last registered handler is retained.
+   - To have several handlers per event and object, use `SUBSCRIBE_EVENT(class_name, event_name, handler_ID, object)` instead: the handlers are called in the order of their slots
+     in the list of the event, which is the subscription order unless a subscription reused the slot of an unsubscribed handler.
+     `UNSUBSCRIBE_EVENT(class_name, event_name, handler_ID, object)` removes a handler and `CLEAR_EVENT(object, event_name)` removes all of them.
+   - `SUBSCRIBE_EVENT` and `REGISTER_EVENT` return the `ClassyC_subscription` ID of the handler (its slot), or `CLASSYC_NO_SUBSCRIPTION` if out of memory.
+     `UNSUBSCRIBE_EVENT_ID(object, event_name, subscription)` removes the handler with the ID without searching the list.
+   - Handlers can subscribe and unsubscribe handlers (themselves included) while the event is raised: the other handlers don't move, so none is skipped.
    ```c
    REGISTER_EVENT(Car, on_need_fuel, mycar_lowfuel, my_car);
+   SUBSCRIBE_EVENT(Car, on_need_fuel, fuel_metrics, my_car); // Both handlers are called
+   ```
+   - Events can also be queued to call their handlers later, out of the code raising them. Declare the event as deferrable after the class `CONSTRUCTOR` with `DEFERRABLE_EVENT(event_name[, arg_types])`, listing only the types of its arguments (up to 8).
+     `RAISE_EVENT_DEFERRED(queue, class_name, object, event_name[, args])` copies the object pointer and the arguments into a `ClassyC_event_queue`, a ring buffer allocated once by `EVENT_QUEUE_INIT(queue, capacity, max_args_size)`.
+     Size the slots with `DEFERRED_ARGS_SIZE(class_name, event_name)`, the size of the stored arguments with their padding (the largest one if the queue holds several events).
+     Events whose arguments don't fit are dropped, and the first one is reported on stderr unless `CLASSYC_DISABLE_RUNTIME_CHECKS` is defined.
+     `CLASSYC_DRAIN_EVENTS(queue, max)` calls the handlers of up to `max` queued events (`SIZE_MAX` for all) in the order they were raised.
+     If the queue is full the event is dropped and counted in `queue->dropped`. Objects must not be destroyed while they have queued events.
+   ```c
+   DEFERRABLE_EVENT(on_need_fuel, int) // After the CONSTRUCTOR of Car
+   // ...
+   ClassyC_event_queue alerts;
+   EVENT_QUEUE_INIT(&alerts, 1024, DEFERRED_ARGS_SIZE(Car, on_need_fuel));
+   RAISE_EVENT_DEFERRED(&alerts, Car, my_car, on_need_fuel, km_to_collapse);
+   CLASSYC_DRAIN_EVENTS(&alerts, 64); // The handlers of on_need_fuel are called here
+   EVENT_QUEUE_FREE(&alerts);
    ```
 6. **To cast the object to the desired type, use `(cast_class *)object`.**
    - Available methods and data members will be the subset available in the cast class.
@@ -137,6 +267,14 @@ ClassyC is an experimental and recreational library not intended for production
    ```c
    Vehicle *my_car_as_vehicle = (Vehicle *)my_car;
    ```
+   - Every object points to the type descriptor of its actual class, `CLASS_OF(object)`: its `name`, `size`, the bytes of `padding` not used by any member, inheritance `depth` (OBJECT is 1) and `ancestors`, indexed by depth. `CLASS_INFO(class_name)` is the descriptor of a class, and its address identifies the class.
+   - `IS_A(object, class_name)` checks if an object is of a class or of a class derived from it with one indexed compare, whatever the depth. The object must not be NULL.
+   - `DYNAMIC_CAST(object, class_name)` is a checked cast: it returns NULL if the object is NULL or not of the class.
+   - Descriptors are static: like the classes, they are defined in each translation unit that defines the class. An object constructed in another translation unit points to the descriptor of that unit, so `CLASS_OF(object)` is not `CLASS_INFO(class_name)` there: `IS_A`, `DYNAMIC_CAST`, `QUERY_INTERFACE` and `CLASS_ID` then compare the class and interface names (the classes must have the same definition in every unit), and `CLOSED_CALL` calls the object through its method pointers.
+   ```c
+   Car *as_car = DYNAMIC_CAST(my_vehicle, Car); // NULL if my_vehicle is not a Car
+   if (IS_A(my_vehicle, Car)) printf("%s\n", CLASS_OF(my_vehicle)->name);
+   ```
 7. **Destroy Objects.**
   - Automatic Destruction:
     - If your compiler supports automatic destruction via `__attribute__((__cleanup__))`, objects will be automatically destroyed when they go out of scope.
@@ -205,6 +343,36 @@ The resulting interface accessor for an interface is a struct of type `interface
    ```c
    RAISE_INTERFACE_EVENT(movable_struct, on_move, distance_moved);
    ```
+6. **For interfaces used in hot loops, use interface references: `INTERFACE_REF(object, interface_name)`.**
+   - An interface reference (type `interface_name_ref`) only holds the object and a pointer to the interface descriptor of its class, instead of one pointer per interface member.
+   - The descriptor is constant data of the class: the offsets of the data members and events, and the slots of the methods in the static method table of the class (see `CALL_STATIC`). Objects keep a pointer to it next to their interface cast pointer (in the method table of the class in shared vtable mode), so `INTERFACE_REF` is one load and the two stores of the reference, with no lookup. It costs one more pointer per interface in every object (in the method table in shared vtable mode).
+   - Access the members with `REF_CALL(ref, method_name[, args])`, `REF_DATA(ref, interface_name, member_name)` (an lvalue) and `RAISE_REF_EVENT(ref, interface_name, event_name[, args])`.
+   - The object expression of `INTERFACE_REF` is evaluated twice.
+   ```c
+   void move_all(Moveable_ref *movables, size_t count) {
+       for (size_t i = 0; i < count; i++) {
+           REF_CALL(movables[i], move, 10, 20);
+           REF_DATA(movables[i], Moveable, position) += 1;
+           RAISE_REF_EVENT(movables[i], Moveable, on_move, 21);
+       }
+   }
+   // Usage
+   Moveable_ref movables[2] = { INTERFACE_REF(my_car, Moveable), INTERFACE_REF(&my_elephant, Moveable) };
+   move_all(movables, 2);
+   ```
+7. **To check at runtime if an object of unknown class implements an interface, use `QUERY_INTERFACE(object, interface_name)`.**
+   - It returns an interface reference (see above) whose `desc` is NULL if the class of the object doesn't implement the interface.
+   - The lookup uses the interface table of the class (`CLASS_OF(object)->interfaces`), generated at compile time from the `Interface` entries of the class and its base classes: it doesn't allocate.
+   - `CREATE_INTERFACE` numbers the interfaces with `__COUNTER__` (GCC, Clang, MSVC), and the table of a class is indexed by those numbers, so the lookup is one compare. Unused entries make the table as long as the number of interfaces created before the class. Without `__COUNTER__` the table is searched.
+   - The object must not be NULL and is evaluated twice.
+   ```c
+   void handle_message(OBJECT *object) {
+       Sellable_ref sellable = QUERY_INTERFACE(object, Sellable);
+       if (sellable.desc) {
+           printf("Price: %d\n", REF_CALL(sellable, estimate_price));
+       }
+   }
+   ```
 ## ClassyC configuration macros
 These macros can be defined before including this header to customize some of the library's naming conventions and error checking.
 - **CLASSYC_PREFIX**: Prefix for the global scope identifiers. Default: `#define CLASSYC_PREFIX ClassyC_`
@@ -220,17 +388,17 @@ These macros can be defined before including this header to customize some of th
    #define CLASS Aircraft
    ```
 - **CLASSYC_CLASS_IMPLEMENT**: Used to define the prefix of the macro holding the class implementation. Default: `#define CLASSYC_CLASS_IMPLEMENT CLASS_`
-  If you redefine `CLASSYC_CLASS_IMPLEMENT`, you must also define the x-macro for the `OBJECT` class with the same prefix and the `Data(void, DESTRUCTOR_FUNCTION_POINTER)` member. The (Base, Interface, Data, Event, Method, Override) parameter declaration is mandatory.
+  If you redefine `CLASSYC_CLASS_IMPLEMENT`, you must also define the x-macro for the `OBJECT` class with the same prefix and the `CLASSYC_OBJECT_MEMBERS(Data)` members. The (Base, Interface, Data, Event, Method, Override) parameter declaration is mandatory.
    ```c
    #define CLASSYC_CLASS_IMPLEMENT DECLARE_CLASS_
    #define DECLARE_CLASS_OBJECT(Base, Interface, Data, Event, Method, Override) \
-       Data(void, DESTRUCTOR_FUNCTION_POINTER)
+       CLASSYC_OBJECT_MEMBERS(Data)
    #define DECLARE_CLASS_Aircraft(Base, Interface, Data, Event, Method, Override)
    ```
    ```c
    #define CLASSYC_CLASS_IMPLEMENT CUSTOM_CLASS_
    #define CUSTOM_CLASS_OBJECT(Base, Interface, Data, Event, Method, Override) \
-       Data(void, DESTRUCTOR_FUNCTION_POINTER)
+       CLASSYC_OBJECT_MEMBERS(Data)
    #define CUSTOM_CLASS_Aircraft(Base, Interface, Data, Event, Method, Override)
    ```
 - **CLASSYC_INTERFACE_DECLARATION**: The name of the macro that declares the interface. Default: `#define CLASSYC_INTERFACE_DECLARATION I_`
@@ -240,6 +408,135 @@ These macros can be defined before including this header to customize some of th
    ```
 - **CLASSYC_DISABLE_RUNTIME_CHECKS**: Disable runtime checks for inheritance depth. Default: not defined.
 - **CLASSYC_ENABLE_COMPILE_TIME_CHECKS**: Enable compile-time checks for inheritance depth. Default: not defined.
+- **CLASSYC_SHARED_VTABLE**: Store the method and interface cast pointers in one method table per class, shared by all its objects, instead of in every object. Default: not defined.
+  - Objects only hold a pointer to the table (`_vt`), so they don't grow with the number of methods, and construction stores one pointer per inheritance level instead of one per method. The type descriptor of the class (see `CLASS_OF`) is also reached through the table.
+  - The table of each class is its static method table (see `CALL_STATIC`), a constant filled at compile time: construction only stores its address.
+  - Methods and interface casts are called with `CALL(object, method_name[, args])` (or `object->_vt->method_name(object[, args])`); `object->method_name(object)` is not available.
+  - Overrides, casts to base classes and interfaces work as in the default mode: the table of a base class is a prefix of the table of its derived classes.
+   ```c
+   #define CLASSYC_SHARED_VTABLE
+   #include "ClassyC.h"
+   // ...
+   CALL(my_car, move, 100, 200);
+   Sellable my_car_as_sellable = CALL(my_car, to_Sellable);
+   ```
+- **CLASSYC_ENABLE_POOLS**: Allow classes to allocate their heap objects from a per-class memory pool. Default: not defined.
+  - Use `POOL(chunk_objects)` at global scope after the class x-macro (before or after the `CONSTRUCTOR`) to pool a class. Classes without `POOL` keep using `calloc` and `free`.
+  - The pool carves fixed-size slots from chunks of `chunk_objects` objects. `NEW_ALLOC` takes a slot from its free list and `DESTROY_FREE` and `AUTODESTROY_PTR` give it back, both in O(1).
+  - Every object records its pool (`_pool`, NULL if not pooled), so objects can be destroyed through base class pointers. Derived classes are not pooled unless they use `POOL` too.
+  - Chunks are kept for the life of the program. `POOL_RELEASE(class_name)` frees them once all the objects of the pool have been destroyed.
+  - Pools are not thread-safe.
+   ```c
+   #define CLASSYC_ENABLE_POOLS
+   #include "ClassyC.h"
+   #define CLASS Car
+   #define CLASS_Car(Base, Interface, Data, Event, Method, Override) ...
+   POOL(1024)
+   CONSTRUCTOR() END_CONSTRUCTOR
+   ```
+- **CLASSYC_ATOMIC_EVENTS**: Allow events to be raised, subscribed and unsubscribed concurrently from several threads. Requires C11 atomics and `typeof` (C23, GCC or Clang). Default: not defined.
+  - Event members are atomic pointers to handler lists that are never modified once published. `SUBSCRIBE_EVENT`, `UNSUBSCRIBE_EVENT`, `UNSUBSCRIBE_EVENT_ID`, `REGISTER_EVENT` and `CLEAR_EVENT` publish a changed copy with a compare-and-swap, retrying if another thread changed the event meanwhile.
+  - `RAISE_EVENT` loads the list once (an acquire load) and calls the handlers it held at that moment. It writes nothing shared, so threads raising events don't contend with each other. Handlers subscribed or unsubscribed during a raise take effect on the next one.
+  - Replaced lists are retired, as other threads may still be raising the event with them, and are freed by `RECLAIM_EVENT(instance, event_name)` or when the object is destroyed. Call `RECLAIM_EVENT` at a point where no thread can be raising that event, for instance once the threads raising it are joined or wait at a barrier (other events can still be raised and changed). Until then, every change keeps a list: reclaim periodically if the handlers of a long-lived object change often.
+  - The retired lists are shared by all the events and translation units (a weak symbol with GCC and Clang, `selectany` with MSVC).
+   ```c
+   #define CLASSYC_ATOMIC_EVENTS
+   #include "ClassyC.h"
+   // Thread A
+   SUBSCRIBE_EVENT(Car, on_move, mycar_move, my_car);
+   // Thread B
+   RAISE_EVENT(my_car, on_move, 10);
+   // Once both are done, free the lists replaced by the changes
+   RECLAIM_EVENT(my_car, on_move);
+   ```
+- **CLASSYC_ENABLE_REFCOUNT**: Add a reference count to every object, so heap objects can be shared by several owners (for instance, across threads and queues). Default: not defined.
+  - Objects start with one reference. `RETAIN(ptr)` adds a reference and returns the pointer; `RELEASE(ptr)` drops one and sets the pointer to NULL. The last `RELEASE` runs the destructor and frees the object.
+  - `AUTODESTROY_PTR` pointers drop their reference when they go out of scope instead of always destroying the object. `DESTROY_FREE` destroys the object regardless of its references.
+  - Only use `RETAIN` and `RELEASE` with `NEW_ALLOC` and `NEW_ALLOC_NOZERO` objects.
+  - The count is atomic (C11): relaxed increments and an acquire-release decrement, so objects can be retained and released from several threads. Define `CLASSYC_REFCOUNT_NONATOMIC` too for a plain counter in single-threaded programs.
+   ```c
+   #define CLASSYC_ENABLE_REFCOUNT
+   #include "ClassyC.h"
+   // ...
+   Car *my_car = NEW_ALLOC(Car, 10000);
+   Car *queued_car = RETAIN(my_car);
+   RELEASE(my_car);     // queued_car is still valid
+   RELEASE(queued_car); // Destroys and frees the object
+   ```
+- **CLASSYC_STATIC_CALLS**: Make `CALL` static (see `CALL_STATIC`) for the objects whose pointer type is one of the classes listed in `CLASSYC_FINAL_CLASSES`, classes that are never derived from. Requires C11 (`_Generic`). Default: not defined.
+  - `CLASSYC_FINAL_CLASSES(X)` must be defined before the first `CALL`, after the listed classes. Other objects are called through their method pointers as usual.
+  - Only the static type of the pointer is checked: a `Car *` pointing to an object of a class derived from `Car` would call the methods of `Car`.
+   ```c
+   #define CLASSYC_STATIC_CALLS
+   #include "ClassyC.h"
+   // ... classes
+   #define CLASSYC_FINAL_CLASSES(X) X(Car) X(Elephant)
+   // ...
+   CALL(my_car, move, 100, 200);             // Static call to ClassyC_Car_move
+   CALL((Vehicle *)my_car, move, 100, 200);  // Call through the method pointer
+   ```
+- **CLASSYC_FLAT_LAYOUT**: Write the members of all the inheritance levels of a class in a single struct, instead of one nested struct per level. The members of a derived class can then use the tail padding of its base class, making objects smaller. Default: not defined.
+  - The members of a base class keep their offsets, so casts to base classes work as usual.
+  - The preprocessor can't reorder members: declare the largest members of each class first and its smallest members last, and check the result with `CLASS_INFO(class_name)->padding`.
+  - Don't copy objects by value through a base class type (e.g. `*(Vehicle *)my_car = other_vehicle`): the copy would overwrite members of the derived class stored in the tail padding of the base class.
+  - The C standard lets any store to a struct, even to one of its members, write unspecified values in its padding bytes (C11 6.2.6.1p6), and the tail padding of a base class holds members of the derived class here. The mode relies on compilers not writing padding on member stores, which GCC, Clang and MSVC don't do, but code storing whole base class structs (assignments, compound literals, `memcpy` of `sizeof` a base class) does clobber them.
+   ```c
+   #define CLASSYC_FLAT_LAYOUT
+   #include "ClassyC.h"
+   // ...
+   printf("%zu bytes of padding\n", CLASS_INFO(Car)->padding);
+   ```
+- **CLASSYC_PROFILE**: Count the calls of every method, constructor, destructor and event handler, and the clock ticks spent in them, to find the hot ones without an external profiler. Requires the cleanup attribute (GCC or Clang) and C11 atomics. Default: not defined.
+  - Times are inclusive (base class constructors and destructors, nested and recursive calls included) and measured with the time stamp counter on x86 (cycles) and `clock_gettime` elsewhere (ns). Define `CLASSYC_PROFILE_CLOCK()` and `CLASSYC_PROFILE_CLOCK_UNIT` to use another clock.
+  - Every thread counts in its own counters, each in a cache line of its own (`CLASSYC_CACHE_LINE`, 64 bytes by default), so profiled functions don't share cache lines between threads. With POSIX threads, the counters of a thread that ends are reused by the threads started later, so starting many short-lived threads doesn't keep adding counters; their totals are kept (link with `-pthread` if the C library needs it for `pthread_key_create`). The counters are merged when read: `CLASSYC_PROFILE_DUMP(file)` prints a report sorted by total time, `CLASSYC_PROFILE_GET(class_name, "method_name")` returns the totals of one function (`"constructor"`, `"destructor"`, `"event_name:handler_ID"`) and `CLASSYC_PROFILE_RESET()` zeroes them.
+  - Counters are kept per translation unit, like the classes: read them from the one that defines the classes.
+  - Without `CLASSYC_PROFILE` nothing is added to the functions, and `CLASSYC_PROFILE_DUMP` and `CLASSYC_PROFILE_RESET` do nothing.
+   ```c
+   #define CLASSYC_PROFILE
+   #include "ClassyC.h"
+   // ...
+   CLASSYC_PROFILE_DUMP(stderr);
+   ```
+- **CLASSYC_STATS**: Keep allocation and lifetime statistics for every class, updated by the constructors and destructors with relaxed atomic counters. Requires C11 atomics. Default: not defined.
+  - `CLASSYC_STATS_GET(class_name)` returns a `ClassyC_class_stats_snapshot` with the `live` objects, their `peak`, the objects `constructed` and `destroyed`, the `heap_constructed` ones (`NEW_ALLOC`, `NEW_ALLOC_NOZERO` and `NEW_ARRAY`) and the `inplace_constructed` ones (`NEW_INPLACE`, arenas and slot maps), and the `bytes_in_use` by the live objects.
+  - Objects only count in their own class, not in its base classes, even when they are destroyed through a base class pointer.
+  - `CLASSYC_STATS_COLLECT(snapshots, max_snapshots)` fills an array with the statistics of every class that has constructed objects and returns the number of those classes, for instance for a metrics exporter. Like the classes, the list is kept per translation unit.
+   ```c
+   #define CLASSYC_STATS
+   #include "ClassyC.h"
+   // ...
+   ClassyC_class_stats_snapshot snapshots[64];
+   size_t count = CLASSYC_STATS_COLLECT(snapshots, 64);
+   for (size_t i = 0; i < count && i < 64; i++) {
+       printf("%s: %zu live (peak %zu), %zu bytes\n", snapshots[i].class_info->name, snapshots[i].live, snapshots[i].peak, snapshots[i].bytes_in_use);
+   }
+   ```
+- **CLASSYC_LATENCY**: Record latency histograms, to watch the tail latency of events and methods. Requires the cleanup attribute (GCC or Clang) and C11 atomics. Default: not defined.
+  - Recorded: every `RAISE_EVENT`, `RAISE_INTERFACE_EVENT` and `RAISE_REF_EVENT` of an event with handlers (under the event name, e.g. `"on_move"`), every event handler (`"Car::on_move:mycar_move"`) and the methods defined with `TIMED_METHOD(ret_type, method_name, ...)` instead of `METHOD` (`"Car::move"`). Without `CLASSYC_LATENCY`, `TIMED_METHOD` is `METHOD`.
+  - The histograms are log-linear, like HDR histograms: values are kept with an error under 6.25% (`CLASSYC_LATENCY_PRECISION_BITS`, 4 by default, sets it to 1/2^bits). They are static, one per raise site and function, and recording a value adds one to a bucket with a relaxed atomic, so it never allocates memory.
+  - `CLASSYC_LATENCY_PERCENTILE("name", 99.9)` returns the upper limit of the bucket of a percentile, merging the histograms of the name, and `CLASSYC_LATENCY_COUNT("name")` the number of values. `CLASSYC_LATENCY_DUMP(file)` prints the count, p50, p99 and p99.9 of every name, and `CLASSYC_LATENCY_RESET()` empties the histograms. Values are in the units of the clock of `CLASSYC_PROFILE` (cycles on x86).
+   ```c
+   #define CLASSYC_LATENCY
+   #include "ClassyC.h"
+   // ...
+   TIMED_METHOD(void, move, int speed, int distance)
+       // ...
+   END_METHOD
+   // ...
+   printf("p99.9 of on_move: %llu cycles\n", (unsigned long long)CLASSYC_LATENCY_PERCENTILE("on_move", 99.9));
+   ```
+- **CLASSYC_TRACE**: Record a timeline of spans, to see where the constructor and destructor chains, `INIT_BASE`, `BASE_METHOD` and the events add latency. Requires the cleanup attribute (GCC or Clang) and C11 atomics. Default: not defined.
+  - Recorded: every method (`"Car::move"`), every level of the constructor and destructor chains (`"Vehicle::constructor"`, with an `is_base` argument when it runs for a derived class), every event handler (`"Car::on_move:mycar_move"`) and every `RAISE_EVENT`, `RAISE_INTERFACE_EVENT` and `RAISE_REF_EVENT` of an event with handlers (`"on_move"`).
+  - Every thread writes its spans to its own lock-free ring buffer of `CLASSYC_TRACE_BUFFER_SPANS` spans (16384 by default, a power of two), allocated on its first span and kept after the thread ends until its spans are flushed: with POSIX threads, `CLASSYC_TRACE_FLUSH` frees the buffers of the threads that have ended. When it is full, the oldest spans are overwritten.
+  - `CLASSYC_TRACE_FLUSH(file)` writes the spans recorded since the last flush as a Chrome trace-event JSON document (complete `"X"` events, times in microseconds, one track per thread) that opens in Perfetto (ui.perfetto.dev) and `chrome://tracing`, and returns the number of spans. Call it from one thread at a time. The spans use the monotonic clock; define `CLASSYC_TRACE_CLOCK()` (returning nanoseconds as `uint64_t`) to use another one.
+   ```c
+   #define CLASSYC_TRACE
+   #include "ClassyC.h"
+   // ...
+   FILE *file = fopen("trace.json", "w");
+   CLASSYC_TRACE_FLUSH(file);
+   fclose(file);
+   ```
 ## Additional notes
 - ClassyC supports automatic destruction of objects when they go out of scope if the compiler supports the `__attribute__((__cleanup__))` attribute (e.g., GCC and Clang).
 - Class definitions must be at the global scope. Objects can be declared at any scope, but can't be instantiated outside a function. Interfaces are declared in the top-level scope, before any class that uses them.
@@ -264,9 +561,10 @@ These macros can be defined before including this header to customize some of th
 - All the valid casts of the object will access the same versions of the data, events, and methods.
 - Interface structs returned by `to_interface_name` functions contain pointers to all the interface members in the object.
   This allows access to members and passing the interface object to functions as value.
-- Interface event members are pointers to function pointers to handle dynamic event handler registration.
+- Events are pointers to a list of handlers in the heap (NULL while the event has no handlers); the list grows on demand and is freed by the destructor.
+- Interface event members are pointers to the event members of the object to handle dynamic event handler registration.
 - All method pointers are set to the most derived version of the method in the inheritance chain.
-- Methods and events have only one level of indirection; the pointers are not in virtual tables.
+- Methods have only one level of indirection; the pointers are not in virtual tables (unless `CLASSYC_SHARED_VTABLE` is defined, which adds one level of indirection to methods).
 - The OBJECT class has a unique implementation pattern: it is the only class that has no base class and is not defined with the `CLASS_` prefix.
 - The OBJECT class is the base for all classes, and ensures that every object has the fundamental capabilities required for ClassyC's operation, such as proper destruction and synchronization.
 - The library is optimized to reduce levels of indirection and data overhead.
@@ -277,7 +575,9 @@ These macros can be defined before including this header to customize some of th
   Compile-time checks are available in C11 and later and can be enabled by defining `CLASSYC_ENABLE_COMPILE_TIME_CHECKS` before including the header.
   Runtime checks are enabled by default, but can be disabled by defining `CLASSYC_DISABLE_RUNTIME_CHECKS` before including the header.
   To support deeper inheritance hierarchies, you can extend the recursive macros definitions by adding `RECURSIVE_CLASS_MEMBER_DECLARATION_10`, `RECURSIVE_CLASS_MEMBER_DECLARATION_11`, and so on, making sure that each macro expands to the next one.
-- If you are using shared objects across multiple threads, ensure they are protected using mutexes or make sure other proper synchronization mechanisms are in place to avoid race conditions.
+- If you are using shared objects across multiple threads, ensure they are protected using mutexes or make sure other proper synchronization mechanisms are in place to avoid race conditions. Events can be made thread-safe with `CLASSYC_ATOMIC_EVENTS` and object lifetimes with `CLASSYC_ENABLE_REFCOUNT`; data members, pools, slot maps and deferred event queues are not.
+- Run `make` in the `bench` folder to measure the cost (ns/op, with percentiles) of construction, method dispatch, events, interface casts and each inheritance depth.
+  The results are also written to `bench_results.json` (`make BENCH_JSON=file.json` to change it). Configuration macros can be passed in the `CFLAGS` environment variable to compare modes.
 
 
 ## Acknowledgements
@@ -294,10 +594,47 @@ These macros can be defined before including this header to customize some of th
 #include <string.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+#if defined(CLASSYC_ATOMIC_EVENTS) || (defined(CLASSYC_ENABLE_REFCOUNT) && !defined(CLASSYC_REFCOUNT_NONATOMIC)) || defined(CLASSYC_PROFILE) || defined(CLASSYC_STATS) || defined(CLASSYC_LATENCY) || defined(CLASSYC_TRACE)
+#include <stdatomic.h>
+#endif
+#if ((defined(CLASSYC_PROFILE) || defined(CLASSYC_LATENCY)) && !defined(CLASSYC_PROFILE_CLOCK) && !defined(__x86_64__) && !defined(__i386__)) || \
+    (defined(CLASSYC_TRACE) && !defined(CLASSYC_TRACE_CLOCK))
+#include <time.h>
+#endif
+#if (defined(CLASSYC_PROFILE) || defined(CLASSYC_TRACE)) && (defined(__unix__) || defined(__APPLE__))
+#include <pthread.h>
+#endif
+
+/* Event members are atomic pointers with CLASSYC_ATOMIC_EVENTS, which also needs typeof (C23, or the __typeof__ extension) */
+#ifdef CLASSYC_ATOMIC_EVENTS
+    #define CLASSYC_EVENT_QUALIFIER _Atomic
+    #if __STDC_VERSION__ >= 202311L
+        #define CLASSYC_TYPEOF(expression) typeof(expression)
+    #else
+        #define CLASSYC_TYPEOF(expression) __typeof__(expression)
+    #endif
+#else
+    #define CLASSYC_EVENT_QUALIFIER
+#endif
+
+/* The reference count of CLASSYC_ENABLE_REFCOUNT is atomic, unless CLASSYC_REFCOUNT_NONATOMIC is also defined */
+#ifdef CLASSYC_REFCOUNT_NONATOMIC
+    #define CLASSYC_REFCOUNT_TYPE size_t
+#else
+    #define CLASSYC_REFCOUNT_TYPE _Atomic size_t
+#endif
 
 /* Class flags for constructor and destructor */
 #define IS_BASE_TRUE true
 #define IS_BASE_FALSE false
+/* Memory given to the constructor of an object */
+typedef enum ClassyC_memory {
+    CLASSYC_MEMORY_ALLOC,           /* None (NULL): the constructor allocates the object in the heap (or the class pool) */
+    CLASSYC_MEMORY_ALLOC_NOZERO,    /* None (NULL): the constructor allocates the object without zeroing it */
+    CLASSYC_MEMORY_INPLACE,         /* Memory allocated by the caller, NULL if the caller couldn't allocate it */
+    CLASSYC_MEMORY_ELEMENT          /* Element of a NEW_ARRAY array: its framework members are already set, only the user code runs */
+} ClassyC_memory;
 
 
 /* Prefix for function names to avoid polluting the global namespace. */
@@ -351,11 +688,11 @@ These macros can be defined before including this header to customize some of th
 #endif
 
 /* The name of the macro that declares the class declaration prefix: by default it is CLASS_ (resulting in CLASS_class_name) */
-/* If this is defined, the empty prefix_OBJECT(Base, Interface, Data, Event, Method, Override) macro must also be defined with the same prefix and the Data(void, DESTRUCTOR_FUNCTION_POINTER) member.*/
+/* If this is defined, the empty prefix_OBJECT(Base, Interface, Data, Event, Method, Override) macro must also be defined with the same prefix and the CLASSYC_OBJECT_MEMBERS(Data) members.*/
 /* The prefix_OBJECT macro is used when traversing the inheritance tree to declare a new class struct */
 #ifndef CLASSYC_CLASS_IMPLEMENT
    #define CLASSYC_CLASS_IMPLEMENT CLASS_
-   #define CLASS_OBJECT(Base, Interface, Data, Event, Method, Override) Data(void, DESTRUCTOR_FUNCTION_POINTER)
+   #define CLASS_OBJECT(Base, Interface, Data, Event, Method, Override) CLASSYC_OBJECT_MEMBERS(Data)
 #endif /* CLASSYC_CLASS_IMPLEMENT */
 
 #define GET_IMPLEMENTS(class_name)CONCAT(CLASSYC_CLASS_IMPLEMENT, class_name)
@@ -410,170 +747,1681 @@ These macros can be defined before including this header to customize some of th
 #define STRUCT_HEADER(struct_name)             \
     typedef struct struct_name struct_name;    \
     struct struct_name
+/* Objects are read and written through pointers to OBJECT and to their base classes, which are different struct types */
+/* with the same first members: may_alias keeps type-based alias analysis from reordering those accesses */
+#ifdef __GNUC__
+    #define CLASSYC_MAY_ALIAS __attribute__((__may_alias__))
+#else
+    #define CLASSYC_MAY_ALIAS
+#endif
+/* Declare an object struct (OBJECT or a class) and its type name */
+#define OBJECT_STRUCT_HEADER(struct_name)      \
+    typedef struct struct_name struct_name;    \
+    struct CLASSYC_MAY_ALIAS struct_name
 /* COMPONENTS OF THE CLASS STRUCT */
 #define WRITE_METHOD_POINTER(ret_type, method_name, ...) ret_type (*method_name)(void *self_void WITHOUT_COMMA(__VA_ARGS__));
 #define WRITE_DATA_MEMBER(type, member_name) type member_name;
-#define WRITE_EVENT_MEMBER(event_name, ...) void (*event_name)(void *self_void WITHOUT_COMMA(__VA_ARGS__));
+/* Events are a pointer to the list of subscribed handlers (NULL while there are none). See SUBSCRIBE_EVENT */
+#define WRITE_EVENT_MEMBER(event_name, ...) void (** CLASSYC_EVENT_QUALIFIER event_name)(void *self_void WITHOUT_COMMA(__VA_ARGS__));
 /* Interfaces create a function pointer to the interface cast function. */
 /* The interface cast function will return an interface struct with pointers to the class members */
 #define WRITE_INTERFACE_FUNCTION_POINTER(interface_name) interface_name (*CONCAT(to_, interface_name))(void *self_void);
+/* Interfaces also have a pointer to the interface descriptor of the class, so INTERFACE_REF is one load */
+#define WRITE_INTERFACE_DESC_POINTER(interface_name) const PREFIXCONCAT(interface_name, _desc) *CONCAT(_desc_, interface_name);
+#define WRITE_INTERFACE_MEMBERS(interface_name) \
+    WRITE_INTERFACE_FUNCTION_POINTER(interface_name) \
+    WRITE_INTERFACE_DESC_POINTER(interface_name)
+/* Size of a member, measured alone in a struct: there is no padding, as the size of a type is a multiple of its alignment */
+#define WRITE_DATA_MEMBER_SIZE(type, member_name) + sizeof(struct { WRITE_DATA_MEMBER(type, member_name) })
+#define WRITE_EVENT_MEMBER_SIZE(event_name, ...) + sizeof(struct { WRITE_EVENT_MEMBER(event_name, __VA_ARGS__) })
+#define WRITE_INTERFACE_MEMBERS_SIZE(interface_name) + sizeof(struct { WRITE_INTERFACE_MEMBERS(interface_name) })
+#define WRITE_METHOD_POINTER_SIZE(ret_type, method_name, ...) + sizeof(struct { WRITE_METHOD_POINTER(ret_type, method_name, __VA_ARGS__) })
 
 /* Every class has a destructor function pointer */
 /* They are introduced as data members of the OBJECT class struct that is inherited by all classes */
 #define DESTRUCTOR_FUNCTION_POINTER (*_destructor)(void *self_void)
 
+/* Members of the OBJECT class, written with the Data entry of the x-macro that is traversing the inheritance tree */
+/* In shared vtable mode the first member is the pointer to the class method table */
+/* With CLASSYC_ENABLE_POOLS every object also records the pool it was allocated from (NULL if none) */
+/* With CLASSYC_ENABLE_REFCOUNT every object also holds the number of references to it, see RETAIN and RELEASE */
+/* Every object points to the type descriptor of its class, see IS_A (in shared vtable mode, through the method table) */
+#ifdef CLASSYC_SHARED_VTABLE
+    #define CLASSYC_OBJECT_VTABLE_MEMBER(Data) Data(const void *, _vtable)
+    #define CLASSYC_OBJECT_CLASS_MEMBER(Data)
+#else
+    #define CLASSYC_OBJECT_VTABLE_MEMBER(Data)
+    #define CLASSYC_OBJECT_CLASS_MEMBER(Data) Data(const struct ClassyC_class_info *, _class)
+#endif
+#ifdef CLASSYC_ENABLE_POOLS
+    #define CLASSYC_OBJECT_POOL_MEMBER(Data) Data(struct ClassyC_pool *, _pool)
+#else
+    #define CLASSYC_OBJECT_POOL_MEMBER(Data)
+#endif
+#ifdef CLASSYC_ENABLE_REFCOUNT
+    #define CLASSYC_OBJECT_REFCOUNT_MEMBER(Data) Data(CLASSYC_REFCOUNT_TYPE, _refcount)
+#else
+    #define CLASSYC_OBJECT_REFCOUNT_MEMBER(Data)
+#endif
+#define CLASSYC_OBJECT_MEMBERS(Data)            \
+    CLASSYC_OBJECT_VTABLE_MEMBER(Data)          \
+    Data(void, DESTRUCTOR_FUNCTION_POINTER)     \
+    CLASSYC_OBJECT_CLASS_MEMBER(Data)           \
+    CLASSYC_OBJECT_POOL_MEMBER(Data)            \
+    CLASSYC_OBJECT_REFCOUNT_MEMBER(Data)
+
+/* TYPE DESCRIPTORS */
+/* Every class has a static type descriptor. The ancestors of a class are laid out by inheritance depth */
+/* (OBJECT has depth 1), so a class is a subclass of C when its entry at the depth of C is the descriptor of C */
+/* Descriptors are static, so every translation unit that defines a class has its own copy: descriptors of the same */
+/* unit are compared by address, and a descriptor of another unit (of an object constructed there) by name */
+/* The deepest classes have depth 10: OBJECT and 9 levels of classes */
+#define CLASSYC_MAX_DEPTH 10
+/* Interfaces are identified by the address of their static info, defined by CREATE_INTERFACE */
+/* CREATE_INTERFACE also numbers them from 1 with __COUNTER__ (ClassyC_<interface>_interface_id), and the interface */
+/* table of a class is indexed by that number, so a lookup is one compare. Without __COUNTER__ the table is searched. */
+/* Classes are also numbered with __COUNTER__ (ClassyC_<class>_uid, unique in the translation unit and never 0), */
+/* so closed hierarchies can select the class of an object with a switch, see CLOSED_CALL */
+#ifdef __COUNTER__
+    #define CLASSYC_INTERFACE_INDEX
+    #define CLASSYC_NEXT_INTERFACE_ID (__COUNTER__ + 1)
+    #define CLASSYC_INTERFACE_SLOT(interface_name) [PREFIXCONCAT(interface_name, _interface_id)] =
+    #define CLASSYC_CLASS_UIDS
+    #define CLASSYC_NEXT_CLASS_UID (__COUNTER__ + 1)
+#else
+    #define CLASSYC_NEXT_INTERFACE_ID 0
+    #define CLASSYC_INTERFACE_SLOT(interface_name)
+    #define CLASSYC_NEXT_CLASS_UID 0
+#endif
+typedef struct ClassyC_interface_info ClassyC_interface_info;
+struct ClassyC_interface_info {
+    const char *name;
+};
+/* Entry of the interface table of a class: the interface and the interface descriptor of the class (see INTERFACE_REF) */
+typedef struct ClassyC_interface_entry ClassyC_interface_entry;
+struct ClassyC_interface_entry {
+    const ClassyC_interface_info *interface;
+    const void *desc;
+};
+typedef struct ClassyC_class_info ClassyC_class_info;
+typedef struct ClassyC_class_stats ClassyC_class_stats;
+struct ClassyC_class_info {
+    const char *name;
+    size_t size;
+    size_t padding;     /* Bytes of the objects not used by any member, see CLASSYC_FLAT_LAYOUT */
+    int depth;
+    const ClassyC_class_info *ancestors[CLASSYC_MAX_DEPTH + 1];  /* Indexed by depth, the class itself included. [0] is unused */
+    const ClassyC_interface_entry *interfaces;                   /* Interfaces of the class and its bases, indexed by id */
+    size_t interface_count;                                      /* Entries of the table, the unused ones being NULL */
+    const char *unit;                                            /* Translation unit that defines the descriptor */
+    unsigned int uid;                                            /* Number of the class in that unit, 0 without __COUNTER__ */
+#ifdef CLASSYC_STATS
+    ClassyC_class_stats *stats;                                  /* Statistics of the objects of the class, NULL for OBJECT */
+#endif
+};
+
+/* CLASS STATISTICS */
+/* With CLASSYC_STATS, the constructor and the destructor of every object update the statistics of its class (its most */
+/* derived class: base classes don't count the objects of their derived classes). The counters are relaxed atomics, */
+/* and a class is added to the list of the translation unit when its first object is constructed. */
+#ifdef CLASSYC_STATS
+/* The live objects are the constructed ones minus the destroyed ones, so each construction and destruction only */
+/* adds to one counter (two for heap constructions). The peak is updated when a construction exceeds it. */
+struct ClassyC_class_stats {
+    _Atomic size_t peak;                /* Highest number of live objects */
+    _Atomic size_t constructed;
+    _Atomic size_t destroyed;
+    _Atomic size_t heap_constructed;    /* Constructed in memory allocated by the constructor: NEW_ALLOC, NEW_ALLOC_NOZERO and NEW_ARRAY */
+    _Atomic bool registered;
+    const ClassyC_class_info *class_info;
+    ClassyC_class_stats *next;          /* Next class of the list */
+};
+/* Statistics of a class at one moment */
+typedef struct ClassyC_class_stats_snapshot ClassyC_class_stats_snapshot;
+struct ClassyC_class_stats_snapshot {
+    const ClassyC_class_info *class_info;
+    size_t live;
+    size_t peak;
+    size_t constructed;
+    size_t destroyed;
+    size_t heap_constructed;
+    size_t inplace_constructed;         /* Constructed in memory given to the constructor: NEW_INPLACE, arenas, slot maps... */
+    size_t bytes_in_use;                /* Size of the live objects */
+};
+/* Classes with statistics, the last registered first */
+static _Atomic(ClassyC_class_stats *) ADD_PREFIX(class_stats_list) = NULL;
+
+/* Count count objects constructed, in the heap or in place */
+static CLASSYC_INLINE void ADD_PREFIX(stats_construct)(ClassyC_class_stats *stats, const ClassyC_class_info *class_info, bool heap, size_t count) {
+    size_t constructed, destroyed, live, peak;
+    if (!atomic_load_explicit(&stats->registered, memory_order_acquire) &&
+        !atomic_exchange_explicit(&stats->registered, true, memory_order_acq_rel)) {
+        stats->class_info = class_info;
+        stats->next = atomic_load_explicit(&ADD_PREFIX(class_stats_list), memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&ADD_PREFIX(class_stats_list), &stats->next, stats,
+                                                      memory_order_release, memory_order_relaxed)) {
+        }
+    }
+    if (heap) {
+        atomic_fetch_add_explicit(&stats->heap_constructed, count, memory_order_relaxed);
+    }
+    constructed = atomic_fetch_add_explicit(&stats->constructed, count, memory_order_relaxed) + count;
+    destroyed = atomic_load_explicit(&stats->destroyed, memory_order_relaxed);
+    /* Relaxed counters of other threads may be seen in any order */
+    live = constructed > destroyed ? constructed - destroyed : 0;
+    peak = atomic_load_explicit(&stats->peak, memory_order_relaxed);
+    while (live > peak && !atomic_compare_exchange_weak_explicit(&stats->peak, &peak, live, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+static CLASSYC_INLINE void ADD_PREFIX(stats_destruct)(ClassyC_class_stats *stats) {
+    if (stats) {
+        atomic_fetch_add_explicit(&stats->destroyed, 1, memory_order_relaxed);
+    }
+}
+
+static CLASSYC_INLINE ClassyC_class_stats_snapshot ADD_PREFIX(stats_snapshot)(const ClassyC_class_info *class_info) {
+    ClassyC_class_stats_snapshot snapshot;
+    ClassyC_class_stats *stats = class_info->stats;
+    snapshot.class_info = class_info;
+    snapshot.destroyed = atomic_load_explicit(&stats->destroyed, memory_order_relaxed);
+    snapshot.constructed = atomic_load_explicit(&stats->constructed, memory_order_relaxed);
+    snapshot.live = snapshot.constructed > snapshot.destroyed ? snapshot.constructed - snapshot.destroyed : 0;
+    snapshot.peak = atomic_load_explicit(&stats->peak, memory_order_relaxed);
+    snapshot.heap_constructed = atomic_load_explicit(&stats->heap_constructed, memory_order_relaxed);
+    snapshot.inplace_constructed = snapshot.constructed - snapshot.heap_constructed;
+    snapshot.bytes_in_use = snapshot.live * class_info->size;
+    return snapshot;
+}
+
+/* Fill snapshots with the statistics of up to max_snapshots classes. Returns the number of classes with statistics. */
+static CLASSYC_INLINE size_t ADD_PREFIX(stats_collect)(ClassyC_class_stats_snapshot *snapshots, size_t max_snapshots) {
+    ClassyC_class_stats *stats = atomic_load_explicit(&ADD_PREFIX(class_stats_list), memory_order_acquire);
+    size_t count = 0;
+    for (; stats; stats = stats->next, count++) {
+        if (count < max_snapshots) {
+            snapshots[count] = ADD_PREFIX(stats_snapshot)(stats->class_info);
+        }
+    }
+    return count;
+}
+
+/* Statistics of a class: CLASSYC_STATS_GET(class_name).live */
+#define CLASSYC_STATS_GET(class_name) ADD_PREFIX(stats_snapshot)(&PREFIXCONCAT(class_name, _class_info))
+/* Statistics of every class that has constructed objects: size_t count = CLASSYC_STATS_COLLECT(snapshots, max_snapshots); */
+#define CLASSYC_STATS_COLLECT(snapshots, max_snapshots) ADD_PREFIX(stats_collect)((snapshots), (max_snapshots))
+/* Code of the class descriptor, constructor and destructor that keeps the statistics */
+#define WRITE_CLASS_STATS(class_name) static ClassyC_class_stats PREFIXCONCAT(class_name, _stats);
+#define WRITE_CLASS_INFO_STATS(class_name) , &PREFIXCONCAT(class_name, _stats)
+#define CLASSYC_STATS_HEAP_DECLARATION bool ADD_PREFIX(stats_heap) = memory != CLASSYC_MEMORY_INPLACE;
+#define CLASSYC_STATS_CONSTRUCT(class_name, heap, count) \
+    ADD_PREFIX(stats_construct)(&PREFIXCONCAT(class_name, _stats), &PREFIXCONCAT(class_name, _class_info), (heap), (count));
+#define CLASSYC_STATS_DESTRUCT ADD_PREFIX(stats_destruct)(ADD_PREFIX(class_of)(self)->stats);
+#else
+#define WRITE_CLASS_STATS(class_name)
+#define WRITE_CLASS_INFO_STATS(class_name)
+#define CLASSYC_STATS_HEAP_DECLARATION
+#define CLASSYC_STATS_CONSTRUCT(class_name, heap, count)
+#define CLASSYC_STATS_DESTRUCT
+#endif /* CLASSYC_STATS */
+
+/* Static data that may not be referenced by the program (e.g. the info of an interface that no class implements) */
+#ifdef __GNUC__
+    #define CLASSYC_MAYBE_UNUSED __attribute__((unused))
+#else
+    #define CLASSYC_MAYBE_UNUSED
+#endif
+
 /* OBJECT class: the base class of all classes. It only contains the destructor function pointer. */
 /* OBJECT is a fixed name and doesn't use the CLASSYC_CLASS_NAME macro */ 
 /* OBJECT class struct */
-STRUCT_HEADER(OBJECT) {
+OBJECT_STRUCT_HEADER(OBJECT) {
     /* Having a pointer to the destructor function helps DESTROY calling it without knowing the class name */
     /* It is inherited by all classes, so every class has a pointer to the destructor function. Returns void. */
-    WRITE_DATA_MEMBER(void, DESTRUCTOR_FUNCTION_POINTER)
+    CLASSYC_OBJECT_MEMBERS(WRITE_DATA_MEMBER)
+};
+/* Marker of the translation unit: its address identifies the unit that defines a type descriptor */
+static const char ADD_PREFIX(translation_unit) = 0;
+/* OBJECT type descriptor */
+enum { PREFIXCONCAT(OBJECT, _depth) = 1, PREFIXCONCAT(OBJECT, _uid) = CLASSYC_NEXT_CLASS_UID };
+static const ClassyC_interface_entry PREFIXCONCAT(OBJECT, _interfaces)[] = { { NULL, NULL } };
+#define CLASSYC_INTERFACE_COUNT(class_name) (sizeof(PREFIXCONCAT(class_name, _interfaces)) / sizeof(ClassyC_interface_entry))
+static const ClassyC_class_info PREFIXCONCAT(OBJECT, _class_info) = {
+    "OBJECT", sizeof(OBJECT), sizeof(OBJECT) - (0 CLASSYC_OBJECT_MEMBERS(WRITE_DATA_MEMBER_SIZE)), 1,
+    { NULL, &PREFIXCONCAT(OBJECT, _class_info) }, PREFIXCONCAT(OBJECT, _interfaces), CLASSYC_INTERFACE_COUNT(OBJECT),
+    &ADD_PREFIX(translation_unit), PREFIXCONCAT(OBJECT, _uid)
+#ifdef CLASSYC_STATS
+    , NULL
+#endif
+};
+/* Every method table starts with the size of the objects and the type descriptor of the class */
+typedef struct ClassyC_vtable_header ClassyC_vtable_header;
+struct ClassyC_vtable_header {
+    size_t _size;
+    const ClassyC_class_info *_class;
 };
+#ifdef CLASSYC_SHARED_VTABLE
+/* Method table of OBJECT, for the type descriptor: OBJECT has no methods */
+static const ClassyC_vtable_header PREFIXCONCAT(OBJECT, _static_vtable) = { sizeof(OBJECT), &PREFIXCONCAT(OBJECT, _class_info) };
+#endif
+/* Type descriptor of the class of an object */
+static CLASSYC_INLINE const ClassyC_class_info *ADD_PREFIX(class_of)(const void *object) {
+#ifdef CLASSYC_SHARED_VTABLE
+    return ((const ClassyC_vtable_header *)((const OBJECT *)object)->_vtable)->_class;
+#else
+    return ((const OBJECT *)object)->_class;
+#endif
+}
+/* Whether two type descriptors are the ones of the same class: the same descriptor, or copies in different units */
+static CLASSYC_INLINE bool ADD_PREFIX(same_class)(const ClassyC_class_info *first, const ClassyC_class_info *second) {
+    return first == second || (first && second && first->unit != second->unit && strcmp(first->name, second->name) == 0);
+}
+/* Number of the class of an object in this translation unit: 0 for the classes of other units */
+static CLASSYC_INLINE unsigned int ADD_PREFIX(class_uid)(const void *object) {
+    const ClassyC_class_info *class_info = ADD_PREFIX(class_of)(object);
+    return class_info->unit == &ADD_PREFIX(translation_unit) ? class_info->uid : 0;
+}
 /* Prototypes for OBJECT class functions */
-static CLASSYC_INLINE void *PREFIXCONCAT(OBJECT, _constructor)(void *self_void);
-static CLASSYC_INLINE void *PREFIXCONCAT(OBJECT, _user_constructor)(bool is_base, void *self_void);
+static CLASSYC_INLINE void *PREFIXCONCAT(OBJECT, _constructor)(void *self_void, ClassyC_memory memory);
+static CLASSYC_INLINE void *PREFIXCONCAT(OBJECT, _user_constructor)(bool is_base, void *self_void, ClassyC_memory memory);
 static CLASSYC_INLINE void PREFIXCONCAT(OBJECT, _destructor)(void *self_void);
 static CLASSYC_INLINE void PREFIXCONCAT(OBJECT, _user_destructor)(bool is_base, void *self_void);
-/* OBJECT class constructor function: only sets the destructor function pointer */
-static CLASSYC_INLINE void *PREFIXCONCAT(OBJECT, _constructor)(void *self_void) { 
+/* OBJECT class constructor function: only sets the destructor function pointer (and the first reference) */
+static CLASSYC_INLINE void *PREFIXCONCAT(OBJECT, _constructor)(void *self_void, ClassyC_memory memory) { 
     OBJECT *self = (OBJECT *)self_void; 
     self->_destructor = PREFIXCONCAT(OBJECT, _destructor); 
+#ifdef CLASSYC_ENABLE_POOLS
+    /* The objects allocated by the constructor got their pool from pool_alloc; the memory of the caller has none */
+    if (memory == CLASSYC_MEMORY_INPLACE) {
+        self->_pool = NULL;
+    }
+#else
+    (void)memory;
+#endif
+#ifdef CLASSYC_SHARED_VTABLE
+    self->_vtable = &PREFIXCONCAT(OBJECT, _static_vtable);
+#else
+    self->_class = &PREFIXCONCAT(OBJECT, _class_info); 
+#endif
+#ifdef CLASSYC_ENABLE_REFCOUNT
+    /* The object starts with one reference, owned by its creator */
+    self->_refcount = 1;
+#endif
     /* Should not be called directly */ 
     return self; 
 }
-static CLASSYC_INLINE void *PREFIXCONCAT(OBJECT, _user_constructor)(bool is_base, void *self_void) {
+static CLASSYC_INLINE void *PREFIXCONCAT(OBJECT, _user_constructor)(bool is_base, void *self_void, ClassyC_memory memory) {
     (void)is_base;
+    (void)memory;
     return self_void;
 }
 /* OBJECT class destructor function */
 static CLASSYC_INLINE void PREFIXCONCAT(OBJECT, _destructor)(void *self_void) { (void)self_void; /* OBJECT destructor does nothing */ }
 static CLASSYC_INLINE void PREFIXCONCAT(OBJECT, _user_destructor)(bool is_base, void *self_void) { (void)is_base; (void)self_void; /* OBJECT destructor does nothing */ }
 
-/* BASIC MACROS */
-/* Get the name of the base class from the IMPLEMENTS macro */
-#define WRITE_BASE_NAME(base_to_call)base_to_call
-#define X_GET_BASE_NAME(class) GET_IMPLEMENTS(class)(WRITE_BASE_NAME, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
-
-/* Set the _destructor pointer to the class destructor function */
-/* (constructor pointer not needed, as construction is invoked by NEW_ALLOC or NEW_INPLACE calling the constructor function directly) */
-#define WRITE_SET_DESTRUCTOR_FUNC_POINTER(class_name) \
-    self->_destructor = PREFIXCONCAT(class_name, _destructor); 
+/* ALIGNMENT OF TYPES */
+/* _Alignof is available in C11 and later; before that, the offset of a member that follows a char gives the alignment */
+#if __STDC_VERSION__ >= 201112L
+    #define CLASSYC_ALIGNOF(type) _Alignof(type)
+#else
+    #define CLASSYC_ALIGNOF(type) offsetof(struct { char c; type t; }, t)
+#endif
+/* Round size up to a multiple of alignment (a power of two) */
+#define CLASSYC_ALIGN_UP(size, alignment) (((size) + (alignment) - 1) & ~((size_t)(alignment) - 1))
 
-/* Set the method pointers to the functions of the class */
-#define SET_METHOD_PTR(ret_type, method_name, ...) \
-    ((CLASSYC_CLASS_NAME *)self_void)->method_name = PREFIXCONCAT(CLASSYC_CLASS_NAME, _##method_name); 
+/* MEMORY POOLS */
+/* With CLASSYC_ENABLE_POOLS, a class can use POOL(chunk_objects) to allocate its heap objects from a pool: */
+/* fixed-size slots carved from chunks of chunk_objects slots, kept in a free list when the objects are destroyed. */
+#ifdef CLASSYC_ENABLE_POOLS
+typedef struct ClassyC_pool ClassyC_pool;
+struct ClassyC_pool {
+    size_t chunk_objects;   /* Slots per chunk. 0 means the class is not pooled and uses calloc/free */
+    size_t slot_size;       /* Object size rounded up to its alignment, set when the first chunk is allocated */
+    size_t slot_alignment;  /* Alignment of the slots, also used to pad the chunk header */
+    void *free_list;        /* Free slots, linked through their first bytes */
+    void *chunks;           /* Allocated chunks, linked through their header */
+};
 
-/* Write ALL the interface instances, data members and methods (searching only for new ones) the class implements in the class struct */
-/* by recursively crossing the inheritance tree and creating nested anonymous structs */
-#define WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) \
-        GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_INTERFACE_FUNCTION_POINTER, WRITE_DATA_MEMBER, WRITE_EVENT_MEMBER, WRITE_METHOD_POINTER, WRITE_NOTHING) \
+/* Allocate a chunk and add its slots to the free list */
+static CLASSYC_INLINE bool ADD_PREFIX(pool_grow)(ClassyC_pool *pool, size_t object_size, size_t object_alignment) {
+    size_t header_size, i;
+    char *chunk;
+    if (!pool->chunks) {
+        /* Slots must be able to hold the free list link */
+        pool->slot_alignment = object_alignment < CLASSYC_ALIGNOF(void *) ? CLASSYC_ALIGNOF(void *) : object_alignment;
+        pool->slot_size = CLASSYC_ALIGN_UP(object_size < sizeof(void *) ? sizeof(void *) : object_size, pool->slot_alignment);
+    }
+    header_size = CLASSYC_ALIGN_UP(sizeof(void *), pool->slot_alignment);
+    chunk = (char *)malloc(header_size + pool->chunk_objects * pool->slot_size);
+    if (!chunk) {
+        return false;
+    }
+    *(void **)chunk = pool->chunks;
+    pool->chunks = chunk;
+    /* Push the slots in reverse order so they are handed out in address order */
+    for (i = pool->chunk_objects; i > 0; i--) {
+        void *slot = chunk + header_size + (i - 1) * pool->slot_size;
+        *(void **)slot = pool->free_list;
+        pool->free_list = slot;
+    }
+    return true;
+}
 
+/* Allocate an object from the pool (or from the heap if the pool has no chunk size) and record its pool */
+/* The object is zeroed unless zero is false; _pool is always set */
+static CLASSYC_INLINE void *ADD_PREFIX(pool_alloc)(ClassyC_pool *pool, size_t object_size, size_t object_alignment, bool zero) {
+    void *slot;
+    if (!pool->chunk_objects) {
+        /* Not pooled: _pool is NULL */
+        if (zero) {
+            return calloc(1, object_size);
+        }
+        slot = malloc(object_size);
+        if (slot) {
+            ((OBJECT *)slot)->_pool = NULL;
+        }
+        return slot;
+    }
+    if (!pool->free_list && !ADD_PREFIX(pool_grow)(pool, object_size, object_alignment)) {
+        return NULL;
+    }
+    slot = pool->free_list;
+    pool->free_list = *(void **)slot;
+    if (zero) {
+        memset(slot, 0, object_size);
+    }
+    ((OBJECT *)slot)->_pool = pool;
+    return slot;
+}
 
-#define RECURSIVE_CLASS_MEMBER_DECLARATION_9(class)  \
-    struct { WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) } ; 
-#define RECURSIVE_CLASS_MEMBER_DECLARATION_8(class)  \
-    struct { GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_9, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
-             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) } ; 
-#define RECURSIVE_CLASS_MEMBER_DECLARATION_7(class)  \
-    struct { GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_8, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
-             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) } ; 
-#define RECURSIVE_CLASS_MEMBER_DECLARATION_6(class)  \
-    struct { GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_7, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
-             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) } ; 
-#define RECURSIVE_CLASS_MEMBER_DECLARATION_5(class)  \
-    struct { GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_6, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
-             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) } ; 
-#define RECURSIVE_CLASS_MEMBER_DECLARATION_4(class)  \
-    struct { GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_5, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
-             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) } ; 
-#define RECURSIVE_CLASS_MEMBER_DECLARATION_3(class)  \
-    struct { GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_4, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
-             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) } ; 
-#define RECURSIVE_CLASS_MEMBER_DECLARATION_2(class)  \
-    struct { GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_3, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
-             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) } ; 
-#define RECURSIVE_CLASS_MEMBER_DECLARATION_1(class)  \
-    struct { GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_2, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
-             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) } ; 
-#define RECURSIVE_CLASS_MEMBER_DECLARATIONS(class)  \
-    struct { GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_1, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
-             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) };
+/* Release the memory of a heap object to its pool (or to the heap) */
+static CLASSYC_INLINE void ADD_PREFIX(pool_free)(void *object) {
+    ClassyC_pool *pool = ((OBJECT *)object)->_pool;
+    if (!pool) {
+        free(object);
+        return;
+    }
+    *(void **)object = pool->free_list;
+    pool->free_list = object;
+}
 
-/* Macros to count inheritance levels to help with static assertions */
-#define INHERITANCE_LEVEL_1(class) + 1
-#define INHERITANCE_LEVEL_2(class) + 1 GET_IMPLEMENTS(class)(INHERITANCE_LEVEL_1, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
-#define INHERITANCE_LEVEL_3(class) + 1 GET_IMPLEMENTS(class)(INHERITANCE_LEVEL_2, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
-#define INHERITANCE_LEVEL_4(class) + 1 GET_IMPLEMENTS(class)(INHERITANCE_LEVEL_3, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
-#define INHERITANCE_LEVEL_5(class) + 1 GET_IMPLEMENTS(class)(INHERITANCE_LEVEL_4, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
-#define INHERITANCE_LEVEL_6(class) + 1 GET_IMPLEMENTS(class)(INHERITANCE_LEVEL_5, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
-#define INHERITANCE_LEVEL_7(class) + 1 GET_IMPLEMENTS(class)(INHERITANCE_LEVEL_6, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
-#define INHERITANCE_LEVEL_8(class) + 1 GET_IMPLEMENTS(class)(INHERITANCE_LEVEL_7, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
-#define INHERITANCE_LEVEL_9(class) + 1 GET_IMPLEMENTS(class)(INHERITANCE_LEVEL_8, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
-/* Use the appropriate INHERITANCE_LEVEL macro based on the depth */
-#define GET_INHERITANCE_LEVEL(class) ( 0 INHERITANCE_LEVEL_9(class))
+/* Free all the chunks of a pool: none of its objects can be alive */
+static CLASSYC_INLINE void ADD_PREFIX(pool_release)(ClassyC_pool *pool) {
+    while (pool->chunks) {
+        void *next = *(void **)pool->chunks;
+        free(pool->chunks);
+        pool->chunks = next;
+    }
+    pool->free_list = NULL;
+}
 
-/* New and overridden method function prototypes */
-#define WRITE_METHOD_FUNC_PROTOTYPE(ret_type, method_name, ...) \
-    static CLASSYC_INLINE ret_type PREFIXCONCAT(CLASSYC_CLASS_NAME, _##method_name)(void *self_void WITHOUT_COMMA(__VA_ARGS__)); 
-#define X_METHOD_FUNC_PROTOTYPES(class_name) \
-    /* Writes the method prototypes for the class: new methods and overridden methods */ \
-    GET_IMPLEMENTS(class_name)(WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_METHOD_FUNC_PROTOTYPE, WRITE_METHOD_FUNC_PROTOTYPE) 
+/* Every class has a pool: this tentative definition leaves it zeroed (not pooled) unless POOL(chunk_objects) defines it */
+#define WRITE_CLASS_POOL(class_name) \
+    static ClassyC_pool PREFIXCONCAT(class_name, _pool);
+/* Use the pool of the class for its heap objects: POOL(chunk_objects) at global scope, before or after the CONSTRUCTOR */
+#define POOL(chunk_objects) \
+    static ClassyC_pool PREFIXCONCAT(CLASSYC_CLASS_NAME, _pool) = { (chunk_objects), 0, 0, NULL, NULL };
+/* Free the memory of the pool of a class. All its objects must have been destroyed. */
+#define POOL_RELEASE(class_name) ADD_PREFIX(pool_release)(&PREFIXCONCAT(class_name, _pool))
 
+#define CLASSYC_ALLOC_OBJECT(class_name) \
+    ADD_PREFIX(pool_alloc)(&PREFIXCONCAT(class_name, _pool), sizeof(class_name), CLASSYC_ALIGNOF(class_name), true)
+#define CLASSYC_ALLOC_OBJECT_NOZERO(class_name) \
+    ADD_PREFIX(pool_alloc)(&PREFIXCONCAT(class_name, _pool), sizeof(class_name), CLASSYC_ALIGNOF(class_name), false)
+#define CLASSYC_FREE_OBJECT(object) ADD_PREFIX(pool_free)(object)
+#else
+#define WRITE_CLASS_POOL(class_name)
+#define CLASSYC_ALLOC_OBJECT(class_name) calloc(1, sizeof(class_name))
+#define CLASSYC_ALLOC_OBJECT_NOZERO(class_name) malloc(sizeof(class_name))
+#define CLASSYC_FREE_OBJECT(object) free(object)
+#endif /* CLASSYC_ENABLE_POOLS */
 
-/* INTERFACES */
-/* Macros to create interface structs with its members on CREATE_INTERFACE */
-/* Method pointer declaration in the interface struct */
-#define WRITE_I_METHOD_PTR(ret_type, method_name, ...) \
-    ret_type (*method_name)(void *self_void WITHOUT_COMMA(__VA_ARGS__));
-/* Data member pointerdeclaration in the interface struct */
-#define WRITE_I_DATA_MEMBER(type, member_name) \
-    /* A pointer to the data member */\
-    type *member_name;
-/* Event pointer (to handler function pointer) declaration in the interface struct */
-#define WRITE_I_EVENT_MEMBER(event_name, ...) \
-    /* Not a pointer to the function, but a pointer to the function pointer */\
-    /* That way, if event handlers are registered later, we don't have to reassign the pointer */\
-    void (**event_name)(void *self_void WITHOUT_COMMA(__VA_ARGS__));
-/* Write the interface struct members */
-#define WRITE_INTERFACE_STRUCT(interface_name) \
-    GET_INTERFACE(interface_name)(WRITE_I_DATA_MEMBER, WRITE_I_EVENT_MEMBER, WRITE_I_METHOD_PTR)
-/* Interface struct definition */
-#define CREATE_INTERFACE(interface_name)         \
-   typedef struct interface_name interface_name; \
-   struct interface_name {                       \
-       void *self;                               \
-       WRITE_INTERFACE_STRUCT(interface_name)    \
-   };
+/* REFERENCE COUNTING */
+/* With CLASSYC_ENABLE_REFCOUNT, heap objects are shared with RETAIN and RELEASE and destroyed when the last reference is released */
+#ifdef CLASSYC_ENABLE_REFCOUNT
+/* Add a reference to an object and return it */
+static CLASSYC_INLINE void *ADD_PREFIX(object_retain)(void *object) {
+    if (object) {
+#ifdef CLASSYC_REFCOUNT_NONATOMIC
+        ((OBJECT *)object)->_refcount++;
+#else
+        /* Nothing is published by taking a reference: the caller already holds one */
+        atomic_fetch_add_explicit(&((OBJECT *)object)->_refcount, 1, memory_order_relaxed);
+#endif
+    }
+    return object;
+}
+/* Drop a reference to an object. Returns true if it was the last one, so the object must be destroyed. */
+static CLASSYC_INLINE bool ADD_PREFIX(object_unref)(void *object) {
+#ifdef CLASSYC_REFCOUNT_NONATOMIC
+    return --((OBJECT *)object)->_refcount == 0;
+#else
+    /* Release the writes of this owner; acquire those of the other owners before destroying the object */
+    return atomic_fetch_sub_explicit(&((OBJECT *)object)->_refcount, 1, memory_order_acq_rel) == 1;
+#endif
+}
+/* Drop a reference to an object, destroying and freeing it if it was the last one */
+static CLASSYC_INLINE void ADD_PREFIX(object_release)(void *object) {
+    if (object && ADD_PREFIX(object_unref)(object)) {
+        if (((OBJECT *)object)->_destructor) {
+            ((OBJECT *)object)->_destructor(object);
+        }
+        CLASSYC_FREE_OBJECT(object);
+    }
+}
+#define CLASSYC_LAST_REFERENCE(object) ADD_PREFIX(object_unref)(object)
+#else
+#define CLASSYC_LAST_REFERENCE(object) true
+#endif /* CLASSYC_ENABLE_REFCOUNT */
 
+/* ARENAS */
+/* An arena allocates objects by bumping a pointer inside large blocks. ARENA_RESET destroys all its objects */
+/* in reverse creation order and releases all its memory at once. */
+/* Each object is preceded by a record linking it to the previous object of the arena */
+typedef struct ClassyC_arena_record ClassyC_arena_record;
+struct ClassyC_arena_record {
+    ClassyC_arena_record *prev;
+};
+typedef struct ClassyC_arena_block ClassyC_arena_block;
+struct ClassyC_arena_block {
+    ClassyC_arena_block *next;
+    char *end;              /* End of the block memory */
+};
+typedef struct ClassyC_arena ClassyC_arena;
+struct ClassyC_arena {
+    size_t block_size;              /* Default size of the blocks requested to the heap */
+    ClassyC_arena_block *blocks;    /* Blocks in use, the current one first */
+    char *top;                      /* First free byte of the current block */
+    ClassyC_arena_record *objects;  /* Record of the last object created in the arena */
+};
 
-/* Interface pointer initializers to fill the interface struct with pointers to the class members */
-#define WRITE_I_METHOD_PTR_INITIALIZER(ret_type, method_name, ...) \
-    /* Copies the method pointer to the interface */\
-    .method_name = self->method_name,
-#define WRITE_I_DATA_MEMBER_INITIALIZER(type, member_name) \
-    /* Copies the pointer to the data member to the interface */\
-    .member_name = &self->member_name,
-#define WRITE_I_EVENT_MEMBER_INITIALIZER(event_name, ...) \
-    /* Stores the address of the function pointer in the interface */\
-    .event_name = &self->event_name,
+/* Initialize an empty arena: blocks are allocated when the first object is created */
+static CLASSYC_INLINE void ADD_PREFIX(arena_init)(ClassyC_arena *arena, size_t block_size) {
+    arena->block_size = block_size;
+    arena->blocks = NULL;
+    arena->top = NULL;
+    arena->objects = NULL;
+}
 
-/* INTERFACE CAST FUNCTIONS in the form class_name_to_interface_name */
-#define WRITE_INTERFACE_CAST_FUNCTION(interface_name) \
-    interface_name TRICAT(CLASSYC_CLASS_NAME, _to_, interface_name)(void *self_void);  \
-    interface_name TRICAT(CLASSYC_CLASS_NAME, _to_, interface_name)(void *self_void) { \
-        CLASSYC_CLASS_NAME *self = (CLASSYC_CLASS_NAME *)self_void;                    \
-        interface_name interface_struct;                                               \
-        interface_struct = (interface_name){                                           \
-            GET_INTERFACE(interface_name)(WRITE_I_DATA_MEMBER_INITIALIZER, WRITE_I_EVENT_MEMBER_INITIALIZER, WRITE_I_METHOD_PTR_INITIALIZER) \
-            .self = self                                                               \
-        };                                                                             \
-        return interface_struct;                                                       \
+/* Allocate zeroed memory for an object, preceded by its record. Returns NULL on allocation failure. */
+static CLASSYC_INLINE void *ADD_PREFIX(arena_alloc)(ClassyC_arena *arena, size_t size, size_t alignment) {
+    /* Objects start with pointers, so the record right before them is always aligned */
+    uintptr_t object = 0;
+    if (arena->blocks) {
+        object = CLASSYC_ALIGN_UP((uintptr_t)arena->top + sizeof(ClassyC_arena_record), alignment);
     }
-#define WRITE_CLASS_INTERFACE_CAST_FUNCTIONS(class) \
-    GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_INTERFACE_CAST_FUNCTION, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    if (!arena->blocks || object + size > (uintptr_t)arena->blocks->end) {
+        /* The current block is full: add a block big enough for the object */
+        size_t needed = sizeof(ClassyC_arena_block) + sizeof(ClassyC_arena_record) + alignment + size;
+        size_t block_size = arena->block_size > needed ? arena->block_size : needed;
+        ClassyC_arena_block *block = (ClassyC_arena_block *)malloc(block_size);
+        if (!block) {
+            return NULL;
+        }
+        block->next = arena->blocks;
+        block->end = (char *)block + block_size;
+        arena->blocks = block;
+        object = CLASSYC_ALIGN_UP((uintptr_t)(block + 1) + sizeof(ClassyC_arena_record), alignment);
+    }
+    ((ClassyC_arena_record *)object - 1)->prev = arena->objects;
+    arena->objects = (ClassyC_arena_record *)object - 1;
+    arena->top = (char *)object + size;
+    return memset((void *)object, 0, size);
+}
 
-#define RECURSIVE_INTERFACE_CAST_FUNCTIONS_9(class)  \
+/* Destroy the objects of the arena in reverse creation order (skipping those already destroyed) and free its blocks */
+static CLASSYC_INLINE void ADD_PREFIX(arena_reset)(ClassyC_arena *arena) {
+    while (arena->objects) {
+        OBJECT *object = (OBJECT *)(arena->objects + 1);
+        if (object->_destructor) {
+            object->_destructor(object);
+        }
+        arena->objects = arena->objects->prev;
+    }
+    while (arena->blocks) {
+        ClassyC_arena_block *next = arena->blocks->next;
+        free(arena->blocks);
+        arena->blocks = next;
+    }
+    arena->top = NULL;
+}
+
+#define ARENA_INIT(arena, block_size) ADD_PREFIX(arena_init)((arena), (block_size))
+#define ARENA_RESET(arena)            ADD_PREFIX(arena_reset)(arena)
+
+/* ARRAYS */
+/* NEW_ARRAY allocates the elements in one block, after a header holding their number */
+/* The header size is a multiple of the alignment of the basic types, so the elements keep the alignment given by calloc */
+typedef union ClassyC_array_header ClassyC_array_header;
+union ClassyC_array_header {
+    size_t count;
+    long double align_long_double;
+    long long align_long_long;
+    void *align_pointer;
+    void (*align_function_pointer)(void);
+};
+
+/* Allocate a zeroed array of count elements. Returns the first element (NULL on failure or if count is 0). */
+static CLASSYC_INLINE void *ADD_PREFIX(array_alloc)(size_t count, size_t size) {
+    ClassyC_array_header *header;
+    if (!count || count > (SIZE_MAX - sizeof(ClassyC_array_header)) / size) {
+        return NULL;
+    }
+    header = (ClassyC_array_header *)calloc(1, sizeof(ClassyC_array_header) + count * size);
+    if (!header) {
+        return NULL;
+    }
+    header->count = count;
+    return header + 1;
+}
+
+/* Copy the first element of an array to the rest, doubling the copied block on each step */
+static CLASSYC_INLINE void ADD_PREFIX(array_replicate)(void *array, size_t count, size_t size) {
+    size_t done = 1;
+    while (done < count) {
+        size_t block = done < count - done ? done : count - done;
+        memcpy((char *)array + done * size, array, block * size);
+        done += block;
+    }
+}
+
+/* Destroy the elements of an array (in reverse order, skipping those already destroyed) and free it */
+static CLASSYC_INLINE void ADD_PREFIX(array_destroy)(void *array, size_t size) {
+    ClassyC_array_header *header;
+    size_t i;
+    if (!array) {
+        return;
+    }
+    header = (ClassyC_array_header *)array - 1;
+    for (i = header->count; i > 0; i--) {
+        OBJECT *element = (OBJECT *)((char *)array + (i - 1) * size);
+        if (element->_destructor) {
+            element->_destructor(element);
+        }
+    }
+    free(header);
+}
+
+/* SLOT MAPS */
+/* A slot map keeps the objects of a class in one dense block and hands out handles: the index of a slot plus the */
+/* generation of the slot when the object was created. Destroying an object moves the last object into its place and */
+/* bumps the generation of its slot, so every copy of its handle stops resolving instead of dangling. */
+/* Initial number of objects of a slot map */
+#ifndef CLASSYC_SLOT_MAP_INITIAL_CAPACITY
+#define CLASSYC_SLOT_MAP_INITIAL_CAPACITY 16
+#endif
+/* Bits of a handle for the slot index: a slot map holds up to 2^CLASSYC_HANDLE_INDEX_BITS objects. The rest of the */
+/* 32 bits hold the generation, which wraps after 2^(32 - CLASSYC_HANDLE_INDEX_BITS) - 1 reuses of a slot. */
+#ifndef CLASSYC_HANDLE_INDEX_BITS
+#define CLASSYC_HANDLE_INDEX_BITS 20
+#endif
+#if CLASSYC_HANDLE_INDEX_BITS < 1 || CLASSYC_HANDLE_INDEX_BITS > 31
+    #error "CLASSYC_HANDLE_INDEX_BITS must be between 1 and 31"
+#endif
+#define CLASSYC_HANDLE_MAX_SLOTS ((uint32_t)1 << CLASSYC_HANDLE_INDEX_BITS)
+#define CLASSYC_HANDLE_GENERATION_MASK (UINT32_MAX >> CLASSYC_HANDLE_INDEX_BITS)
+/* Handle: the slot index in the low bits and the generation in the high bits. Generation 0 is never used: 0 is null */
+typedef uint32_t ClassyC_handle;
+static CLASSYC_INLINE uint32_t ADD_PREFIX(handle_index)(ClassyC_handle handle) {
+    return handle & (CLASSYC_HANDLE_MAX_SLOTS - 1);
+}
+static CLASSYC_INLINE uint32_t ADD_PREFIX(handle_generation)(ClassyC_handle handle) {
+    return handle >> CLASSYC_HANDLE_INDEX_BITS;
+}
+static CLASSYC_INLINE ClassyC_handle ADD_PREFIX(handle_make)(uint32_t index, uint32_t generation) {
+    return (ClassyC_handle)(generation << CLASSYC_HANDLE_INDEX_BITS | index);
+}
+typedef struct ClassyC_slot ClassyC_slot;
+struct ClassyC_slot {
+    uint32_t dense_index;   /* Position of the object in the dense block, or next free slot */
+    uint32_t generation;    /* Current generation of the slot, from 1 to CLASSYC_HANDLE_GENERATION_MASK */
+};
+typedef struct ClassyC_slot_map ClassyC_slot_map;
+struct ClassyC_slot_map {
+    char *objects;          /* Live objects, contiguous */
+    uint32_t *dense_slots;  /* Slot of each live object, to fix it when the object is moved */
+    ClassyC_slot *slots;
+    uint32_t count;         /* Live objects */
+    uint32_t slot_count;    /* Slots ever used */
+    uint32_t capacity;      /* Objects and slots allocated */
+    uint32_t free_slot;     /* First free slot, UINT32_MAX if none */
+    ClassyC_handle last;    /* Handle of the last allocation, null if it failed */
+};
+
+/* Allocate zeroed memory for an object at the end of the dense block and a slot for it, and set map->last. */
+/* Returns false on allocation failure. */
+static CLASSYC_INLINE bool ADD_PREFIX(slot_map_alloc)(ClassyC_slot_map *map, size_t size) {
+    ClassyC_slot *slot;
+    uint32_t index;
+    map->last = 0;
+    if (!map->slots) {
+        map->free_slot = UINT32_MAX;
+    }
+    if (map->free_slot == UINT32_MAX && map->slot_count == map->capacity) {
+        /* Every slot is used: double the objects and the slots, up to the slots that handles can index */
+        uint32_t capacity = map->capacity ? map->capacity * 2 : CLASSYC_SLOT_MAP_INITIAL_CAPACITY;
+        void *grown;
+        if (capacity > CLASSYC_HANDLE_MAX_SLOTS || capacity < map->capacity) capacity = CLASSYC_HANDLE_MAX_SLOTS;
+        if (capacity <= map->capacity || capacity > SIZE_MAX / size) return false;
+        grown = realloc(map->objects, capacity * size);
+        if (!grown) return false;
+        map->objects = (char *)grown;
+        grown = realloc(map->dense_slots, capacity * sizeof(uint32_t));
+        if (!grown) return false;
+        map->dense_slots = (uint32_t *)grown;
+        grown = realloc(map->slots, capacity * sizeof(ClassyC_slot));
+        if (!grown) return false;
+        map->slots = (ClassyC_slot *)grown;
+        map->capacity = capacity;
+    }
+    if (map->free_slot != UINT32_MAX) {
+        index = map->free_slot;
+        slot = &map->slots[index];
+        map->free_slot = slot->dense_index;
+    } else {
+        index = map->slot_count++;
+        slot = &map->slots[index];
+        slot->generation = 1;
+    }
+    slot->dense_index = map->count;
+    map->dense_slots[map->count] = index;
+    memset(map->objects + (size_t)map->count * size, 0, size);
+    map->count++;
+    map->last = ADD_PREFIX(handle_make)(index, slot->generation);
+    return true;
+}
+
+/* Object of a handle, NULL if the handle is null or its object was destroyed */
+static CLASSYC_INLINE void *ADD_PREFIX(slot_map_get)(const ClassyC_slot_map *map, ClassyC_handle handle, size_t size) {
+    uint32_t index = ADD_PREFIX(handle_index)(handle);
+    if (index >= map->slot_count || map->slots[index].generation != ADD_PREFIX(handle_generation)(handle)) {
+        return NULL;
+    }
+    return map->objects + (size_t)map->slots[index].dense_index * size;
+}
+
+/* Handle of the object at a position of the dense block */
+static CLASSYC_INLINE ClassyC_handle ADD_PREFIX(slot_map_handle)(const ClassyC_slot_map *map, size_t dense_index) {
+    uint32_t index = map->dense_slots[dense_index];
+    return ADD_PREFIX(handle_make)(index, map->slots[index].generation);
+}
+
+/* Destroy the object of a handle and move the last object into its place. Returns false if the handle is stale. */
+static CLASSYC_INLINE bool ADD_PREFIX(slot_map_destroy)(ClassyC_slot_map *map, ClassyC_handle handle, size_t size) {
+    OBJECT *object = (OBJECT *)ADD_PREFIX(slot_map_get)(map, handle, size);
+    ClassyC_slot *slot;
+    uint32_t last;
+    if (!object) {
+        return false;
+    }
+    if (object->_destructor) {
+        object->_destructor(object);
+    }
+    /* The destructor may have destroyed other objects of the map, moving this one: find it again */
+    slot = &map->slots[ADD_PREFIX(handle_index)(handle)];
+    last = --map->count;
+    if (slot->dense_index != last) {
+        memcpy(map->objects + (size_t)slot->dense_index * size, map->objects + (size_t)last * size, size);
+        map->dense_slots[slot->dense_index] = map->dense_slots[last];
+        map->slots[map->dense_slots[last]].dense_index = slot->dense_index;
+    }
+    /* Generation 0 is kept for null handles */
+    slot->generation = (slot->generation + 1) & CLASSYC_HANDLE_GENERATION_MASK;
+    if (slot->generation == 0) {
+        slot->generation = 1;
+    }
+    slot->dense_index = map->free_slot;
+    map->free_slot = ADD_PREFIX(handle_index)(handle);
+    return true;
+}
+
+/* Destroy all the objects (last first) and free the memory of the map, leaving it empty */
+static CLASSYC_INLINE void ADD_PREFIX(slot_map_release)(ClassyC_slot_map *map, size_t size) {
+    while (map->count) {
+        ADD_PREFIX(slot_map_destroy)(map, ADD_PREFIX(slot_map_handle)(map, map->count - 1), size);
+    }
+    free(map->objects);
+    free(map->dense_slots);
+    free(map->slots);
+    memset(map, 0, sizeof(*map));
+}
+
+/* Keep the heap objects of a class in its slot map: SLOT_MAP() at global scope, after the class x-macro */
+#define SLOT_MAP() static ClassyC_slot_map PREFIXCONCAT(CLASSYC_CLASS_NAME, _slot_map);
+#define SLOT_MAP_OF(class_name) PREFIXCONCAT(class_name, _slot_map)
+/* Object of a handle: Class *ptr = HANDLE_GET(class_name, handle); NULL if the object was destroyed. */
+/* The pointer is valid until the next object of the class is created or destroyed. */
+#define HANDLE_GET(class_name, handle) \
+    ((class_name *)ADD_PREFIX(slot_map_get)(&SLOT_MAP_OF(class_name), (handle), sizeof(class_name)))
+/* Live objects, contiguous: SLOT_MAP_OBJECTS(class_name)[i] for i from 0 to SLOT_MAP_COUNT(class_name) - 1 */
+#define SLOT_MAP_COUNT(class_name)   ((size_t)SLOT_MAP_OF(class_name).count)
+#define SLOT_MAP_OBJECTS(class_name) ((class_name *)SLOT_MAP_OF(class_name).objects)
+/* Handle of the live object at position index */
+#define SLOT_MAP_HANDLE(class_name, index) ADD_PREFIX(slot_map_handle)(&SLOT_MAP_OF(class_name), (index))
+/* Slot index and generation of a handle */
+#define HANDLE_INDEX(handle) ADD_PREFIX(handle_index)(handle)
+#define HANDLE_GENERATION(handle) ADD_PREFIX(handle_generation)(handle)
+/* Destroy all the objects of the slot map of a class and free its memory */
+#define SLOT_MAP_RELEASE(class_name) ADD_PREFIX(slot_map_release)(&SLOT_MAP_OF(class_name), sizeof(class_name))
+
+/* PROFILING */
+/* With CLASSYC_PROFILE, methods, constructors, destructors and event handlers count their calls and the clock ticks */
+/* spent in them (base class and nested calls included). Every thread has its own counters, registered once per function */
+/* in a lock-free list and merged when read. The counters are updated with relaxed atomic loads and stores, which */
+/* compile to plain instructions: only the thread owning a counter writes it. Counters are never freed (readers walk */
+/* the list without locks): when a thread ends, its counters are released and the next threads reuse them. */
+#if defined(CLASSYC_PROFILE) || defined(CLASSYC_LATENCY) || defined(CLASSYC_TRACE)
+#if CLASSYC_AUTO_DESTROY_SUPPORTED == 0
+    #error "CLASSYC_PROFILE, CLASSYC_LATENCY and CLASSYC_TRACE need the cleanup attribute (GCC or Clang) to time the functions on every return"
+#endif
+#if __STDC_VERSION__ >= 201112L
+    #define CLASSYC_THREAD_LOCAL _Thread_local
+#else
+    #define CLASSYC_THREAD_LOCAL __thread
+#endif
+/* With POSIX threads, the per-thread data of a thread is released when it ends (the destructor of a thread-specific */
+/* key): profile counters are reused by the threads started later, trace buffers are freed by the next flush. */
+/* Elsewhere, it is kept until the program ends. */
+#if defined(__unix__) || defined(__APPLE__)
+    #define CLASSYC_THREAD_EXIT 1
+#else
+    #define CLASSYC_THREAD_EXIT 0
+#endif
+/* Size of a cache line: per-thread data written on every call is aligned to it, so threads never write the same line */
+#ifndef CLASSYC_CACHE_LINE
+#define CLASSYC_CACHE_LINE 64
+#endif
+/* Clock of the counters and the latency histograms: the time stamp counter on x86, the monotonic clock in nanoseconds */
+/* elsewhere. Define CLASSYC_PROFILE_CLOCK() (returning uint64_t) and CLASSYC_PROFILE_CLOCK_UNIT to use another one. */
+#ifndef CLASSYC_PROFILE_CLOCK
+    #if defined(__x86_64__) || defined(__i386__)
+        #define CLASSYC_PROFILE_CLOCK() ((uint64_t)__builtin_ia32_rdtsc())
+        #define CLASSYC_PROFILE_CLOCK_UNIT "cycles"
+    #else
+        static CLASSYC_INLINE uint64_t ADD_PREFIX(profile_clock)(void) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+        }
+        #define CLASSYC_PROFILE_CLOCK() ADD_PREFIX(profile_clock)()
+        #define CLASSYC_PROFILE_CLOCK_UNIT "ns"
+    #endif
+#endif
+#endif /* CLASSYC_PROFILE || CLASSYC_LATENCY || CLASSYC_TRACE */
+#ifdef CLASSYC_PROFILE
+/* A profiled function */
+typedef struct ClassyC_profile_site ClassyC_profile_site;
+struct ClassyC_profile_site {
+    const char *class_name;
+    const char *function_name;
+};
+/* Counters of a function in one thread, in a cache line of their own */
+typedef struct ClassyC_profile_counter ClassyC_profile_counter;
+struct ClassyC_profile_counter {
+    _Alignas(CLASSYC_CACHE_LINE) const ClassyC_profile_site *site;
+    _Atomic uint64_t calls;
+    _Atomic uint64_t ticks;
+    ClassyC_profile_counter *next;          /* Next counter of the list */
+    ClassyC_profile_counter *thread_next;   /* Next counter of the thread owning it */
+    atomic_bool owned;                      /* False once its thread has ended: a new thread can take it */
+};
+/* Counters of a function merged across threads */
+typedef struct ClassyC_profile_entry ClassyC_profile_entry;
+struct ClassyC_profile_entry {
+    const char *class_name;
+    const char *function_name;
+    uint64_t calls;
+    uint64_t ticks;
+};
+/* Running call of a profiled function, closed by the cleanup attribute when the function returns */
+typedef struct ClassyC_profile_scope ClassyC_profile_scope;
+struct ClassyC_profile_scope {
+    ClassyC_profile_counter *counter;
+    uint64_t start;
+};
+/* All the counters of the translation unit. Like the classes, counters are defined in each translation unit. */
+static _Atomic(ClassyC_profile_counter *) ADD_PREFIX(profile_counters) = NULL;
+/* Counters of the calling thread */
+static CLASSYC_THREAD_LOCAL ClassyC_profile_counter *ADD_PREFIX(profile_thread_counters) = NULL;
+#if CLASSYC_THREAD_EXIT
+static pthread_key_t ADD_PREFIX(profile_thread_key);
+static pthread_once_t ADD_PREFIX(profile_thread_once) = PTHREAD_ONCE_INIT;
+static bool ADD_PREFIX(profile_thread_key_created) = false;
+/* Destructor of the key, when a thread ends: release its counters, keeping their totals */
+static void ADD_PREFIX(profile_thread_exit)(void *counters) {
+    ClassyC_profile_counter *counter = (ClassyC_profile_counter *)counters;
+    while (counter) {
+        /* Once released, the counter can be taken by another thread: read the next one first */
+        ClassyC_profile_counter *next = counter->thread_next;
+        atomic_store_explicit(&counter->owned, false, memory_order_release);
+        counter = next;
+    }
+}
+static void ADD_PREFIX(profile_thread_key_create)(void) {
+    ADD_PREFIX(profile_thread_key_created) =
+        pthread_key_create(&ADD_PREFIX(profile_thread_key), ADD_PREFIX(profile_thread_exit)) == 0;
+}
+#endif
+
+/* Get a counter of a function for the calling thread: one released by an ended thread, or a new one added to the list. */
+/* Returns NULL (not counted) if out of memory. */
+static CLASSYC_INLINE ClassyC_profile_counter *ADD_PREFIX(profile_register)(const ClassyC_profile_site *site) {
+    ClassyC_profile_counter *counter = atomic_load_explicit(&ADD_PREFIX(profile_counters), memory_order_acquire);
+    for (; counter; counter = counter->next) {
+        bool owned = false;
+        /* Acquire the counts of the thread that released it */
+        if (counter->site == site && !atomic_load_explicit(&counter->owned, memory_order_relaxed) &&
+            atomic_compare_exchange_strong_explicit(&counter->owned, &owned, true, memory_order_acquire, memory_order_relaxed)) {
+            break;
+        }
+    }
+    if (!counter) {
+        /* Aligned by hand in a larger block, as the Windows C library has no aligned_alloc: counters are never freed */
+        void *block = calloc(1, sizeof(ClassyC_profile_counter) + CLASSYC_CACHE_LINE - 1);
+        if (!block) {
+            return NULL;
+        }
+        counter = (ClassyC_profile_counter *)(((uintptr_t)block + CLASSYC_CACHE_LINE - 1) & ~(uintptr_t)(CLASSYC_CACHE_LINE - 1));
+        counter->site = site;
+        atomic_init(&counter->owned, true);
+        counter->next = atomic_load_explicit(&ADD_PREFIX(profile_counters), memory_order_relaxed);
+        /* Publish the counter with its site: readers acquire the list */
+        while (!atomic_compare_exchange_weak_explicit(&ADD_PREFIX(profile_counters), &counter->next, counter,
+                                                      memory_order_release, memory_order_relaxed)) {
+        }
+    }
+    counter->thread_next = ADD_PREFIX(profile_thread_counters);
+    ADD_PREFIX(profile_thread_counters) = counter;
+#if CLASSYC_THREAD_EXIT
+    pthread_once(&ADD_PREFIX(profile_thread_once), ADD_PREFIX(profile_thread_key_create));
+    if (ADD_PREFIX(profile_thread_key_created)) {
+        pthread_setspecific(ADD_PREFIX(profile_thread_key), counter);
+    }
+#endif
+    return counter;
+}
+
+static CLASSYC_INLINE void ADD_PREFIX(profile_end)(ClassyC_profile_scope *scope) {
+    uint64_t elapsed = CLASSYC_PROFILE_CLOCK() - scope->start;
+    ClassyC_profile_counter *counter = scope->counter;
+    if (counter) {
+        atomic_store_explicit(&counter->calls, atomic_load_explicit(&counter->calls, memory_order_relaxed) + 1, memory_order_relaxed);
+        atomic_store_explicit(&counter->ticks, atomic_load_explicit(&counter->ticks, memory_order_relaxed) + elapsed, memory_order_relaxed);
+    }
+}
+
+/* Merge the counters of all the threads by function into entries (up to max_entries). Returns the number of functions. */
+static CLASSYC_INLINE size_t ADD_PREFIX(profile_merge)(ClassyC_profile_entry *entries, size_t max_entries) {
+    ClassyC_profile_counter *counter = atomic_load_explicit(&ADD_PREFIX(profile_counters), memory_order_acquire);
+    size_t count = 0, i;
+    for (; counter; counter = counter->next) {
+        for (i = 0; i < count; i++) {
+            if (strcmp(entries[i].class_name, counter->site->class_name) == 0 &&
+                strcmp(entries[i].function_name, counter->site->function_name) == 0) {
+                break;
+            }
+        }
+        if (i == count) {
+            if (count == max_entries) {
+                continue;
+            }
+            entries[count].class_name = counter->site->class_name;
+            entries[count].function_name = counter->site->function_name;
+            entries[count].calls = 0;
+            entries[count].ticks = 0;
+            count++;
+        }
+        entries[i].calls += atomic_load_explicit(&counter->calls, memory_order_relaxed);
+        entries[i].ticks += atomic_load_explicit(&counter->ticks, memory_order_relaxed);
+    }
+    return count;
+}
+
+/* Merged counters of one function (zero if it was never called) */
+static CLASSYC_INLINE ClassyC_profile_entry ADD_PREFIX(profile_get)(const char *class_name, const char *function_name) {
+    ClassyC_profile_counter *counter = atomic_load_explicit(&ADD_PREFIX(profile_counters), memory_order_acquire);
+    ClassyC_profile_entry entry;
+    entry.class_name = class_name;
+    entry.function_name = function_name;
+    entry.calls = 0;
+    entry.ticks = 0;
+    for (; counter; counter = counter->next) {
+        if (strcmp(class_name, counter->site->class_name) == 0 && strcmp(function_name, counter->site->function_name) == 0) {
+            entry.calls += atomic_load_explicit(&counter->calls, memory_order_relaxed);
+            entry.ticks += atomic_load_explicit(&counter->ticks, memory_order_relaxed);
+        }
+    }
+    return entry;
+}
+
+/* Zero all the counters. Calls running in other threads meanwhile may be partly kept. */
+static CLASSYC_INLINE void ADD_PREFIX(profile_reset)(void) {
+    ClassyC_profile_counter *counter = atomic_load_explicit(&ADD_PREFIX(profile_counters), memory_order_acquire);
+    for (; counter; counter = counter->next) {
+        atomic_store_explicit(&counter->calls, 0, memory_order_relaxed);
+        atomic_store_explicit(&counter->ticks, 0, memory_order_relaxed);
+    }
+}
+
+static CLASSYC_INLINE int ADD_PREFIX(profile_compare)(const void *a, const void *b) {
+    uint64_t ticks_a = ((const ClassyC_profile_entry *)a)->ticks;
+    uint64_t ticks_b = ((const ClassyC_profile_entry *)b)->ticks;
+    return (ticks_a < ticks_b) - (ticks_a > ticks_b);
+}
+
+/* Print the merged counters of every function called, the most expensive first */
+static CLASSYC_INLINE void ADD_PREFIX(profile_dump)(FILE *file) {
+    ClassyC_profile_counter *counter = atomic_load_explicit(&ADD_PREFIX(profile_counters), memory_order_acquire);
+    ClassyC_profile_entry *entries;
+    size_t max_entries = 0, count, i;
+    for (; counter; counter = counter->next) {
+        max_entries++;
+    }
+    entries = (ClassyC_profile_entry *)malloc((max_entries ? max_entries : 1) * sizeof(ClassyC_profile_entry));
+    if (!entries) {
+        return;
+    }
+    count = ADD_PREFIX(profile_merge)(entries, max_entries);
+    qsort(entries, count, sizeof(ClassyC_profile_entry), ADD_PREFIX(profile_compare));
+    fprintf(file, "%-40s %14s %18s %14s\n", "function", "calls", "total " CLASSYC_PROFILE_CLOCK_UNIT, "per call");
+    for (i = 0; i < count; i++) {
+        char name[256];
+        if (!entries[i].calls) {
+            continue;
+        }
+        snprintf(name, sizeof(name), "%s::%s", entries[i].class_name, entries[i].function_name);
+        fprintf(file, "%-40s %14llu %18llu %14.1f\n", name, (unsigned long long)entries[i].calls,
+                (unsigned long long)entries[i].ticks, (double)entries[i].ticks / (double)entries[i].calls);
+    }
+    free(entries);
+}
+
+/* First statement of a profiled function: declares its site, the counter of the thread and the running call */
+#define CLASSYC_PROFILE_ENTER(class_name, function_name)                                                     \
+    static const ClassyC_profile_site ADD_PREFIX(profile_site) = { QUOTE(class_name), function_name };      \
+    static CLASSYC_THREAD_LOCAL ClassyC_profile_counter *ADD_PREFIX(profile_counter) = NULL;                  \
+    if (!ADD_PREFIX(profile_counter)) {                                                                       \
+        ADD_PREFIX(profile_counter) = ADD_PREFIX(profile_register)(&ADD_PREFIX(profile_site));                \
+    }                                                                                                         \
+    ClassyC_profile_scope ADD_PREFIX(profile_scope) __attribute__((__cleanup__(ADD_PREFIX(profile_end)))) = { \
+        ADD_PREFIX(profile_counter), CLASSYC_PROFILE_CLOCK() };
+/* Print the report to a FILE *: CLASSYC_PROFILE_DUMP(stderr) */
+#define CLASSYC_PROFILE_DUMP(file) ADD_PREFIX(profile_dump)(file)
+/* Merged counters of a function: CLASSYC_PROFILE_GET(class_name, "method_name").calls */
+/* (constructors and destructors are "constructor" and "destructor", event handlers "event_name:handler_ID") */
+#define CLASSYC_PROFILE_GET(class_name, function_name) ADD_PREFIX(profile_get)(QUOTE(class_name), (function_name))
+#define CLASSYC_PROFILE_RESET() ADD_PREFIX(profile_reset)()
+#else
+#define CLASSYC_PROFILE_ENTER(class_name, function_name)
+#define CLASSYC_PROFILE_DUMP(file) ((void)0)
+#define CLASSYC_PROFILE_RESET() ((void)0)
+#endif /* CLASSYC_PROFILE */
+
+/* LATENCY HISTOGRAMS */
+/* With CLASSYC_LATENCY, raising an event with handlers, event handlers and TIMED_METHOD methods record their duration */
+/* in log-linear histograms: values below 2^CLASSYC_LATENCY_PRECISION_BITS clock ticks have a bucket each, and every */
+/* power of two above is split in 2^CLASSYC_LATENCY_PRECISION_BITS buckets (6.25% wide with the default 4 bits). */
+/* Every raise site and function has a static histogram, added to a list on its first record and merged by name when */
+/* queried. Recording only adds one to a bucket with a relaxed atomic: it never allocates. */
+#ifdef CLASSYC_LATENCY
+#ifndef CLASSYC_LATENCY_PRECISION_BITS
+#define CLASSYC_LATENCY_PRECISION_BITS 4
+#endif
+#define CLASSYC_LATENCY_SUB_BUCKETS (1u << CLASSYC_LATENCY_PRECISION_BITS)
+#define CLASSYC_LATENCY_BUCKETS ((65 - CLASSYC_LATENCY_PRECISION_BITS) * CLASSYC_LATENCY_SUB_BUCKETS)
+typedef struct ClassyC_histogram ClassyC_histogram;
+struct ClassyC_histogram {
+    const char *name;       /* "event_name", "class_name::method_name" or "class_name::event_name:handler_ID" */
+    _Atomic bool registered;
+    ClassyC_histogram *next;
+    _Atomic uint64_t buckets[CLASSYC_LATENCY_BUCKETS];
+};
+/* Running call of a timed function, closed by the cleanup attribute when the function returns */
+typedef struct ClassyC_latency_scope ClassyC_latency_scope;
+struct ClassyC_latency_scope {
+    ClassyC_histogram *histogram;
+    uint64_t start;
+};
+/* Histograms of the translation unit that have recorded values */
+static _Atomic(ClassyC_histogram *) ADD_PREFIX(histograms) = NULL;
+
+static CLASSYC_INLINE size_t ADD_PREFIX(histogram_bucket)(uint64_t value) {
+    unsigned exponent;
+    if (value < CLASSYC_LATENCY_SUB_BUCKETS) {
+        return (size_t)value;
+    }
+    exponent = 63u - (unsigned)__builtin_clzll(value);
+    return (size_t)(exponent - CLASSYC_LATENCY_PRECISION_BITS + 1) * CLASSYC_LATENCY_SUB_BUCKETS +
+           (size_t)((value >> (exponent - CLASSYC_LATENCY_PRECISION_BITS)) & (CLASSYC_LATENCY_SUB_BUCKETS - 1));
+}
+
+/* Highest value of a bucket */
+static CLASSYC_INLINE uint64_t ADD_PREFIX(histogram_bucket_limit)(size_t bucket) {
+    unsigned shift;
+    if (bucket < CLASSYC_LATENCY_SUB_BUCKETS) {
+        return bucket;
+    }
+    shift = (unsigned)(bucket / CLASSYC_LATENCY_SUB_BUCKETS) - 1;
+    return ((((uint64_t)CLASSYC_LATENCY_SUB_BUCKETS + bucket % CLASSYC_LATENCY_SUB_BUCKETS) << shift) - 1) + ((uint64_t)1 << shift);
+}
+
+static CLASSYC_INLINE void ADD_PREFIX(histogram_record)(ClassyC_histogram *histogram, uint64_t value) {
+    if (!atomic_load_explicit(&histogram->registered, memory_order_acquire) &&
+        !atomic_exchange_explicit(&histogram->registered, true, memory_order_acq_rel)) {
+        histogram->next = atomic_load_explicit(&ADD_PREFIX(histograms), memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&ADD_PREFIX(histograms), &histogram->next, histogram,
+                                                      memory_order_release, memory_order_relaxed)) {
+        }
+    }
+    atomic_fetch_add_explicit(&histogram->buckets[ADD_PREFIX(histogram_bucket)(value)], 1, memory_order_relaxed);
+}
+
+static CLASSYC_INLINE void ADD_PREFIX(latency_end)(ClassyC_latency_scope *scope) {
+    ADD_PREFIX(histogram_record)(scope->histogram, CLASSYC_PROFILE_CLOCK() - scope->start);
+}
+
+/* Values recorded under a name, merging its histograms */
+static CLASSYC_INLINE uint64_t ADD_PREFIX(latency_count)(const char *name) {
+    ClassyC_histogram *histogram = atomic_load_explicit(&ADD_PREFIX(histograms), memory_order_acquire);
+    uint64_t count = 0;
+    size_t bucket;
+    for (; histogram; histogram = histogram->next) {
+        if (strcmp(histogram->name, name) == 0) {
+            for (bucket = 0; bucket < CLASSYC_LATENCY_BUCKETS; bucket++) {
+                count += atomic_load_explicit(&histogram->buckets[bucket], memory_order_relaxed);
+            }
+        }
+    }
+    return count;
+}
+
+/* Upper limit of the bucket holding the given percentile (0 to 100) of the values recorded under a name. 0 if none. */
+static CLASSYC_INLINE uint64_t ADD_PREFIX(latency_percentile)(const char *name, double percentile) {
+    ClassyC_histogram *first = atomic_load_explicit(&ADD_PREFIX(histograms), memory_order_acquire);
+    ClassyC_histogram *histogram;
+    uint64_t count = ADD_PREFIX(latency_count)(name), rank, seen = 0;
+    /* Less a tolerance for the rounding of percentiles like 99.9, which have no exact binary representation */
+    double exact_rank = percentile * (double)count / 100.0 - 1e-9;
+    size_t bucket;
+    if (!count) {
+        return 0;
+    }
+    /* Rank of the value of the percentile, from 1 to count */
+    rank = (uint64_t)exact_rank;
+    if ((double)rank < exact_rank) rank++;
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    for (bucket = 0; bucket < CLASSYC_LATENCY_BUCKETS; bucket++) {
+        for (histogram = first; histogram; histogram = histogram->next) {
+            if (strcmp(histogram->name, name) == 0) {
+                seen += atomic_load_explicit(&histogram->buckets[bucket], memory_order_relaxed);
+            }
+        }
+        if (seen >= rank) {
+            return ADD_PREFIX(histogram_bucket_limit)(bucket);
+        }
+    }
+    /* Values recorded while reading */
+    return ADD_PREFIX(histogram_bucket_limit)(CLASSYC_LATENCY_BUCKETS - 1);
+}
+
+static CLASSYC_INLINE void ADD_PREFIX(latency_reset)(void) {
+    ClassyC_histogram *histogram = atomic_load_explicit(&ADD_PREFIX(histograms), memory_order_acquire);
+    size_t bucket;
+    for (; histogram; histogram = histogram->next) {
+        for (bucket = 0; bucket < CLASSYC_LATENCY_BUCKETS; bucket++) {
+            atomic_store_explicit(&histogram->buckets[bucket], 0, memory_order_relaxed);
+        }
+    }
+}
+
+/* Print the count and the p50, p99 and p99.9 of every name */
+static CLASSYC_INLINE void ADD_PREFIX(latency_dump)(FILE *file) {
+    ClassyC_histogram *first = atomic_load_explicit(&ADD_PREFIX(histograms), memory_order_acquire);
+    ClassyC_histogram *histogram, *previous;
+    fprintf(file, "%-48s %14s %12s %12s %12s (" CLASSYC_PROFILE_CLOCK_UNIT ")\n", "name", "count", "p50", "p99", "p99.9");
+    for (histogram = first; histogram; histogram = histogram->next) {
+        uint64_t count;
+        /* Each name once */
+        for (previous = first; previous != histogram && strcmp(previous->name, histogram->name) != 0; previous = previous->next) {
+        }
+        count = ADD_PREFIX(latency_count)(histogram->name);
+        if (previous != histogram || !count) {
+            continue;
+        }
+        fprintf(file, "%-48s %14llu %12llu %12llu %12llu\n", histogram->name, (unsigned long long)count,
+                (unsigned long long)ADD_PREFIX(latency_percentile)(histogram->name, 50.0),
+                (unsigned long long)ADD_PREFIX(latency_percentile)(histogram->name, 99.0),
+                (unsigned long long)ADD_PREFIX(latency_percentile)(histogram->name, 99.9));
+    }
+}
+
+/* First statement of a timed function */
+#define CLASSYC_LATENCY_ENTER(histogram_name)                                                                       \
+    static ClassyC_histogram ADD_PREFIX(latency_histogram) = { .name = histogram_name };                                   \
+    ClassyC_latency_scope ADD_PREFIX(latency_scope) __attribute__((__cleanup__(ADD_PREFIX(latency_end)))) = { \
+        &ADD_PREFIX(latency_histogram), CLASSYC_PROFILE_CLOCK() };
+/* Time the raise of an event that has handlers */
+#define CLASSYC_LATENCY_RAISE(event_name, event_member, raise)                                              \
+    do {                                                                                                    \
+        if (event_member) {                                                                                 \
+            static ClassyC_histogram ADD_PREFIX(latency_histogram) = { .name = #event_name };                    \
+            uint64_t ADD_PREFIX(latency_start) = CLASSYC_PROFILE_CLOCK();                                   \
+            raise;                                                                                          \
+            ADD_PREFIX(histogram_record)(&ADD_PREFIX(latency_histogram), CLASSYC_PROFILE_CLOCK() - ADD_PREFIX(latency_start)); \
+        }                                                                                                   \
+    } while (0)
+/* Queries: CLASSYC_LATENCY_PERCENTILE("Car::move", 99.9), CLASSYC_LATENCY_COUNT("on_move") */
+#define CLASSYC_LATENCY_PERCENTILE(name, percentile) ADD_PREFIX(latency_percentile)((name), (percentile))
+#define CLASSYC_LATENCY_COUNT(name) ADD_PREFIX(latency_count)(name)
+#define CLASSYC_LATENCY_DUMP(file) ADD_PREFIX(latency_dump)(file)
+#define CLASSYC_LATENCY_RESET() ADD_PREFIX(latency_reset)()
+#else
+#define CLASSYC_LATENCY_ENTER(histogram_name)
+#define CLASSYC_LATENCY_RAISE(event_name, event_member, raise) raise
+#define CLASSYC_LATENCY_DUMP(file) ((void)0)
+#define CLASSYC_LATENCY_RESET() ((void)0)
+#endif /* CLASSYC_LATENCY */
+
+/* TRACING */
+/* With CLASSYC_TRACE, methods, constructors and destructors (every is_base level of the chain), event handlers and the */
+/* raises of events with handlers record a span (name, start and duration) when they return. Every thread writes its */
+/* spans to its own ring buffer, allocated on its first span and added to a lock-free list: the thread only stores the */
+/* span and publishes it with a release store of the head, with no locks or read-modify-writes. When the buffer is full, */
+/* the oldest spans are overwritten. Every slot is a sequence lock, so a flush skips the spans overwritten meanwhile. */
+/* CLASSYC_TRACE_FLUSH writes the spans not flushed yet as Chrome trace-event JSON, and frees the buffers of the */
+/* threads that have ended. */
+#ifdef CLASSYC_TRACE
+/* Spans per thread, a power of two */
+#ifndef CLASSYC_TRACE_BUFFER_SPANS
+#define CLASSYC_TRACE_BUFFER_SPANS 16384
+#endif
+#if (CLASSYC_TRACE_BUFFER_SPANS & (CLASSYC_TRACE_BUFFER_SPANS - 1)) != 0
+    #error "CLASSYC_TRACE_BUFFER_SPANS must be a power of two"
+#endif
+/* Clock of the spans, in nanoseconds: trace timestamps are absolute times. Define CLASSYC_TRACE_CLOCK() to use another one. */
+#ifndef CLASSYC_TRACE_CLOCK
+static CLASSYC_INLINE uint64_t ADD_PREFIX(trace_clock)(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+#define CLASSYC_TRACE_CLOCK() ADD_PREFIX(trace_clock)()
+#endif
+/* Slot of a span. The thread writes span number n (counted from 0) between two stores of its sequence: 2n + 1 before */
+/* and 2n + 2 after, and a flush only keeps a copy if the sequence is 2n + 2 both before and after it. The members are */
+/* relaxed atomics, as a flush may read them while the thread rewrites them. */
+typedef struct ClassyC_trace_span ClassyC_trace_span;
+struct ClassyC_trace_span {
+    _Atomic uint64_t sequence;
+    _Atomic(const char *) name;       /* "class_name::method_name", "class_name::constructor", "class_name::event_name:handler_ID" or "event_name" */
+    _Atomic(const char *) category;   /* "method", "constructor", "destructor", "handler" or "event" */
+    _Atomic uint64_t start;
+    _Atomic uint64_t duration;
+    atomic_bool is_base;              /* Constructors and destructors run for a derived class */
+};
+/* Ring buffer of a thread */
+typedef struct ClassyC_trace_buffer ClassyC_trace_buffer;
+struct ClassyC_trace_buffer {
+    _Atomic uint64_t head;  /* Spans written by the thread */
+    uint64_t flushed;       /* Spans written when the buffer was last flushed */
+    uint32_t thread_id;
+    atomic_bool ended;      /* Set when the thread ends, after its last span: freed once flushed */
+    ClassyC_trace_buffer *next;
+    ClassyC_trace_span spans[CLASSYC_TRACE_BUFFER_SPANS];
+};
+/* Running span, closed by the cleanup attribute when the function returns */
+typedef struct ClassyC_trace_scope ClassyC_trace_scope;
+struct ClassyC_trace_scope {
+    const char *name;
+    const char *category;
+    bool is_base;
+    uint64_t start;
+};
+/* Buffers of the translation unit, kept after their threads end until their spans are flushed */
+static _Atomic(ClassyC_trace_buffer *) ADD_PREFIX(trace_buffers) = NULL;
+static _Atomic uint32_t ADD_PREFIX(trace_threads) = 0;
+static CLASSYC_THREAD_LOCAL ClassyC_trace_buffer *ADD_PREFIX(trace_thread_buffer) = NULL;
+#if CLASSYC_THREAD_EXIT
+static pthread_key_t ADD_PREFIX(trace_thread_key);
+static pthread_once_t ADD_PREFIX(trace_thread_once) = PTHREAD_ONCE_INIT;
+static bool ADD_PREFIX(trace_thread_key_created) = false;
+/* Destructor of the key, when a thread ends: hand its buffer over to the next flush. A span recorded later by another */
+/* destructor of the thread goes to a new buffer. */
+static void ADD_PREFIX(trace_thread_exit)(void *buffer) {
+    ADD_PREFIX(trace_thread_buffer) = NULL;
+    /* Release the last spans along with the flag */
+    atomic_store_explicit(&((ClassyC_trace_buffer *)buffer)->ended, true, memory_order_release);
+}
+static void ADD_PREFIX(trace_thread_key_create)(void) {
+    ADD_PREFIX(trace_thread_key_created) =
+        pthread_key_create(&ADD_PREFIX(trace_thread_key), ADD_PREFIX(trace_thread_exit)) == 0;
+}
+#endif
+
+/* Allocate the buffer of the calling thread and add it to the list. Returns NULL (spans not recorded) if out of memory. */
+static CLASSYC_INLINE ClassyC_trace_buffer *ADD_PREFIX(trace_register)(void) {
+    ClassyC_trace_buffer *buffer = (ClassyC_trace_buffer *)calloc(1, sizeof(ClassyC_trace_buffer));
+    if (!buffer) {
+        return NULL;
+    }
+    buffer->thread_id = atomic_fetch_add_explicit(&ADD_PREFIX(trace_threads), 1, memory_order_relaxed) + 1;
+    buffer->next = atomic_load_explicit(&ADD_PREFIX(trace_buffers), memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&ADD_PREFIX(trace_buffers), &buffer->next, buffer,
+                                                  memory_order_release, memory_order_relaxed)) {
+    }
+    ADD_PREFIX(trace_thread_buffer) = buffer;
+#if CLASSYC_THREAD_EXIT
+    pthread_once(&ADD_PREFIX(trace_thread_once), ADD_PREFIX(trace_thread_key_create));
+    if (ADD_PREFIX(trace_thread_key_created)) {
+        pthread_setspecific(ADD_PREFIX(trace_thread_key), buffer);
+    }
+#endif
+    return buffer;
+}
+
+static CLASSYC_INLINE void ADD_PREFIX(trace_record)(const char *name, const char *category, bool is_base, uint64_t start, uint64_t end) {
+    ClassyC_trace_buffer *buffer = ADD_PREFIX(trace_thread_buffer);
+    ClassyC_trace_span *span;
+    uint64_t head;
+    if (!buffer && !(buffer = ADD_PREFIX(trace_register)())) {
+        return;
+    }
+    /* Only this thread writes the head and the spans */
+    head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    span = &buffer->spans[head & (CLASSYC_TRACE_BUFFER_SPANS - 1)];
+    atomic_store_explicit(&span->sequence, 2 * head + 1, memory_order_relaxed);
+    /* The odd sequence is visible before any member is changed */
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&span->name, name, memory_order_relaxed);
+    atomic_store_explicit(&span->category, category, memory_order_relaxed);
+    atomic_store_explicit(&span->start, start, memory_order_relaxed);
+    atomic_store_explicit(&span->duration, end - start, memory_order_relaxed);
+    atomic_store_explicit(&span->is_base, is_base, memory_order_relaxed);
+    atomic_store_explicit(&span->sequence, 2 * head + 2, memory_order_release);
+    atomic_store_explicit(&buffer->head, head + 1, memory_order_release);
+}
+
+static CLASSYC_INLINE void ADD_PREFIX(trace_end)(ClassyC_trace_scope *scope) {
+    ADD_PREFIX(trace_record)(scope->name, scope->category, scope->is_base, scope->start, CLASSYC_TRACE_CLOCK());
+}
+
+/* Write the spans recorded since the last flush as a Chrome trace-event JSON document, which loads in Perfetto and */
+/* chrome://tracing. Spans that were overwritten before being flushed are lost. Spans may be recorded meanwhile, but */
+/* flushes must not run concurrently. The buffers of ended threads are freed once flushed, except the first one of the */
+/* list: a new thread may be adding its buffer in front of it (it is freed by a later flush). Returns the number of */
+/* spans written. */
+static CLASSYC_INLINE size_t ADD_PREFIX(trace_flush)(FILE *file) {
+    ClassyC_trace_buffer *first = atomic_load_explicit(&ADD_PREFIX(trace_buffers), memory_order_acquire);
+    ClassyC_trace_buffer *buffer = first, *previous = NULL, *next;
+    size_t written = 0;
+    fprintf(file, "{\"traceEvents\":[");
+    for (; buffer; buffer = next) {
+        /* Read before the head: once the thread has ended, the head is final */
+        bool ended = atomic_load_explicit(&buffer->ended, memory_order_acquire);
+        uint64_t head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+        uint64_t index = buffer->flushed;
+        /* Once the buffer has wrapped around, only the last CLASSYC_TRACE_BUFFER_SPANS spans are left */
+        if (head - index > CLASSYC_TRACE_BUFFER_SPANS) {
+            index = head - CLASSYC_TRACE_BUFFER_SPANS;
+        }
+        for (; index < head; index++) {
+            const ClassyC_trace_span *slot = &buffer->spans[index & (CLASSYC_TRACE_BUFFER_SPANS - 1)];
+            const char *name, *category;
+            uint64_t start, duration;
+            bool is_base;
+            if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != 2 * index + 2) {
+                /* Being overwritten by a newer span */
+                continue;
+            }
+            name = atomic_load_explicit(&slot->name, memory_order_relaxed);
+            category = atomic_load_explicit(&slot->category, memory_order_relaxed);
+            start = atomic_load_explicit(&slot->start, memory_order_relaxed);
+            duration = atomic_load_explicit(&slot->duration, memory_order_relaxed);
+            is_base = atomic_load_explicit(&slot->is_base, memory_order_relaxed);
+            /* Skip the copy if the thread started overwriting the slot meanwhile */
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&slot->sequence, memory_order_relaxed) != 2 * index + 2) {
+                continue;
+            }
+            /* Timestamps and durations in microseconds */
+            fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu.%03u,\"dur\":%llu.%03u,\"pid\":1,\"tid\":%u%s}",
+                    written ? "," : "", name, category,
+                    (unsigned long long)(start / 1000), (unsigned)(start % 1000),
+                    (unsigned long long)(duration / 1000), (unsigned)(duration % 1000),
+                    (unsigned)buffer->thread_id, is_base ? ",\"args\":{\"is_base\":true}" : "");
+            written++;
+        }
+        buffer->flushed = head;
+        next = buffer->next;
+        /* Threads only add buffers in front of the first one: the links after it are only changed here */
+        if (ended && buffer != first) {
+            previous->next = next;
+            free(buffer);
+        } else {
+            previous = buffer;
+        }
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ns\"}\n");
+    return written;
+}
+
+/* First statement of a traced function */
+#define CLASSYC_TRACE_ENTER(span_name, span_category, span_is_base)                                          \
+    ClassyC_trace_scope ADD_PREFIX(trace_scope) __attribute__((__cleanup__(ADD_PREFIX(trace_end)))) = {      \
+        span_name, span_category, span_is_base, CLASSYC_TRACE_CLOCK() };
+/* Trace the raise of an event that has handlers */
+#define CLASSYC_TRACE_RAISE(event_name, event_member, raise)                                                \
+    do {                                                                                                    \
+        if (event_member) {                                                                                 \
+            uint64_t ADD_PREFIX(trace_start) = CLASSYC_TRACE_CLOCK();                                       \
+            raise;                                                                                          \
+            ADD_PREFIX(trace_record)(#event_name, "event", false, ADD_PREFIX(trace_start), CLASSYC_TRACE_CLOCK()); \
+        }                                                                                                   \
+    } while (0)
+/* Write the new spans to a FILE *: CLASSYC_TRACE_FLUSH(file), a complete JSON document on each call */
+#define CLASSYC_TRACE_FLUSH(file) ADD_PREFIX(trace_flush)(file)
+#else
+#define CLASSYC_TRACE_ENTER(span_name, span_category, span_is_base)
+#define CLASSYC_TRACE_RAISE(event_name, event_member, raise) raise
+#define CLASSYC_TRACE_FLUSH(file) ((size_t)0)
+#endif /* CLASSYC_TRACE */
+
+/* BASIC MACROS */
+/* Get the name of the base class from the IMPLEMENTS macro */
+#define WRITE_BASE_NAME(base_to_call)base_to_call
+#define X_GET_BASE_NAME(class) GET_IMPLEMENTS(class)(WRITE_BASE_NAME, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
+
+/* Set the _destructor pointer to the class destructor function */
+/* (constructor pointer not needed, as construction is invoked by NEW_ALLOC or NEW_INPLACE calling the constructor function directly) */
+#define WRITE_SET_DESTRUCTOR_FUNC_POINTER(class_name) \
+    self->_destructor = PREFIXCONCAT(class_name, _destructor); 
+/* Set the _class pointer to the type descriptor of the class (in shared vtable mode, it is in the method table) */
+#ifdef CLASSYC_SHARED_VTABLE
+#define WRITE_SET_CLASS_INFO(class_name)
+#else
+#define WRITE_SET_CLASS_INFO(class_name) \
+    self->_class = &PREFIXCONCAT(class_name, _class_info);
+#endif
+
+/* Clear the event handlers of the class, so they are unregistered even if the object memory was not zeroed */
+#define SET_EVENT_NULL(event_name, ...) \
+    self->event_name = NULL;
+#define WRITE_CLEAR_CLASS_EVENTS(class_name) \
+    GET_IMPLEMENTS(class_name)(WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, SET_EVENT_NULL, WRITE_NOTHING, WRITE_NOTHING)
+/* Free the handler lists of the events of the class on destruction (and the lists they replaced) */
+#define FREE_EVENT_HANDLERS(event_name, ...) \
+    ADD_PREFIX(event_list_free)((void *)self->event_name); \
+    self->event_name = NULL; \
+    RECLAIM_EVENT(self, event_name);
+#define WRITE_FREE_CLASS_EVENTS(class_name) \
+    GET_IMPLEMENTS(class_name)(WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, FREE_EVENT_HANDLERS, WRITE_NOTHING, WRITE_NOTHING)
+
+/* Set the method pointers to the functions of the class */
+/* self is the object being constructed or, in shared vtable mode, the method table being built */
+#define SET_METHOD_PTR(ret_type, method_name, ...) \
+    self->method_name = PREFIXCONCAT(CLASSYC_CLASS_NAME, _##method_name); 
+
+/* Write ALL the interface instances, data members and methods (searching only for new ones) the class implements in the class struct */
+/* by recursively crossing the inheritance tree and creating nested anonymous structs */
+/* In shared vtable mode, method and interface cast pointers are stored in the class method table instead of the object */
+#ifdef CLASSYC_SHARED_VTABLE
+#define WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) \
+        GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_NOTHING, WRITE_DATA_MEMBER, WRITE_EVENT_MEMBER, WRITE_NOTHING, WRITE_NOTHING) \
+
+#else
+#define WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) \
+        GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_INTERFACE_MEMBERS, WRITE_DATA_MEMBER, WRITE_EVENT_MEMBER, WRITE_METHOD_POINTER, WRITE_NOTHING) \
+
+#endif
+
+
+/* Packed classes: the data members of the class itself are written in a packed anonymous struct, with no padding */
+/* They can't implement interfaces: the interface would hand out plain pointers to unaligned members. Interface(...) in */
+/* a packed class declares an array of negative size named after the interface, a compile-time error. */
+#define WRITE_PACKED_INTERFACE_ERROR(interface_name) \
+        char PREFIXCONCAT(interface_name, _cannot_be_implemented_by_a_packed_class)[-1];
+#ifdef __GNUC__
+    #define CLASSYC_PACKED __attribute__((packed))
+#else
+    #define CLASSYC_PACKED
+#endif
+#ifdef CLASSYC_SHARED_VTABLE
+#define WRITE_CLASS_STRUCT_PACKED_MEMBERS(class) \
+        struct CLASSYC_PACKED { GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_NOTHING, WRITE_DATA_MEMBER, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) }; \
+        GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_PACKED_INTERFACE_ERROR, WRITE_NOTHING, WRITE_EVENT_MEMBER, WRITE_NOTHING, WRITE_NOTHING)
+#else
+#define WRITE_CLASS_STRUCT_PACKED_MEMBERS(class) \
+        struct CLASSYC_PACKED { GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_NOTHING, WRITE_DATA_MEMBER, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) }; \
+        GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_PACKED_INTERFACE_ERROR, WRITE_NOTHING, WRITE_EVENT_MEMBER, WRITE_METHOD_POINTER, WRITE_NOTHING)
+#endif
+
+/* Each inheritance level is an anonymous struct, padded to its own alignment. With CLASSYC_FLAT_LAYOUT the members */
+/* of all the levels are written in a single struct: the members of a base class keep their offsets (so the object */
+/* is still a valid object of the base class), but the members of a derived class can use the tail padding of its base */
+/* (stores of a whole base class struct clobber them: C11 6.2.6.1p6 lets them write padding bytes, see the README) */
+#ifdef CLASSYC_FLAT_LAYOUT
+    #define CLASSYC_LEVEL_BEGIN
+    #define CLASSYC_LEVEL_END
+#else
+    #define CLASSYC_LEVEL_BEGIN struct {
+    #define CLASSYC_LEVEL_END } ;
+#endif
+
+#define RECURSIVE_CLASS_MEMBER_DECLARATION_9(class)  \
+    CLASSYC_LEVEL_BEGIN WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) CLASSYC_LEVEL_END 
+#define RECURSIVE_CLASS_MEMBER_DECLARATION_8(class)  \
+    CLASSYC_LEVEL_BEGIN GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_9, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) CLASSYC_LEVEL_END 
+#define RECURSIVE_CLASS_MEMBER_DECLARATION_7(class)  \
+    CLASSYC_LEVEL_BEGIN GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_8, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) CLASSYC_LEVEL_END 
+#define RECURSIVE_CLASS_MEMBER_DECLARATION_6(class)  \
+    CLASSYC_LEVEL_BEGIN GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_7, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) CLASSYC_LEVEL_END 
+#define RECURSIVE_CLASS_MEMBER_DECLARATION_5(class)  \
+    CLASSYC_LEVEL_BEGIN GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_6, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) CLASSYC_LEVEL_END 
+#define RECURSIVE_CLASS_MEMBER_DECLARATION_4(class)  \
+    CLASSYC_LEVEL_BEGIN GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_5, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) CLASSYC_LEVEL_END 
+#define RECURSIVE_CLASS_MEMBER_DECLARATION_3(class)  \
+    CLASSYC_LEVEL_BEGIN GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_4, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) CLASSYC_LEVEL_END 
+#define RECURSIVE_CLASS_MEMBER_DECLARATION_2(class)  \
+    CLASSYC_LEVEL_BEGIN GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_3, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) CLASSYC_LEVEL_END 
+#define RECURSIVE_CLASS_MEMBER_DECLARATION_1(class)  \
+    CLASSYC_LEVEL_BEGIN GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_2, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+             WRITE_CLASS_STRUCT_NESTED_MEMBERS(class) CLASSYC_LEVEL_END 
+/* Sum of the sizes of all the members of a class, to report the padding of its objects */
+#ifdef CLASSYC_SHARED_VTABLE
+#define WRITE_CLASS_MEMBER_SIZES(class) \
+        GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_NOTHING, WRITE_DATA_MEMBER_SIZE, WRITE_EVENT_MEMBER_SIZE, WRITE_NOTHING, WRITE_NOTHING)
+#else
+#define WRITE_CLASS_MEMBER_SIZES(class) \
+        GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_INTERFACE_MEMBERS_SIZE, WRITE_DATA_MEMBER_SIZE, WRITE_EVENT_MEMBER_SIZE, WRITE_METHOD_POINTER_SIZE, WRITE_NOTHING)
+#endif
+#define RECURSIVE_CLASS_MEMBER_SIZES_9(class)  \
+    WRITE_CLASS_MEMBER_SIZES(class) 
+#define RECURSIVE_CLASS_MEMBER_SIZES_8(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_SIZES_9, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_MEMBER_SIZES(class) 
+#define RECURSIVE_CLASS_MEMBER_SIZES_7(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_SIZES_8, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_MEMBER_SIZES(class) 
+#define RECURSIVE_CLASS_MEMBER_SIZES_6(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_SIZES_7, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_MEMBER_SIZES(class) 
+#define RECURSIVE_CLASS_MEMBER_SIZES_5(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_SIZES_6, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_MEMBER_SIZES(class) 
+#define RECURSIVE_CLASS_MEMBER_SIZES_4(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_SIZES_5, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_MEMBER_SIZES(class) 
+#define RECURSIVE_CLASS_MEMBER_SIZES_3(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_SIZES_4, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_MEMBER_SIZES(class) 
+#define RECURSIVE_CLASS_MEMBER_SIZES_2(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_SIZES_3, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_MEMBER_SIZES(class) 
+#define RECURSIVE_CLASS_MEMBER_SIZES_1(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_SIZES_2, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_MEMBER_SIZES(class) 
+#define RECURSIVE_CLASS_MEMBER_SIZES(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_SIZES_1, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_MEMBER_SIZES(class) 
+
+/* The members of the class itself are written by own_members: WRITE_CLASS_STRUCT_NESTED_MEMBERS or, for packed */
+/* classes, WRITE_CLASS_STRUCT_PACKED_MEMBERS */
+#define RECURSIVE_CLASS_MEMBER_DECLARATIONS(class, own_members)  \
+    struct { GET_IMPLEMENTS(class)(RECURSIVE_CLASS_MEMBER_DECLARATION_1, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+             own_members(class) };
+
+/* Macros to count inheritance levels to help with static assertions */
+#define INHERITANCE_LEVEL_1(class) + 1
+#define INHERITANCE_LEVEL_2(class) + 1 GET_IMPLEMENTS(class)(INHERITANCE_LEVEL_1, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
+#define INHERITANCE_LEVEL_3(class) + 1 GET_IMPLEMENTS(class)(INHERITANCE_LEVEL_2, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
+#define INHERITANCE_LEVEL_4(class) + 1 GET_IMPLEMENTS(class)(INHERITANCE_LEVEL_3, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
+#define INHERITANCE_LEVEL_5(class) + 1 GET_IMPLEMENTS(class)(INHERITANCE_LEVEL_4, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
+#define INHERITANCE_LEVEL_6(class) + 1 GET_IMPLEMENTS(class)(INHERITANCE_LEVEL_5, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
+#define INHERITANCE_LEVEL_7(class) + 1 GET_IMPLEMENTS(class)(INHERITANCE_LEVEL_6, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
+#define INHERITANCE_LEVEL_8(class) + 1 GET_IMPLEMENTS(class)(INHERITANCE_LEVEL_7, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
+#define INHERITANCE_LEVEL_9(class) + 1 GET_IMPLEMENTS(class)(INHERITANCE_LEVEL_8, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
+/* Use the appropriate INHERITANCE_LEVEL macro based on the depth */
+#define GET_INHERITANCE_LEVEL(class) ( 0 INHERITANCE_LEVEL_9(class))
+
+/* Ancestors of the type descriptor: base classes and the class itself, each at its inheritance depth */
+#define WRITE_CLASS_ANCESTOR(class) [PREFIXCONCAT(class, _depth)] = &PREFIXCONCAT(class, _class_info),
+#define RECURSIVE_CLASS_ANCESTORS_9(class)  \
+    WRITE_CLASS_ANCESTOR(class) 
+#define RECURSIVE_CLASS_ANCESTORS_8(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_ANCESTORS_9, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_ANCESTOR(class) 
+#define RECURSIVE_CLASS_ANCESTORS_7(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_ANCESTORS_8, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_ANCESTOR(class) 
+#define RECURSIVE_CLASS_ANCESTORS_6(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_ANCESTORS_7, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_ANCESTOR(class) 
+#define RECURSIVE_CLASS_ANCESTORS_5(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_ANCESTORS_6, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_ANCESTOR(class) 
+#define RECURSIVE_CLASS_ANCESTORS_4(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_ANCESTORS_5, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_ANCESTOR(class) 
+#define RECURSIVE_CLASS_ANCESTORS_3(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_ANCESTORS_4, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_ANCESTOR(class) 
+#define RECURSIVE_CLASS_ANCESTORS_2(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_ANCESTORS_3, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_ANCESTOR(class) 
+#define RECURSIVE_CLASS_ANCESTORS_1(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_ANCESTORS_2, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_ANCESTOR(class) 
+#define RECURSIVE_CLASS_ANCESTORS(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_ANCESTORS_1, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_ANCESTOR(class) 
+/* Type descriptor of the class. The depth is counted from the base class, as GET_INHERITANCE_LEVEL stops at 9 levels */
+#define WRITE_CLASS_INFO(class_name)                                                        \
+    /* The first entry is never used: interface ids start at 1 */                          \
+    static const ClassyC_interface_entry PREFIXCONCAT(class_name, _interfaces)[] = {       \
+        { NULL, NULL },                                                                     \
+        RECURSIVE_INTERFACE_ENTRIES(class_name)                                             \
+    };                                                                                      \
+    enum { PREFIXCONCAT(class_name, _depth) = PREFIXCONCAT(X_GET_BASE_NAME(class_name), _depth) + 1, \
+           PREFIXCONCAT(class_name, _uid) = CLASSYC_NEXT_CLASS_UID };                       \
+    /* Statistics of the objects of the class (only with CLASSYC_STATS) */                 \
+    WRITE_CLASS_STATS(class_name)                                                           \
+    static const ClassyC_class_info PREFIXCONCAT(class_name, _class_info) = {              \
+        QUOTE(class_name), sizeof(class_name),                                              \
+        sizeof(class_name) - (0 RECURSIVE_CLASS_MEMBER_SIZES(class_name)), PREFIXCONCAT(class_name, _depth), \
+        { RECURSIVE_CLASS_ANCESTORS(class_name) },                                          \
+        PREFIXCONCAT(class_name, _interfaces), CLASSYC_INTERFACE_COUNT(class_name),         \
+        &ADD_PREFIX(translation_unit), PREFIXCONCAT(class_name, _uid)                       \
+        WRITE_CLASS_INFO_STATS(class_name)                                                  \
+    };
+
+/* New and overridden method function prototypes */
+#define WRITE_METHOD_FUNC_PROTOTYPE(ret_type, method_name, ...) \
+    static CLASSYC_INLINE ret_type PREFIXCONCAT(CLASSYC_CLASS_NAME, _##method_name)(void *self_void WITHOUT_COMMA(__VA_ARGS__)); 
+#define X_METHOD_FUNC_PROTOTYPES(class_name) \
+    /* Writes the method prototypes for the class: new methods and overridden methods */ \
+    GET_IMPLEMENTS(class_name)(WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_METHOD_FUNC_PROTOTYPE, WRITE_METHOD_FUNC_PROTOTYPE) 
+
+
+/* INTERFACES */
+/* Macros to create interface structs with its members on CREATE_INTERFACE */
+/* Method pointer declaration in the interface struct */
+#define WRITE_I_METHOD_PTR(ret_type, method_name, ...) \
+    ret_type (*method_name)(void *self_void WITHOUT_COMMA(__VA_ARGS__));
+/* Data member pointerdeclaration in the interface struct */
+#define WRITE_I_DATA_MEMBER(type, member_name) \
+    /* A pointer to the data member */\
+    type *member_name;
+/* Event pointer (to the handler list pointer) declaration in the interface struct */
+#define WRITE_I_EVENT_MEMBER(event_name, ...) \
+    /* Not a pointer to the handler list, but a pointer to the object member pointing to it */\
+    /* That way, if event handlers are subscribed later (and the list moves), we don't have to reassign the pointer */\
+    void (** CLASSYC_EVENT_QUALIFIER *event_name)(void *self_void WITHOUT_COMMA(__VA_ARGS__));
+/* Write the interface struct members */
+#define WRITE_INTERFACE_STRUCT(interface_name) \
+    GET_INTERFACE(interface_name)(WRITE_I_DATA_MEMBER, WRITE_I_EVENT_MEMBER, WRITE_I_METHOD_PTR)
+/* Offsets of the data members and events in the interface descriptor */
+#define WRITE_I_DESC_OFFSET(type, member_name) size_t member_name;
+#define WRITE_I_DESC_EVENT_OFFSET(event_name, ...) size_t event_name;
+/* Methods are the addresses of their slots in the static method table of the class, so descriptors are constant */
+#define WRITE_I_DESC_METHOD_SLOT(ret_type, method_name, ...) \
+    ret_type (*const *method_name)(void *self_void WITHOUT_COMMA(__VA_ARGS__));
+/* Interface struct definition */
+/* Also defines the interface descriptor (offsets of the members and method slots of a class, one per class) */
+/* and the interface reference: the object and its class descriptor, see INTERFACE_REF */
+#define CREATE_INTERFACE(interface_name)         \
+   typedef struct interface_name interface_name; \
+   struct interface_name {                       \
+       void *self;                               \
+       WRITE_INTERFACE_STRUCT(interface_name)    \
+   };                                            \
+   STRUCT_HEADER(PREFIXCONCAT(interface_name, _desc)) { \
+       const ClassyC_class_info *_class;         \
+       GET_INTERFACE(interface_name)(WRITE_I_DESC_OFFSET, WRITE_I_DESC_EVENT_OFFSET, WRITE_I_DESC_METHOD_SLOT) \
+   };                                            \
+   STRUCT_HEADER(CONCAT(interface_name, _ref)) { \
+       void *self;                               \
+       const PREFIXCONCAT(interface_name, _desc) *desc; \
+   };                                            \
+   static const ClassyC_interface_info PREFIXCONCAT(interface_name, _interface_info) CLASSYC_MAYBE_UNUSED = { QUOTE(interface_name) }; \
+   enum { PREFIXCONCAT(interface_name, _interface_id) = CLASSYC_NEXT_INTERFACE_ID };
+
+
+/* Interface pointer initializers to fill the interface struct with pointers to the class members */
+#define WRITE_I_METHOD_PTR_INITIALIZER(ret_type, method_name, ...) \
+    /* Copies the method pointer to the interface */\
+    .method_name = GET_METHOD_PTR(self, method_name),
+#define WRITE_I_DATA_MEMBER_INITIALIZER(type, member_name) \
+    /* Copies the pointer to the data member to the interface */\
+    .member_name = &self->member_name,
+#define WRITE_I_EVENT_MEMBER_INITIALIZER(event_name, ...) \
+    /* Stores the address of the function pointer in the interface */\
+    .event_name = &self->event_name,
+
+/* INTERFACE CAST FUNCTIONS in the form class_name_to_interface_name */
+/* and the declaration of the interface descriptor of the class, defined after its static method table */
+#define WRITE_INTERFACE_CAST_FUNCTION(interface_name) \
+    static const PREFIXCONCAT(interface_name, _desc) ADD_PREFIX(TRICAT(CLASSYC_CLASS_NAME, _desc_, interface_name)); \
+    static CLASSYC_INLINE interface_name TRICAT(CLASSYC_CLASS_NAME, _to_, interface_name)(void *self_void) { \
+        CLASSYC_CLASS_NAME *self = (CLASSYC_CLASS_NAME *)self_void;                    \
+        interface_name interface_struct;                                               \
+        interface_struct = (interface_name){                                           \
+            GET_INTERFACE(interface_name)(WRITE_I_DATA_MEMBER_INITIALIZER, WRITE_I_EVENT_MEMBER_INITIALIZER, WRITE_I_METHOD_PTR_INITIALIZER) \
+            .self = self                                                               \
+        };                                                                             \
+        return interface_struct;                                                       \
+    }
+#define WRITE_CLASS_INTERFACE_CAST_FUNCTIONS(class) \
+    GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_INTERFACE_CAST_FUNCTION, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+
+#define RECURSIVE_INTERFACE_CAST_FUNCTIONS_9(class)  \
     WRITE_CLASS_INTERFACE_CAST_FUNCTIONS(class) 
 #define RECURSIVE_INTERFACE_CAST_FUNCTIONS_8(class)  \
     GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_CAST_FUNCTIONS_9, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
@@ -603,9 +2451,46 @@ static CLASSYC_INLINE void PREFIXCONCAT(OBJECT, _user_destructor)(bool is_base,
     GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_CAST_FUNCTIONS_1, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
     WRITE_CLASS_INTERFACE_CAST_FUNCTIONS(class) 
 
+/* INTERFACE TABLES */
+/* Entries of the interface table of the class: every interface of the class and its base classes, at their ids */
+#define WRITE_INTERFACE_ENTRY(interface_name) \
+    CLASSYC_INTERFACE_SLOT(interface_name) { &PREFIXCONCAT(interface_name, _interface_info), &ADD_PREFIX(TRICAT(CLASSYC_CLASS_NAME, _desc_, interface_name)) },
+#define WRITE_CLASS_INTERFACE_ENTRIES(class) \
+    GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_INTERFACE_ENTRY, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) 
+#define RECURSIVE_INTERFACE_ENTRIES_9(class)  \
+    WRITE_CLASS_INTERFACE_ENTRIES(class) 
+#define RECURSIVE_INTERFACE_ENTRIES_8(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_ENTRIES_9, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_ENTRIES(class) 
+#define RECURSIVE_INTERFACE_ENTRIES_7(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_ENTRIES_8, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_ENTRIES(class) 
+#define RECURSIVE_INTERFACE_ENTRIES_6(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_ENTRIES_7, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_ENTRIES(class) 
+#define RECURSIVE_INTERFACE_ENTRIES_5(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_ENTRIES_6, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_ENTRIES(class) 
+#define RECURSIVE_INTERFACE_ENTRIES_4(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_ENTRIES_5, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_ENTRIES(class) 
+#define RECURSIVE_INTERFACE_ENTRIES_3(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_ENTRIES_4, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_ENTRIES(class) 
+#define RECURSIVE_INTERFACE_ENTRIES_2(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_ENTRIES_3, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_ENTRIES(class) 
+#define RECURSIVE_INTERFACE_ENTRIES_1(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_ENTRIES_2, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_ENTRIES(class) 
+#define RECURSIVE_INTERFACE_ENTRIES(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_ENTRIES_1, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_ENTRIES(class) 
+
 /* REGISTER INTERFACE CAST FUNCTIONS */
 #define WRITE_REGISTER_INTERFACE_CAST_FUNCTION(interface_name) \
-    self->CONCAT(to_, interface_name) = TRICAT(CLASSYC_CLASS_NAME, _to_, interface_name);
+    self->CONCAT(to_, interface_name) = TRICAT(CLASSYC_CLASS_NAME, _to_, interface_name); \
+    self->CONCAT(_desc_, interface_name) = &ADD_PREFIX(TRICAT(CLASSYC_CLASS_NAME, _desc_, interface_name));
 #define WRITE_CLASS_REGISTER_INTERFACE_CAST_FUNCTIONS(class)  \
     GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_REGISTER_INTERFACE_CAST_FUNCTION, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) 
 #define RECURSIVE_REGISTER_INTERFACE_CAST_FUNCTIONS_9(class)  \
@@ -640,39 +2525,264 @@ static CLASSYC_INLINE void PREFIXCONCAT(OBJECT, _user_destructor)(bool is_base,
 
 
 
+/* SHARED VTABLE MODE */
+/* Write the interface cast and method pointers of the class method table by recursively crossing the inheritance tree. */
+/* Members are written flat, base class members first, so the table of a base class is a prefix of the table of a derived class */
+#define WRITE_CLASS_VTABLE_MEMBERS(class) \
+        GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_INTERFACE_MEMBERS, WRITE_NOTHING, WRITE_NOTHING, WRITE_METHOD_POINTER, WRITE_NOTHING)
+#define RECURSIVE_VTABLE_MEMBER_DECLARATION_9(class)  \
+    WRITE_CLASS_VTABLE_MEMBERS(class) 
+#define RECURSIVE_VTABLE_MEMBER_DECLARATION_8(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_VTABLE_MEMBER_DECLARATION_9, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_VTABLE_MEMBERS(class) 
+#define RECURSIVE_VTABLE_MEMBER_DECLARATION_7(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_VTABLE_MEMBER_DECLARATION_8, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_VTABLE_MEMBERS(class) 
+#define RECURSIVE_VTABLE_MEMBER_DECLARATION_6(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_VTABLE_MEMBER_DECLARATION_7, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_VTABLE_MEMBERS(class) 
+#define RECURSIVE_VTABLE_MEMBER_DECLARATION_5(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_VTABLE_MEMBER_DECLARATION_6, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_VTABLE_MEMBERS(class) 
+#define RECURSIVE_VTABLE_MEMBER_DECLARATION_4(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_VTABLE_MEMBER_DECLARATION_5, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_VTABLE_MEMBERS(class) 
+#define RECURSIVE_VTABLE_MEMBER_DECLARATION_3(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_VTABLE_MEMBER_DECLARATION_4, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_VTABLE_MEMBERS(class) 
+#define RECURSIVE_VTABLE_MEMBER_DECLARATION_2(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_VTABLE_MEMBER_DECLARATION_3, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_VTABLE_MEMBERS(class) 
+#define RECURSIVE_VTABLE_MEMBER_DECLARATION_1(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_VTABLE_MEMBER_DECLARATION_2, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_VTABLE_MEMBERS(class) 
+#define RECURSIVE_VTABLE_MEMBER_DECLARATIONS(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_VTABLE_MEMBER_DECLARATION_1, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_VTABLE_MEMBERS(class) 
+
+/* Method table type of a class. It is declared in every mode, as it is also the type of the static table (see CALL_STATIC) */
+/* Every table starts with the members of ClassyC_vtable_header: the size of the objects and the type descriptor of the class */
+#define GET_VTABLE_TYPE(class_name) PREFIXCONCAT(class_name, _vtable)
+#define WRITE_CLASS_VTABLE_TYPE(class_name)                                                 \
+    STRUCT_HEADER(GET_VTABLE_TYPE(class_name)) {                                            \
+        size_t _size;                                                                       \
+        const ClassyC_class_info *_class;                                                   \
+        RECURSIVE_VTABLE_MEMBER_DECLARATIONS(class_name)                                    \
+    };
+
+#define WRITE_CLASS_VTABLE(class_name) WRITE_CLASS_VTABLE_TYPE(class_name)
+
+#ifdef CLASSYC_SHARED_VTABLE
+    /* The _vt member overlaps the _vtable pointer of OBJECT, giving it the type of the method table of the class */
+    #define WRITE_CLASS_STRUCT_MEMBERS(class_name, own_members)                             \
+        union {                                                                             \
+            const GET_VTABLE_TYPE(class_name) *_vt;                                         \
+            RECURSIVE_CLASS_MEMBER_DECLARATIONS(class_name, own_members)                    \
+        };
+    /* The method table shared by all the objects of the class is its constant static method table: only its address */
+    /* is stored in every object, and there is nothing to build at runtime */
+    #define WRITE_SET_CLASS_METHODS(class_name)                                             \
+        self->_vt = &PREFIXCONCAT(class_name, _static_vtable);
+#else
+    #define WRITE_CLASS_STRUCT_MEMBERS(class_name, own_members)                             \
+        RECURSIVE_CLASS_MEMBER_DECLARATIONS(class_name, own_members)
+    /* Set method pointers to the functions of the class */
+    /* as constructors are executed in the order of inheritance, overridden methods are set last */
+    #define WRITE_SET_CLASS_METHODS(class_name)                                             \
+        GET_IMPLEMENTS(class_name)(WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, SET_METHOD_PTR, SET_METHOD_PTR) \
+        /* Register interface cast functions */                                             \
+        RECURSIVE_REGISTER_INTERFACE_CAST_FUNCTIONS(class_name)
+#endif
+
+
+/* LISTS */
+/* Apply macro(fixed, item) to every item of a list, with no limit on the number of items: CLASSYC_FOR_EACH(macro, fixed, items) */
+/* The items are written with CLASSYC_LIST_ITEM(item), usually as the callback of an x-macro: each item closes the */
+/* invocation of the walker that handles it and opens the next one, so the walker never counts the items. */
+#define CLASSYC_LIST_ITEM(...) (__VA_ARGS__) )
+#define CLASSYC_UNPACK(...) __VA_ARGS__
+#define CLASSYC_SECOND(first, second, ...) second
+#define CLASSYC_SECOND_APPLY(args) CLASSYC_SECOND args
+/* 1 for a (parenthesized) item, 0 for the end of the list */
+#define CLASSYC_PAREN_PROBE(...) ~, 1
+#define CLASSYC_IS_LIST_ITEM(item) CLASSYC_SECOND_APPLY((CLASSYC_PAREN_PROBE item, 0, ~))
+/* Two walkers take turns, as a macro is not expanded again inside its own expansion */
+#define CLASSYC_FOR_EACH_A(macro, fixed, item) CONCAT(CLASSYC_FOR_EACH_A_, CLASSYC_IS_LIST_ITEM(item))(macro, fixed, item)
+#define CLASSYC_FOR_EACH_A_0(macro, fixed, item)
+#define CLASSYC_FOR_EACH_A_1(macro, fixed, item) macro(fixed, item) CLASSYC_FOR_EACH_B(macro, fixed,
+#define CLASSYC_FOR_EACH_B(macro, fixed, item) CONCAT(CLASSYC_FOR_EACH_B_, CLASSYC_IS_LIST_ITEM(item))(macro, fixed, item)
+#define CLASSYC_FOR_EACH_B_0(macro, fixed, item)
+#define CLASSYC_FOR_EACH_B_1(macro, fixed, item) macro(fixed, item) CLASSYC_FOR_EACH_A(macro, fixed,
+#define CLASSYC_FOR_EACH(macro, fixed, items) CLASSYC_FOR_EACH_A(macro, fixed, items CLASSYC_LIST_END)
+/* A second pair of walkers, for the lists walked by the callbacks of CLASSYC_FOR_EACH */
+#define CLASSYC_FOR_EACH_C(macro, fixed, item) CONCAT(CLASSYC_FOR_EACH_C_, CLASSYC_IS_LIST_ITEM(item))(macro, fixed, item)
+#define CLASSYC_FOR_EACH_C_0(macro, fixed, item)
+#define CLASSYC_FOR_EACH_C_1(macro, fixed, item) macro(fixed, item) CLASSYC_FOR_EACH_D(macro, fixed,
+#define CLASSYC_FOR_EACH_D(macro, fixed, item) CONCAT(CLASSYC_FOR_EACH_D_, CLASSYC_IS_LIST_ITEM(item))(macro, fixed, item)
+#define CLASSYC_FOR_EACH_D_0(macro, fixed, item)
+#define CLASSYC_FOR_EACH_D_1(macro, fixed, item) macro(fixed, item) CLASSYC_FOR_EACH_C(macro, fixed,
+#define CLASSYC_FOR_EACH_NESTED(macro, fixed, items) CLASSYC_FOR_EACH_C(macro, fixed, items CLASSYC_LIST_END)
+
+/* STATIC METHOD TABLES */
+/* Every class has a constant method table, filled at compile time with the functions of the class: calls through it */
+/* (see CALL_STATIC) are direct calls that the compiler can inline. Methods are written base class first, so the */
+/* initializer of an overridden method comes after the one of the base class and wins */
+/* The Method and Override entries only give the method names, so the names of each class of the inheritance tree */
+/* are collected first and then prefixed with the class that implements them */
+#define WRITE_METHOD_NAME(ret_type, method_name, ...) CLASSYC_LIST_ITEM(method_name)
+#define WRITE_STATIC_METHOD_INITIALIZER(class, method_item) \
+    .CLASSYC_UNPACK method_item = PREFIXCONCAT(class, CONCAT(_, CLASSYC_UNPACK method_item)),
+/* Interface casts and descriptors are the ones of the class being defined */
+#define WRITE_STATIC_INTERFACE_INITIALIZER(interface_name)                                  \
+    .CONCAT(to_, interface_name) = TRICAT(CLASSYC_CLASS_NAME, _to_, interface_name),        \
+    .CONCAT(_desc_, interface_name) = &ADD_PREFIX(TRICAT(CLASSYC_CLASS_NAME, _desc_, interface_name)),
+#define WRITE_CLASS_STATIC_VTABLE_INITIALIZERS(class)                                       \
+    GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_STATIC_INTERFACE_INITIALIZER, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    CLASSYC_FOR_EACH(WRITE_STATIC_METHOD_INITIALIZER, class, GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_METHOD_NAME, WRITE_METHOD_NAME))
+#define RECURSIVE_STATIC_VTABLE_INITIALIZERS_9(class)  \
+    WRITE_CLASS_STATIC_VTABLE_INITIALIZERS(class) 
+#define RECURSIVE_STATIC_VTABLE_INITIALIZERS_8(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_STATIC_VTABLE_INITIALIZERS_9, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_STATIC_VTABLE_INITIALIZERS(class) 
+#define RECURSIVE_STATIC_VTABLE_INITIALIZERS_7(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_STATIC_VTABLE_INITIALIZERS_8, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_STATIC_VTABLE_INITIALIZERS(class) 
+#define RECURSIVE_STATIC_VTABLE_INITIALIZERS_6(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_STATIC_VTABLE_INITIALIZERS_7, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_STATIC_VTABLE_INITIALIZERS(class) 
+#define RECURSIVE_STATIC_VTABLE_INITIALIZERS_5(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_STATIC_VTABLE_INITIALIZERS_6, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_STATIC_VTABLE_INITIALIZERS(class) 
+#define RECURSIVE_STATIC_VTABLE_INITIALIZERS_4(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_STATIC_VTABLE_INITIALIZERS_5, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_STATIC_VTABLE_INITIALIZERS(class) 
+#define RECURSIVE_STATIC_VTABLE_INITIALIZERS_3(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_STATIC_VTABLE_INITIALIZERS_4, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_STATIC_VTABLE_INITIALIZERS(class) 
+#define RECURSIVE_STATIC_VTABLE_INITIALIZERS_2(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_STATIC_VTABLE_INITIALIZERS_3, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_STATIC_VTABLE_INITIALIZERS(class) 
+#define RECURSIVE_STATIC_VTABLE_INITIALIZERS_1(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_STATIC_VTABLE_INITIALIZERS_2, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_STATIC_VTABLE_INITIALIZERS(class) 
+#define RECURSIVE_STATIC_VTABLE_INITIALIZERS(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_STATIC_VTABLE_INITIALIZERS_1, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_STATIC_VTABLE_INITIALIZERS(class) 
+/* Overridden methods are initialized twice on purpose */
+#ifdef __GNUC__
+    #define CLASSYC_OVERRIDE_INIT_BEGIN _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Woverride-init\"")
+    #define CLASSYC_OVERRIDE_INIT_END _Pragma("GCC diagnostic pop")
+#else
+    #define CLASSYC_OVERRIDE_INIT_BEGIN
+    #define CLASSYC_OVERRIDE_INIT_END
+#endif
+#define WRITE_CLASS_STATIC_VTABLE(class_name)                                               \
+    CLASSYC_OVERRIDE_INIT_BEGIN                                                             \
+    static const GET_VTABLE_TYPE(class_name) PREFIXCONCAT(class_name, _static_vtable) CLASSYC_MAYBE_UNUSED = { \
+        sizeof(class_name), &PREFIXCONCAT(class_name, _class_info),                         \
+        RECURSIVE_STATIC_VTABLE_INITIALIZERS(class_name)                                    \
+    };                                                                                      \
+    CLASSYC_OVERRIDE_INIT_END
+
+/* INTERFACE DESCRIPTORS */
+/* The descriptors of the class are constant: offsets in the class struct and the method slots of its static method table */
+#define WRITE_I_DESC_OFFSET_INITIALIZER(type, member_name) \
+    .member_name = offsetof(CLASSYC_CLASS_NAME, member_name),
+#define WRITE_I_DESC_EVENT_OFFSET_INITIALIZER(event_name, ...) \
+    .event_name = offsetof(CLASSYC_CLASS_NAME, event_name),
+#define WRITE_I_DESC_METHOD_INITIALIZER(ret_type, method_name, ...) \
+    .method_name = &PREFIXCONCAT(CLASSYC_CLASS_NAME, _static_vtable).method_name,
+#define WRITE_INTERFACE_DESCRIPTOR(interface_name) \
+    static const PREFIXCONCAT(interface_name, _desc) ADD_PREFIX(TRICAT(CLASSYC_CLASS_NAME, _desc_, interface_name)) = { \
+        GET_INTERFACE(interface_name)(WRITE_I_DESC_OFFSET_INITIALIZER, WRITE_I_DESC_EVENT_OFFSET_INITIALIZER, WRITE_I_DESC_METHOD_INITIALIZER) \
+        ._class = &PREFIXCONCAT(CLASSYC_CLASS_NAME, _class_info)                            \
+    };
+#define WRITE_CLASS_INTERFACE_DESCRIPTORS(class) \
+    GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_INTERFACE_DESCRIPTOR, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) 
+#define RECURSIVE_INTERFACE_DESCRIPTORS_9(class)  \
+    WRITE_CLASS_INTERFACE_DESCRIPTORS(class) 
+#define RECURSIVE_INTERFACE_DESCRIPTORS_8(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_DESCRIPTORS_9, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_DESCRIPTORS(class) 
+#define RECURSIVE_INTERFACE_DESCRIPTORS_7(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_DESCRIPTORS_8, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_DESCRIPTORS(class) 
+#define RECURSIVE_INTERFACE_DESCRIPTORS_6(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_DESCRIPTORS_7, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_DESCRIPTORS(class) 
+#define RECURSIVE_INTERFACE_DESCRIPTORS_5(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_DESCRIPTORS_6, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_DESCRIPTORS(class) 
+#define RECURSIVE_INTERFACE_DESCRIPTORS_4(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_DESCRIPTORS_5, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_DESCRIPTORS(class) 
+#define RECURSIVE_INTERFACE_DESCRIPTORS_3(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_DESCRIPTORS_4, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_DESCRIPTORS(class) 
+#define RECURSIVE_INTERFACE_DESCRIPTORS_2(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_DESCRIPTORS_3, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_DESCRIPTORS(class) 
+#define RECURSIVE_INTERFACE_DESCRIPTORS_1(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_DESCRIPTORS_2, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_DESCRIPTORS(class) 
+#define RECURSIVE_INTERFACE_DESCRIPTORS(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_INTERFACE_DESCRIPTORS_1, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_INTERFACE_DESCRIPTORS(class) 
 /* CONSTRUCTOR, DESTRUCTOR, INIT... */
 /* Initialize the base class: call this within the 'CONSTRUCTOR' of the derived class to run the 'CONSTRUCTOR' of the base class. */
 #define INIT_BASE(...) \
-    PREFIXCONCAT(X_GET_BASE_NAME(CLASSYC_CLASS_NAME), _user_constructor)(IS_BASE_TRUE, self WITHOUT_COMMA(__VA_ARGS__))
+    PREFIXCONCAT(X_GET_BASE_NAME(CLASSYC_CLASS_NAME), _user_constructor)(IS_BASE_TRUE, self, CLASSYC_MEMORY_INPLACE WITHOUT_COMMA(__VA_ARGS__))
 
 /* Constructor macro, this is where most of the logic for class definition is implemented */
-#define CONSTRUCTOR(...)\
+#define CONSTRUCTOR(...) CLASSYC_CONSTRUCTOR(WRITE_CLASS_STRUCT_NESTED_MEMBERS, __VA_ARGS__)
+/* Constructor of a packed class: its own data members are packed, with no padding between them (GCC and Clang). */
+/* A packed class can't be a base class, as its derived classes would not know the layout: it is SEALED */
+#define PACKED_CONSTRUCTOR(...) SEALED() CLASSYC_CONSTRUCTOR(WRITE_CLASS_STRUCT_PACKED_MEMBERS, __VA_ARGS__)
+#define CLASSYC_CONSTRUCTOR(own_members, ...)\
     /* Compile-time assertion (available in C11 and later) to ensure the inheritance depth does not exceed the maximum limit */ \
     CLASSYC_CHECK_INHERITANCE_DEPTH_CT                                  \
+    /* Compile-time error if the base class is SEALED */                \
+    CLASSYC_CHECK_BASE_NOT_SEALED                                       \
+    /* Compile-time error if a method has the name of a final method of a base class */ \
+    CLASSYC_CHECK_METHODS_NOT_FINAL                                     \
+    /* Declare the class method table type */                           \
+    WRITE_CLASS_VTABLE(CLASSYC_CLASS_NAME)                              \
+    /* Declare the class memory pool (only with CLASSYC_ENABLE_POOLS) */ \
+    WRITE_CLASS_POOL(CLASSYC_CLASS_NAME)                                \
+    /* Declare the offset of the class cold block (0 unless COLD_BLOCK defines it) */ \
+    WRITE_CLASS_COLD_OFFSET(CLASSYC_CLASS_NAME)                         \
     /* Declare the class struct */                                      \
-    STRUCT_HEADER(CLASSYC_CLASS_NAME) {                                 \
+    OBJECT_STRUCT_HEADER(CLASSYC_CLASS_NAME) {                          \
         /* Include all the members of the class struct */               \
-        RECURSIVE_CLASS_MEMBER_DECLARATIONS(CLASSYC_CLASS_NAME)         \
+        WRITE_CLASS_STRUCT_MEMBERS(CLASSYC_CLASS_NAME, own_members)     \
     } ;                                                                 \
     /* Prototypes for the destructor and constructor class functions */ \
     static CLASSYC_INLINE void PREFIXCONCAT(CLASSYC_CLASS_NAME, _destructor)(void *self_void); \
     static CLASSYC_INLINE void PREFIXCONCAT(CLASSYC_CLASS_NAME, _ptr_destructor)(CLASSYC_CLASS_NAME **self_ptr); \
     static CLASSYC_INLINE void PREFIXCONCAT(CLASSYC_CLASS_NAME, _user_destructor)(bool is_base, void *self_void); \
-    static CLASSYC_INLINE void * PREFIXCONCAT(CLASSYC_CLASS_NAME, _constructor)(void *self_void); \
-    static CLASSYC_INLINE void * PREFIXCONCAT(CLASSYC_CLASS_NAME, _user_constructor)(bool is_base, void *self_void WITHOUT_COMMA(__VA_ARGS__)); \
+    static CLASSYC_INLINE void * PREFIXCONCAT(CLASSYC_CLASS_NAME, _constructor)(void *self_void, ClassyC_memory memory); \
+    static CLASSYC_INLINE void * PREFIXCONCAT(CLASSYC_CLASS_NAME, _array_constructor)(void *array, size_t count); \
+    static CLASSYC_INLINE void * PREFIXCONCAT(CLASSYC_CLASS_NAME, _user_constructor)(bool is_base, void *self_void, ClassyC_memory memory WITHOUT_COMMA(__VA_ARGS__)); \
     /* Write the prototypes for new and overridden methods */           \
     X_METHOD_FUNC_PROTOTYPES(CLASSYC_CLASS_NAME)                        \
     /* Interface cast functions */                                      \
     RECURSIVE_INTERFACE_CAST_FUNCTIONS(CLASSYC_CLASS_NAME)              \
+    /* Define the class type descriptor and interface table */          \
+    WRITE_CLASS_INFO(CLASSYC_CLASS_NAME)                                \
+    /* Constant method table for static calls */                        \
+    WRITE_CLASS_STATIC_VTABLE(CLASSYC_CLASS_NAME)                       \
+    /* Interface descriptors of the class, used by INTERFACE_REF */     \
+    RECURSIVE_INTERFACE_DESCRIPTORS(CLASSYC_CLASS_NAME)                 \
     /* Constructor function */                                          \
-    static CLASSYC_INLINE void* PREFIXCONCAT(CLASSYC_CLASS_NAME, _constructor)(void * self_void) { \
+    static CLASSYC_INLINE void* PREFIXCONCAT(CLASSYC_CLASS_NAME, _constructor)(void * self_void, ClassyC_memory memory) { \
         /* This function is used to allocate memory for the object (if needed) and set its basic function and method pointers */ \
         /* Runtime check for inheritance depth: disable by defining CLASSYC_DISABLE_RUNTIME_CHECKS */ \
         CLASSYC_CHECK_INHERITANCE_DEPTH                                 \
         CLASSYC_CLASS_NAME *self = (CLASSYC_CLASS_NAME *)self_void;     \
         if (self_void == NULL) {                                        \
-            /* No object pointer provided: allocate memory for the object in the heap */ \
-            self = (CLASSYC_CLASS_NAME *)calloc(1, sizeof(CLASSYC_CLASS_NAME)); \
+            /* No object pointer provided: allocate memory for the object in the heap (or the class pool) */ \
+            self = (CLASSYC_CLASS_NAME *)(memory == CLASSYC_MEMORY_ALLOC_NOZERO ? \
+                CLASSYC_ALLOC_OBJECT_NOZERO(CLASSYC_CLASS_NAME) : CLASSYC_ALLOC_OBJECT(CLASSYC_CLASS_NAME)); \
             self_void = self;                                           \
             if (self == NULL) {                                         \
                 /* Allocation failure */                                \
@@ -683,25 +2793,52 @@ static CLASSYC_INLINE void PREFIXCONCAT(OBJECT, _user_destructor)(bool is_base,
             self = (CLASSYC_CLASS_NAME *)self_void;                     \
         }                                                               \
         /* Call the base class constructor */                           \
-        PREFIXCONCAT(X_GET_BASE_NAME(CLASSYC_CLASS_NAME), _constructor)(self); \
+        PREFIXCONCAT(X_GET_BASE_NAME(CLASSYC_CLASS_NAME), _constructor)(self, memory); \
         /* Set destructor pointer to the class destructor function */   \
         WRITE_SET_DESTRUCTOR_FUNC_POINTER(CLASSYC_CLASS_NAME)           \
-        /* Set method pointers to the functions of the class */         \
-        /* as constructors are executed in the order of inheritance, overridden methods are set last */ \
-        GET_IMPLEMENTS(CLASSYC_CLASS_NAME)(WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, SET_METHOD_PTR, SET_METHOD_PTR) \
-        /* Register interface cast functions */                         \
-        RECURSIVE_REGISTER_INTERFACE_CAST_FUNCTIONS(CLASSYC_CLASS_NAME) \
+        /* Set the type descriptor pointer to the class descriptor */   \
+        WRITE_SET_CLASS_INFO(CLASSYC_CLASS_NAME)                        \
+        /* Set the method and interface cast pointers (or the method table pointer) */ \
+        WRITE_SET_CLASS_METHODS(CLASSYC_CLASS_NAME)                     \
+        /* Clear the event handlers of the class */                     \
+        WRITE_CLEAR_CLASS_EVENTS(CLASSYC_CLASS_NAME)                    \
+        /* Clear the cold block pointer of the class */                 \
+        WRITE_CLEAR_CLASS_COLD(CLASSYC_CLASS_NAME)                      \
         return self;                                                    \
     }                                                                   \
+    /* Array constructor function: sets the framework members of the elements of a NEW_ARRAY array */ \
+    static CLASSYC_INLINE void* PREFIXCONCAT(CLASSYC_CLASS_NAME, _array_constructor)(void *array, size_t count) { \
+        if (!array) {                                                   \
+            /* Failure allocating the array */                          \
+            return NULL;                                                \
+        }                                                               \
+        /* Set the members of the first element and copy them to the rest */ \
+        PREFIXCONCAT(CLASSYC_CLASS_NAME, _constructor)(array, CLASSYC_MEMORY_INPLACE); \
+        ADD_PREFIX(array_replicate)(array, count, sizeof(CLASSYC_CLASS_NAME)); \
+        /* Count the objects in the statistics of the class (only with CLASSYC_STATS) */ \
+        CLASSYC_STATS_CONSTRUCT(CLASSYC_CLASS_NAME, true, count)        \
+        return array;                                                   \
+    }                                                                   \
     /* User constructor function */                                     \
-    static CLASSYC_INLINE void* PREFIXCONCAT(CLASSYC_CLASS_NAME, _user_constructor)(bool is_base, void * self_void WITHOUT_COMMA(__VA_ARGS__)) { \
-        if (!is_base) {                                                 \
+    /* memory tells who allocates the object, see ClassyC_memory */     \
+    static CLASSYC_INLINE void* PREFIXCONCAT(CLASSYC_CLASS_NAME, _user_constructor)(bool is_base, void * self_void, ClassyC_memory memory WITHOUT_COMMA(__VA_ARGS__)) { \
+        CLASSYC_PROFILE_ENTER(CLASSYC_CLASS_NAME, "constructor")        \
+        CLASSYC_TRACE_ENTER(QUOTE(CLASSYC_CLASS_NAME) "::constructor", "constructor", is_base) \
+        if (!is_base && memory != CLASSYC_MEMORY_ELEMENT) {             \
+            if (memory == CLASSYC_MEMORY_INPLACE && !self_void) {       \
+                /* Failure allocating the memory given to the constructor */ \
+                return NULL;                                            \
+            }                                                           \
+            /* Whether the constructor allocates the object (only with CLASSYC_STATS) */ \
+            CLASSYC_STATS_HEAP_DECLARATION                              \
             /* Only for the instanced objects, not for the base classes: run the 'real' constructor */\
-             self_void = PREFIXCONCAT(CLASSYC_CLASS_NAME, _constructor)(self_void); \
+             self_void = PREFIXCONCAT(CLASSYC_CLASS_NAME, _constructor)(self_void, memory); \
              if (!self_void) {                                          \
                 /* Failure, pointer to the object is NULL */            \
                 return NULL;                                            \
              }                                                          \
+             /* Count the object in the statistics of the class (only with CLASSYC_STATS) */ \
+             CLASSYC_STATS_CONSTRUCT(CLASSYC_CLASS_NAME, ADD_PREFIX(stats_heap), 1) \
         }                                                               \
         CLASSYC_CLASS_NAME * self = (CLASSYC_CLASS_NAME *)self_void;    \
         /* User constructor code follows, it will be executed even if is_base is true when INIT_BASE is called */ \
@@ -715,11 +2852,16 @@ static CLASSYC_INLINE void PREFIXCONCAT(OBJECT, _user_destructor)(bool is_base,
      /* Contains the destructor code for the class. Then on END_DESTRUCTOR invokes the base class destructor */\
      /* _ptr_destructor is used when a pointer marked for auto-destruction gets out of scope */\
     static CLASSYC_INLINE void PREFIXCONCAT(CLASSYC_CLASS_NAME, _ptr_destructor)(CLASSYC_CLASS_NAME **self_ptr) { \
+           if (*self_ptr && !CLASSYC_LAST_REFERENCE(*self_ptr)) {        \
+               /* Reference counted object still in use: only drop the reference */ \
+               *self_ptr = NULL;                                         \
+               return;                                                   \
+           }                                                             \
            /* Call the destructor for the class */                       \
            PREFIXCONCAT(CLASSYC_CLASS_NAME, _destructor)(*self_ptr);     \
            /* Free the memory allocated for the object and nullify ptr */\
            if (*self_ptr) {                                              \
-               free(*self_ptr);                                          \
+               CLASSYC_FREE_OBJECT(*self_ptr);                           \
                *self_ptr = NULL;                                         \
            }                                                             \
     }                                                                    \
@@ -734,9 +2876,13 @@ static CLASSYC_INLINE void PREFIXCONCAT(OBJECT, _user_destructor)(bool is_base,
         }                                                                \
         /* Call user destructor */                                       \
         PREFIXCONCAT(CLASSYC_CLASS_NAME, _user_destructor)(IS_BASE_FALSE, self); \
+        /* Count the object in the statistics of its class (only with CLASSYC_STATS) */ \
+        CLASSYC_STATS_DESTRUCT                                           \
     }                                                                    \
     /* User destructor function */                                       \
     static CLASSYC_INLINE void PREFIXCONCAT(CLASSYC_CLASS_NAME, _user_destructor)(bool is_base, void *self_void) { \
+        CLASSYC_PROFILE_ENTER(CLASSYC_CLASS_NAME, "destructor")          \
+        CLASSYC_TRACE_ENTER(QUOTE(CLASSYC_CLASS_NAME) "::destructor", "destructor", is_base) \
         (void)is_base;                                                   \
         if (!self_void) {                                                \
             /* NULL self_void can't be casted or processed */            \
@@ -748,6 +2894,10 @@ static CLASSYC_INLINE void PREFIXCONCAT(OBJECT, _user_destructor)(bool is_base,
 #define END_DESTRUCTOR \
         /* Call the base class destructor (this will happen recursively upwards in the inheritance tree) */ \
         if (self) {                                                                                         \
+            /* Free the handler lists of the events of the class */                                         \
+            WRITE_FREE_CLASS_EVENTS(CLASSYC_CLASS_NAME)                                                     \
+            /* Free the cold block of the class */                                                          \
+            WRITE_FREE_CLASS_COLD(CLASSYC_CLASS_NAME)                                                       \
             /* Call the base class destructor with is_base set to true */                                   \
             PREFIXCONCAT(X_GET_BASE_NAME(CLASSYC_CLASS_NAME), _user_destructor)(IS_BASE_TRUE, self);        \
             /* Mark the destructor as called by setting the function pointer to NULL. Destructors are called once. */\
@@ -758,6 +2908,8 @@ static CLASSYC_INLINE void PREFIXCONCAT(OBJECT, _user_destructor)(bool is_base,
 /* METHOD CREATION */
 #define METHOD(ret_type, method_name, ...)                                                                    \
     static CLASSYC_INLINE ret_type PREFIXCONCAT(CLASSYC_CLASS_NAME, _##method_name)(void *self_void WITHOUT_COMMA(__VA_ARGS__)) { \
+        CLASSYC_PROFILE_ENTER(CLASSYC_CLASS_NAME, #method_name)                                               \
+        CLASSYC_TRACE_ENTER(QUOTE(CLASSYC_CLASS_NAME) "::" #method_name, "method", false)                     \
         CLASSYC_CLASS_NAME *self = (CLASSYC_CLASS_NAME *)self_void;                                           \
         (void)self;                                                                                           \
         /* User method code */
@@ -765,11 +2917,545 @@ static CLASSYC_INLINE void PREFIXCONCAT(OBJECT, _user_destructor)(bool is_base,
 #define END_METHOD \
     }
 
+/* Method with a latency histogram (only with CLASSYC_LATENCY): TIMED_METHOD(ret_type, method_name, ...) [code] END_METHOD */
+#define TIMED_METHOD(ret_type, method_name, ...)                                \
+    METHOD(ret_type, method_name, __VA_ARGS__)                                  \
+        CLASSYC_LATENCY_ENTER(QUOTE(CLASSYC_CLASS_NAME) "::" #method_name)
+
+/* SEALED CLASSES AND FINAL METHODS */
+/* Final method: FINAL_METHOD(ret_type, method_name, ...) [code] END_METHOD, not listed in CLASS_class_name. */
+/* It has no method pointer, so it costs no memory in the objects and is always called directly (see CALL_FINAL). */
+/* It declares the final marker ClassyC_<class>_<method>_is_final as an enumerator. The Method and Override entries of */
+/* the derived classes (checked by their constructor) and their final methods declare the markers of all their base */
+/* classes as variables, so a method with the name of a final method of a base class is a compile-time error */
+/* List of the base classes of a class (OBJECT first), without the class itself */
+#define WRITE_BASE_CLASS_ITEM(class) CLASSYC_LIST_ITEM(class)
+#define RECURSIVE_BASE_CLASS_ITEMS_9(class)  \
+    WRITE_BASE_CLASS_ITEM(class) 
+#define RECURSIVE_BASE_CLASS_ITEMS_8(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_BASE_CLASS_ITEMS_9, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_BASE_CLASS_ITEM(class) 
+#define RECURSIVE_BASE_CLASS_ITEMS_7(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_BASE_CLASS_ITEMS_8, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_BASE_CLASS_ITEM(class) 
+#define RECURSIVE_BASE_CLASS_ITEMS_6(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_BASE_CLASS_ITEMS_7, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_BASE_CLASS_ITEM(class) 
+#define RECURSIVE_BASE_CLASS_ITEMS_5(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_BASE_CLASS_ITEMS_6, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_BASE_CLASS_ITEM(class) 
+#define RECURSIVE_BASE_CLASS_ITEMS_4(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_BASE_CLASS_ITEMS_5, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_BASE_CLASS_ITEM(class) 
+#define RECURSIVE_BASE_CLASS_ITEMS_3(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_BASE_CLASS_ITEMS_4, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_BASE_CLASS_ITEM(class) 
+#define RECURSIVE_BASE_CLASS_ITEMS_2(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_BASE_CLASS_ITEMS_3, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_BASE_CLASS_ITEM(class) 
+#define RECURSIVE_BASE_CLASS_ITEMS_1(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_BASE_CLASS_ITEMS_2, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_BASE_CLASS_ITEM(class) 
+#define RECURSIVE_BASE_CLASS_ITEMS(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_BASE_CLASS_ITEMS_1, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) 
+#define GET_FINAL_MARKER(class_name, method_name) PREFIXCONCAT(class_name, CONCAT(_, CONCAT(method_name, _is_final)))
+#define WRITE_FINAL_CHECK(method_item, class_item) \
+    extern char GET_FINAL_MARKER(CLASSYC_UNPACK class_item, CLASSYC_UNPACK method_item);
+#define WRITE_FINAL_CHECKS(class_name, method_item) \
+    CLASSYC_FOR_EACH_NESTED(WRITE_FINAL_CHECK, method_item, RECURSIVE_BASE_CLASS_ITEMS(class_name))
+#define CLASSYC_CHECK_METHODS_NOT_FINAL \
+    CLASSYC_FOR_EACH(WRITE_FINAL_CHECKS, CLASSYC_CLASS_NAME, \
+                     GET_IMPLEMENTS(CLASSYC_CLASS_NAME)(WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_METHOD_NAME, WRITE_METHOD_NAME))
+#define FINAL_METHOD(ret_type, method_name, ...) \
+    CLASSYC_FOR_EACH(WRITE_FINAL_CHECK, (method_name), RECURSIVE_BASE_CLASS_ITEMS(CLASSYC_CLASS_NAME)) \
+    enum { GET_FINAL_MARKER(CLASSYC_CLASS_NAME, method_name) = 1 }; \
+    METHOD(ret_type, method_name, __VA_ARGS__)
+/* Sealed class: SEALED() in the definition of a class forbids deriving from it. The constructor of every class */
+/* declares the sealed marker of its base class as a variable, which conflicts with the enumerator declared here */
+#define SEALED() \
+    enum { PREFIXCONCAT(CLASSYC_CLASS_NAME, _is_sealed) = 1 };
+#define CLASSYC_CHECK_BASE_NOT_SEALED \
+    extern char PREFIXCONCAT(X_GET_BASE_NAME(CLASSYC_CLASS_NAME), _is_sealed);
+
+/* COLD DATA */
+/* Rarely used data members are kept in a block allocated on first access, so the objects only hold a pointer to it. */
+/* COLD_DATA(Data, class_name) in CLASS_class_name declares the pointer, COLD_class_name(ColdData) lists the members */
+#define GET_COLD(class_name) CONCAT(COLD_, class_name)
+#define COLD_DATA(Data, class_name) Data(void *, PREFIXCONCAT(class_name, _cold))
+/* Every class has a cold block offset: this tentative definition leaves it at 0 (no cold block) unless COLD_BLOCK defines it */
+#define WRITE_CLASS_COLD_OFFSET(class_name) \
+    static size_t PREFIXCONCAT(class_name, _cold_offset);
+/* Define the cold block of the class and its offset: COLD_BLOCK() after END_CONSTRUCTOR and before using COLD */
+#define COLD_BLOCK() \
+    struct PREFIXCONCAT(CLASSYC_CLASS_NAME, _cold_block) { GET_COLD(CLASSYC_CLASS_NAME)(WRITE_DATA_MEMBER) }; \
+    static size_t PREFIXCONCAT(CLASSYC_CLASS_NAME, _cold_offset) = offsetof(CLASSYC_CLASS_NAME, PREFIXCONCAT(CLASSYC_CLASS_NAME, _cold));
+/* Pointer to the cold block of a class in an object (in the object constructor and destructor) */
+#define CLASSYC_COLD_POINTER(class_name) ((void **)((char *)self + PREFIXCONCAT(class_name, _cold_offset)))
+/* The cold block is created on first access, so it is cleared on construction even if the object memory was not zeroed */
+#define WRITE_CLEAR_CLASS_COLD(class_name) \
+    if (PREFIXCONCAT(class_name, _cold_offset)) { *CLASSYC_COLD_POINTER(class_name) = NULL; }
+/* Free the cold block on destruction, after the user destructor */
+#define WRITE_FREE_CLASS_COLD(class_name) \
+    if (PREFIXCONCAT(class_name, _cold_offset)) { free(*CLASSYC_COLD_POINTER(class_name)); *CLASSYC_COLD_POINTER(class_name) = NULL; }
+
+/* Get the cold block of an object, allocating it (zeroed) if it doesn't exist. Returns NULL if the allocation fails. */
+/* Not synchronized: the block must be created before the object is shared with other threads */
+static CLASSYC_INLINE void *ADD_PREFIX(cold_block)(void **cold, size_t size) {
+    if (!*cold) {
+        *cold = calloc(1, size);
+    }
+    return *cold;
+}
+/* Cold members of an object: COLD(object, class_name)->member_name, class_name being the class that declares them */
+/* The result is NULL if the block couldn't be allocated: check it before dereferencing it where that can happen */
+#define COLD(instance_name, class_name) \
+    ((struct PREFIXCONCAT(class_name, _cold_block) *)ADD_PREFIX(cold_block)(&(instance_name)->PREFIXCONCAT(class_name, _cold), \
+                                                                          sizeof(struct PREFIXCONCAT(class_name, _cold_block))))
+/* Cold block of an object without creating it: NULL if its cold members were never accessed */
+#define COLD_PEEK(instance_name, class_name) \
+    ((struct PREFIXCONCAT(class_name, _cold_block) *)(instance_name)->PREFIXCONCAT(class_name, _cold))
+
+/* STRUCTS OF ARRAYS */
+/* SOA(class_name) defines a collection of rows holding the data members of a class (and its base classes, not the */
+/* OBJECT members) in one array per member, so loops over one or two members only read those arrays. Rows have no */
+/* methods, events or destructors. Data members declared with an array declarator (e.g. name[16]) can't be columns: */
+/* SOA rejects them at compile time. */
+/* The data members of each class of the inheritance tree are collected as (type, name) items, base class first */
+#define WRITE_DATA_ITEM(type, member_name) CLASSYC_LIST_ITEM(type, member_name)
+#define CLASSYC_OBJECT_PROBE_OBJECT ~, 1
+/* 1 if the class is OBJECT, 0 otherwise */
+#define CLASSYC_IS_OBJECT(class) CLASSYC_SECOND_APPLY((CONCAT(CLASSYC_OBJECT_PROBE_, class), 0, ~))
+#define WRITE_CLASS_DATA_ITEMS_0(class) \
+        GET_IMPLEMENTS(class)(WRITE_NOTHING, WRITE_NOTHING, WRITE_DATA_ITEM, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING)
+#define WRITE_CLASS_DATA_ITEMS_1(class)
+#define WRITE_CLASS_DATA_ITEMS(class) CONCAT(WRITE_CLASS_DATA_ITEMS_, CLASSYC_IS_OBJECT(class))(class)
+#define RECURSIVE_CLASS_DATA_ITEMS_9(class)  \
+    WRITE_CLASS_DATA_ITEMS(class) 
+#define RECURSIVE_CLASS_DATA_ITEMS_8(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_DATA_ITEMS_9, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_DATA_ITEMS(class) 
+#define RECURSIVE_CLASS_DATA_ITEMS_7(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_DATA_ITEMS_8, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_DATA_ITEMS(class) 
+#define RECURSIVE_CLASS_DATA_ITEMS_6(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_DATA_ITEMS_7, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_DATA_ITEMS(class) 
+#define RECURSIVE_CLASS_DATA_ITEMS_5(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_DATA_ITEMS_6, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_DATA_ITEMS(class) 
+#define RECURSIVE_CLASS_DATA_ITEMS_4(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_DATA_ITEMS_5, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_DATA_ITEMS(class) 
+#define RECURSIVE_CLASS_DATA_ITEMS_3(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_DATA_ITEMS_4, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_DATA_ITEMS(class) 
+#define RECURSIVE_CLASS_DATA_ITEMS_2(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_DATA_ITEMS_3, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_DATA_ITEMS(class) 
+#define RECURSIVE_CLASS_DATA_ITEMS_1(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_DATA_ITEMS_2, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_DATA_ITEMS(class) 
+#define RECURSIVE_CLASS_DATA_ITEMS(class)  \
+    GET_IMPLEMENTS(class)(RECURSIVE_CLASS_DATA_ITEMS_1, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING, WRITE_NOTHING) \
+    WRITE_CLASS_DATA_ITEMS(class) 
+
+/* Writers of the collection code, applied to every (type, name) item */
+#define WRITE_SOA_ITEMS(writer, fixed, class) CLASSYC_FOR_EACH(writer, fixed, RECURSIVE_CLASS_DATA_ITEMS(class))
+#define WRITE_SOA_COLUMN_HELPER(type, member_name) type *member_name;
+#define WRITE_SOA_COLUMN(fixed, item) WRITE_SOA_COLUMN_HELPER item
+/* A member declared with an array declarator is bigger than its type: its column would be an array of pointers */
+#define WRITE_SOA_CHECK_HELPER(type, member_name)                                                   \
+    _Static_assert(sizeof(struct { type member_name; }) == sizeof(type),                            \
+                   "SOA columns can't be data members declared as arrays: " #member_name);
+#define WRITE_SOA_CHECK(fixed, item) WRITE_SOA_CHECK_HELPER item
+/* capacity * sizeof(type) must not overflow, checked for every column before growing any of them */
+#define WRITE_SOA_CHECK_CAPACITY_HELPER(type, member_name) if (capacity > SIZE_MAX / sizeof(type)) return false;
+#define WRITE_SOA_CHECK_CAPACITY(fixed, item) WRITE_SOA_CHECK_CAPACITY_HELPER item
+#define WRITE_SOA_GROW_HELPER(type, member_name)                                                    \
+    grown = realloc(soa->member_name, capacity * sizeof(type));                                     \
+    if (!grown) return false;                                                                       \
+    soa->member_name = (type *)grown;
+#define WRITE_SOA_GROW(fixed, item) WRITE_SOA_GROW_HELPER item
+#define WRITE_SOA_FREE_HELPER(type, member_name) free(soa->member_name);
+#define WRITE_SOA_FREE(fixed, item) WRITE_SOA_FREE_HELPER item
+#define WRITE_SOA_ZERO_HELPER(type, member_name) memset(&soa->member_name[soa->count], 0, sizeof(type));
+#define WRITE_SOA_ZERO(fixed, item) WRITE_SOA_ZERO_HELPER item
+#define WRITE_SOA_COPY_HELPER(type, member_name) soa->member_name[soa->count] = object->member_name;
+#define WRITE_SOA_COPY(fixed, item) WRITE_SOA_COPY_HELPER item
+#define WRITE_SOA_MOVE_HELPER(type, member_name) soa->member_name[index] = soa->member_name[soa->count];
+#define WRITE_SOA_MOVE(fixed, item) WRITE_SOA_MOVE_HELPER item
+#define WRITE_SOA_VIEW_HELPER(type, member_name) view.member_name = &soa->member_name[index];
+#define WRITE_SOA_VIEW(fixed, item) WRITE_SOA_VIEW_HELPER item
+
+/* Collection of rows of a class: SOA_OF(class_name), zero-initialized. soa->member_name is the column of a member. */
+#define SOA_OF(class_name) PREFIXCONCAT(class_name, _soa)
+/* Row proxy: SOA_VIEW_OF(class_name), with a pointer to the member of the row for each column */
+#define SOA_VIEW_OF(class_name) PREFIXCONCAT(class_name, _soa_view)
+/* Initial number of rows of a collection */
+#ifndef CLASSYC_SOA_INITIAL_CAPACITY
+#define CLASSYC_SOA_INITIAL_CAPACITY 16
+#endif
+#define SOA(class_name)                                                                     \
+    WRITE_SOA_ITEMS(WRITE_SOA_CHECK, ~, class_name)                                         \
+    typedef struct PREFIXCONCAT(class_name, _soa) SOA_OF(class_name);                       \
+    struct PREFIXCONCAT(class_name, _soa) {                                                 \
+        size_t count;       /* Rows in use */                                               \
+        size_t capacity;    /* Rows allocated in every column */                            \
+        WRITE_SOA_ITEMS(WRITE_SOA_COLUMN, ~, class_name)                                    \
+    };                                                                                      \
+    typedef struct PREFIXCONCAT(class_name, _soa_view) SOA_VIEW_OF(class_name);             \
+    struct PREFIXCONCAT(class_name, _soa_view) {                                            \
+        WRITE_SOA_ITEMS(WRITE_SOA_COLUMN, ~, class_name)                                    \
+    };                                                                                      \
+    /* Grow every column to hold capacity rows. Returns false if out of memory or too big (the rows are kept). */ \
+    static CLASSYC_INLINE bool PREFIXCONCAT(class_name, _soa_reserve)(SOA_OF(class_name) *soa, size_t capacity) { \
+        void *grown;                                                                        \
+        if (capacity <= soa->capacity) return true;                                         \
+        WRITE_SOA_ITEMS(WRITE_SOA_CHECK_CAPACITY, ~, class_name)                            \
+        WRITE_SOA_ITEMS(WRITE_SOA_GROW, ~, class_name)                                      \
+        (void)grown;                                                                        \
+        soa->capacity = capacity;                                                           \
+        return true;                                                                        \
+    }                                                                                       \
+    /* Make room for one more row, doubling the capacity when full */                      \
+    static CLASSYC_INLINE bool PREFIXCONCAT(class_name, _soa_grow)(SOA_OF(class_name) *soa) { \
+        return soa->count < soa->capacity ||                                                \
+               (soa->capacity <= SIZE_MAX / 2 &&                                            \
+                PREFIXCONCAT(class_name, _soa_reserve)(soa, soa->capacity ? soa->capacity * 2 : CLASSYC_SOA_INITIAL_CAPACITY)); \
+    }                                                                                       \
+    static CLASSYC_INLINE size_t PREFIXCONCAT(class_name, _soa_append)(SOA_OF(class_name) *soa) { \
+        if (!PREFIXCONCAT(class_name, _soa_grow)(soa)) return SIZE_MAX;                     \
+        WRITE_SOA_ITEMS(WRITE_SOA_ZERO, ~, class_name)                                      \
+        return soa->count++;                                                                \
+    }                                                                                       \
+    static CLASSYC_INLINE size_t PREFIXCONCAT(class_name, _soa_append_object)(SOA_OF(class_name) *soa, const class_name *object) { \
+        if (!PREFIXCONCAT(class_name, _soa_grow)(soa)) return SIZE_MAX;                     \
+        WRITE_SOA_ITEMS(WRITE_SOA_COPY, ~, class_name)                                      \
+        return soa->count++;                                                                \
+    }                                                                                       \
+    /* Remove a row by moving the last row into its place. Returns false if there is no row at index. */ \
+    static CLASSYC_INLINE bool PREFIXCONCAT(class_name, _soa_remove)(SOA_OF(class_name) *soa, size_t index) { \
+        if (index >= soa->count) return false;                                              \
+        soa->count--;                                                                       \
+        if (index != soa->count) {                                                          \
+            WRITE_SOA_ITEMS(WRITE_SOA_MOVE, ~, class_name)                                  \
+        }                                                                                   \
+        return true;                                                                        \
+    }                                                                                       \
+    static CLASSYC_INLINE SOA_VIEW_OF(class_name) PREFIXCONCAT(class_name, _soa_row)(SOA_OF(class_name) *soa, size_t index) { \
+        SOA_VIEW_OF(class_name) view;                                                       \
+        WRITE_SOA_ITEMS(WRITE_SOA_VIEW, ~, class_name)                                      \
+        return view;                                                                        \
+    }                                                                                       \
+    static CLASSYC_INLINE void PREFIXCONCAT(class_name, _soa_free)(SOA_OF(class_name) *soa) { \
+        WRITE_SOA_ITEMS(WRITE_SOA_FREE, ~, class_name)                                      \
+        memset(soa, 0, sizeof(*soa));                                                       \
+    }
+/* Add a zeroed row: SOA_APPEND(class_name, soa). Returns the index of the row, SIZE_MAX if out of memory. */
+#define SOA_APPEND(class_name, soa) PREFIXCONCAT(class_name, _soa_append)(soa)
+/* Add a row with a copy of the data members of an object of the class (or of a derived class, cast to it) */
+#define SOA_APPEND_OBJECT(class_name, soa, object) PREFIXCONCAT(class_name, _soa_append_object)((soa), (object))
+/* Remove a row by moving the last row into its place: the order of the rows is not kept. */
+/* Returns false, removing nothing, if index is not a row of the collection (e.g. the collection is empty). */
+#define SOA_REMOVE(class_name, soa, index) PREFIXCONCAT(class_name, _soa_remove)((soa), (index))
+/* Row proxy: *SOA_VIEW(class_name, soa, index).member_name. Valid until the collection grows. */
+#define SOA_VIEW(class_name, soa, index) PREFIXCONCAT(class_name, _soa_row)((soa), (index))
+#define SOA_RESERVE(class_name, soa, capacity) PREFIXCONCAT(class_name, _soa_reserve)((soa), (capacity))
+/* Free the columns of a collection, leaving it empty */
+#define SOA_FREE(class_name, soa) PREFIXCONCAT(class_name, _soa_free)(soa)
+
+/* Get the pointer to the most derived implementation of a method (or interface cast function) of an object */
+#ifdef CLASSYC_SHARED_VTABLE
+    #define GET_METHOD_PTR(instance_name, method_name) ((instance_name)->_vt->method_name)
+    #define GET_INTERFACE_DESC(instance_name, interface_name) ((instance_name)->_vt->CONCAT(_desc_, interface_name))
+#else
+    #define GET_METHOD_PTR(instance_name, method_name) ((instance_name)->method_name)
+    #define GET_INTERFACE_DESC(instance_name, interface_name) ((instance_name)->CONCAT(_desc_, interface_name))
+#endif
+
+/* Method caller that works in every mode: CALL(object, method_name[, args]). The object expression is evaluated twice. */
+/* With CLASSYC_STATIC_CALLS (C11), objects whose pointer type is one of the CLASSYC_FINAL_CLASSES are called statically */
+#ifdef CLASSYC_STATIC_CALLS
+    #define CLASSYC_STATIC_VTABLE_ASSOCIATION(class_name) class_name *: &PREFIXCONCAT(class_name, _static_vtable),
+    #ifdef CLASSYC_SHARED_VTABLE
+        #define CLASSYC_DYNAMIC_VTABLE(instance_name) (instance_name)->_vt
+    #else
+        #define CLASSYC_DYNAMIC_VTABLE(instance_name) (instance_name)
+    #endif
+    #define CALL(instance_name, method_name, ...) \
+        _Generic((instance_name), CLASSYC_FINAL_CLASSES(CLASSYC_STATIC_VTABLE_ASSOCIATION) \
+                 default: CLASSYC_DYNAMIC_VTABLE(instance_name))->method_name((instance_name) WITHOUT_COMMA(__VA_ARGS__))
+#else
+    #define CALL(instance_name, method_name, ...) \
+        GET_METHOD_PTR(instance_name, method_name)((instance_name) WITHOUT_COMMA(__VA_ARGS__))
+#endif
+/* Static method caller: CALL_STATIC(class_name, method_name, object[, args]) calls the implementation of class_name */
+/* directly, without reading any method pointer, so it can be inlined. The object must be of class_name: an override */
+/* in a derived class is not seen. Works in every mode and with inherited methods and interface casts. */
+#define CALL_STATIC(class_name, method_name, instance_name, ...) \
+    (PREFIXCONCAT(class_name, _static_vtable).method_name((instance_name) WITHOUT_COMMA(__VA_ARGS__)))
+/* Final method caller: CALL_FINAL(class_name, method_name, object[, args]), class_name being the class that defines */
+/* the final method. The object can be of that class or of any class derived from it. */
+#define CALL_FINAL(class_name, method_name, instance_name, ...) \
+    PREFIXCONCAT(class_name, _##method_name)((instance_name) WITHOUT_COMMA(__VA_ARGS__))
+
+/* TYPE CHECKS */
+/* Type descriptor of a class: CLASS_INFO(class_name). Its address identifies the class in the translation unit. */
+#define CLASS_INFO(class_name) (&PREFIXCONCAT(class_name, _class_info))
+/* Type descriptor of the actual class of an object: CLASS_OF(object)->name */
+#define CLASS_OF(instance_name) ADD_PREFIX(class_of)(instance_name)
+/* Check if an object is of a class or one of its derived classes: one indexed compare (and a compare of the names */
+/* for objects constructed in another translation unit) */
+static CLASSYC_INLINE bool ADD_PREFIX(is_a)(const void *object, const ClassyC_class_info *class_info) {
+    return ADD_PREFIX(same_class)(ADD_PREFIX(class_of)(object)->ancestors[class_info->depth], class_info);
+}
+static CLASSYC_INLINE void *ADD_PREFIX(dynamic_cast)(void *object, const ClassyC_class_info *class_info) {
+    return (object && ADD_PREFIX(is_a)(object, class_info)) ? object : NULL;
+}
+/* The object must not be NULL: if (IS_A(object, class_name)) { ... } */
+#define IS_A(instance_name, class_name) ADD_PREFIX(is_a)((instance_name), CLASS_INFO(class_name))
+/* Checked cast: class_name *ptr = DYNAMIC_CAST(object, class_name); NULL if the object is NULL or not of the class */
+#define DYNAMIC_CAST(instance_name, class_name) \
+    ((class_name *)ADD_PREFIX(dynamic_cast)((instance_name), CLASS_INFO(class_name)))
+
+/* CLOSED HIERARCHIES */
+/* A closed hierarchy lists all the classes of the objects used through a base class, in the x-macro */
+/* HIERARCHY_root_name(Class). CLOSED_HIERARCHY(root_name), after the definition of the classes, gives them dense ids */
+/* (ClassyC_<class>_hierarchy_id, from 0 to ClassyC_<root_name>_class_count - 1) and defines the class id function */
+/* With __COUNTER__, the class of an object is selected with a switch on its uid, which the compiler turns into a jump */
+/* table; otherwise (and for the classes of other translation units) its type descriptor is compared with the listed ones */
+#define GET_HIERARCHY(root_name) CONCAT(HIERARCHY_, root_name)
+#define WRITE_HIERARCHY_ID(class_name) PREFIXCONCAT(class_name, _hierarchy_id),
+#define WRITE_HIERARCHY_ID_CHECK(class_name) \
+    if (ADD_PREFIX(same_class)(class_info, CLASS_INFO(class_name))) return PREFIXCONCAT(class_name, _hierarchy_id);
+#ifdef CLASSYC_CLASS_UIDS
+    #define WRITE_HIERARCHY_ID_CASE(class_name) \
+        case PREFIXCONCAT(class_name, _uid): return PREFIXCONCAT(class_name, _hierarchy_id);
+    #define CLASSYC_HIERARCHY_ID_SWITCH(root_name)                                          \
+        switch (ADD_PREFIX(class_uid)(object)) {                                            \
+            GET_HIERARCHY(root_name)(WRITE_HIERARCHY_ID_CASE)                               \
+            default: break;                                                                 \
+        }
+#else
+    #define CLASSYC_HIERARCHY_ID_SWITCH(root_name)
+#endif
+#define CLOSED_HIERARCHY(root_name)                                                         \
+    enum { GET_HIERARCHY(root_name)(WRITE_HIERARCHY_ID) PREFIXCONCAT(root_name, _class_count) }; \
+    static CLASSYC_INLINE int PREFIXCONCAT(root_name, _class_id)(const void *object) {     \
+        const ClassyC_class_info *class_info = ADD_PREFIX(class_of)(object);                \
+        CLASSYC_HIERARCHY_ID_SWITCH(root_name)                                              \
+        GET_HIERARCHY(root_name)(WRITE_HIERARCHY_ID_CHECK)                                  \
+        return -1;                                                                          \
+    }
+/* Id of the class of an object in a closed hierarchy, -1 if its class is not listed: switch (CLASS_ID(root_name, object)) */
+#define CLASS_ID(root_name, instance_name) PREFIXCONCAT(root_name, _class_id)(instance_name)
+/* Closed hierarchy method caller: CLOSED_CALL(root_name, method_name, object[, args]). The implementations of the listed */
+/* classes are called directly, so they can be inlined. Objects of classes not listed (or constructed in another */
+/* translation unit) are called through their method pointers. */
+#define WRITE_CLOSED_CALL_CASE(call, class_item) CLASSYC_CLOSED_CALL_CASE_APPLY((CLASSYC_UNPACK class_item, CLASSYC_UNPACK call))
+#define CLASSYC_CLOSED_CALL_CASE_APPLY(args) CLASSYC_CLOSED_CALL_CASE args
+#if defined(CLASSYC_CLASS_UIDS) && defined(__GNUC__)
+    /* A statement expression (GCC and Clang) with a switch on the uid of the class. The object is evaluated once. */
+    /* Void methods give a void expression: the result variable is an unused int for them */
+    #define CLASSYC_CLOSED_SWITCH
+    #define CLASSYC_CLOSED_IS_VOID(call) __builtin_types_compatible_p(__typeof__(call), void)
+    #define CLASSYC_CLOSED_VALUE(call) __builtin_choose_expr(ClassyC_closed_void, ((call), 0), (call))
+    #define CLASSYC_CLOSED_CALL_CASE(class_name, method_name, ...)                          \
+        case PREFIXCONCAT(class_name, _uid):                                                \
+            ClassyC_closed_result = CLASSYC_CLOSED_VALUE(CALL_STATIC(class_name, method_name, ClassyC_closed_object, __VA_ARGS__)); \
+            break;
+    #define CLOSED_CALL(root_name, method_name, instance_name, ...) __extension__ ({       \
+        __typeof__(instance_name) ClassyC_closed_object = (instance_name);                  \
+        enum { ClassyC_closed_void = CLASSYC_CLOSED_IS_VOID(CALL(ClassyC_closed_object, method_name, __VA_ARGS__)) }; \
+        __typeof__(CLASSYC_CLOSED_VALUE(CALL(ClassyC_closed_object, method_name, __VA_ARGS__))) ClassyC_closed_result; \
+        switch (ADD_PREFIX(class_uid)(ClassyC_closed_object)) {                             \
+            CLASSYC_FOR_EACH(WRITE_CLOSED_CALL_CASE, (method_name WITHOUT_COMMA(__VA_ARGS__)), \
+                             GET_HIERARCHY(root_name)(CLASSYC_LIST_ITEM))                   \
+            default:                                                                        \
+                ClassyC_closed_result = CLASSYC_CLOSED_VALUE(CALL(ClassyC_closed_object, method_name, __VA_ARGS__)); \
+        }                                                                                   \
+        (void)ClassyC_closed_result;                                                        \
+        __builtin_choose_expr(ClassyC_closed_void, (void)0, ClassyC_closed_result); })
+#else
+    /* A chain of conditional expressions comparing type descriptors. The object expression is evaluated several times. */
+    #define CLASSYC_CLOSED_CALL_CASE(class_name, method_name, instance_name, ...) \
+        CLASS_OF(instance_name) == CLASS_INFO(class_name) ? CALL_STATIC(class_name, method_name, instance_name, __VA_ARGS__) :
+    #define CLOSED_CALL(root_name, method_name, instance_name, ...)                         \
+        (CLASSYC_FOR_EACH(WRITE_CLOSED_CALL_CASE, (method_name, instance_name WITHOUT_COMMA(__VA_ARGS__)), \
+                          GET_HIERARCHY(root_name)(CLASSYC_LIST_ITEM))                      \
+         CALL(instance_name, method_name, __VA_ARGS__))
+#endif
+
 /* Base method caller */
 #define BASE_METHOD(method_name, ...) \
     PREFIXCONCAT(X_GET_BASE_NAME(CLASSYC_CLASS_NAME), _##method_name)(self WITHOUT_COMMA(__VA_ARGS__))
 
 /* EVENTS */
+/* Each event is a pointer to a list of handlers (function pointers of the event type) in the heap, NULL without handlers. */
+/* The list is a small vector: a header, the handler slots and a stack with the indices of the free slots, in one block */
+/* whose capacity doubles when full. Unsubscribing empties the slot of the handler (the other handlers don't move, so a */
+/* raise in progress doesn't skip any) and stacks its index for the next subscription. The index of the slot of a */
+/* handler is its subscription ID. */
+/* With CLASSYC_ATOMIC_EVENTS lists are never modified once published: each change publishes a copy, and the replaced */
+/* list is retired until RECLAIM_EVENT or the destruction of the object. */
+typedef struct ClassyC_event_list_header ClassyC_event_list_header;
+struct ClassyC_event_list_header {
+    size_t count;       /* Slots in use, including the free ones */
+    size_t capacity;
+    size_t free_count;  /* Free slots, whose indices are stacked after the slots */
+    size_t last;        /* Slot of the last subscription, CLASSYC_NO_SUBSCRIPTION if it failed */
+    void *retired;      /* Next retired list waiting to be freed (only with CLASSYC_ATOMIC_EVENTS) */
+    void *event;        /* Event member the list was replaced in, once retired (only with CLASSYC_ATOMIC_EVENTS) */
+};
+/* Subscription ID: the slot of a handler in the list of its event */
+typedef size_t ClassyC_subscription;
+#define CLASSYC_NO_SUBSCRIPTION SIZE_MAX
+/* Capacity of a list when the first handler is subscribed */
+#ifndef CLASSYC_EVENT_LIST_INITIAL_CAPACITY
+#define CLASSYC_EVENT_LIST_INITIAL_CAPACITY 2
+#endif
+/* Size of the memory block of a list */
+#define CLASSYC_EVENT_LIST_SIZE(capacity, handler_size) \
+    (sizeof(ClassyC_event_list_header) + (capacity) * ((handler_size) + sizeof(size_t)))
+
+/* Number of slots in a list, including the free ones (0 for a NULL list) */
+static CLASSYC_INLINE size_t ADD_PREFIX(event_list_count)(const void *handlers) {
+    return handlers ? ((const ClassyC_event_list_header *)handlers - 1)->count : 0;
+}
+
+/* Number of handlers subscribed in a list */
+static CLASSYC_INLINE size_t ADD_PREFIX(event_list_handlers)(const void *handlers) {
+    const ClassyC_event_list_header *header;
+    if (!handlers) {
+        return 0;
+    }
+    header = (const ClassyC_event_list_header *)handlers - 1;
+    return header->count - header->free_count;
+}
+
+/* Slot of the last subscription to a list (CLASSYC_NO_SUBSCRIPTION if it failed) */
+static CLASSYC_INLINE ClassyC_subscription ADD_PREFIX(event_list_last)(const void *handlers) {
+    return handlers ? ((const ClassyC_event_list_header *)handlers - 1)->last : CLASSYC_NO_SUBSCRIPTION;
+}
+
+/* Stack of the indices of the free slots, after the slots */
+static CLASSYC_INLINE size_t *ADD_PREFIX(event_list_free_slots)(ClassyC_event_list_header *header, size_t handler_size) {
+    return (size_t *)((char *)(header + 1) + header->capacity * handler_size);
+}
+
+/* Whether a slot holds a handler (free slots are zeroed) */
+static CLASSYC_INLINE bool ADD_PREFIX(event_slot_used)(const void *handlers, size_t index, size_t handler_size) {
+    const unsigned char *slot = (const unsigned char *)handlers + index * handler_size;
+    size_t i;
+    for (i = 0; i < handler_size; i++) {
+        if (slot[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Take a slot for a new handler: the last freed one, or a new one at the end, growing the list if it is full. */
+/* Returns the list (it may have moved), with the slot in its last member. If out of memory the list is unchanged */
+/* and its last member is CLASSYC_NO_SUBSCRIPTION (a NULL list stays NULL). */
+static CLASSYC_INLINE void *ADD_PREFIX(event_list_reserve)(void *handlers, size_t handler_size) {
+    ClassyC_event_list_header *header = handlers ? (ClassyC_event_list_header *)handlers - 1 : NULL;
+    if (header && header->free_count) {
+        header->last = ADD_PREFIX(event_list_free_slots)(header, handler_size)[--header->free_count];
+        return handlers;
+    }
+    if (!header || header->count == header->capacity) {
+        /* No free slots: the stack is empty, so nothing has to be moved when the slots grow */
+        size_t capacity = header && header->capacity ? header->capacity * 2 : CLASSYC_EVENT_LIST_INITIAL_CAPACITY;
+        ClassyC_event_list_header *grown = (ClassyC_event_list_header *)realloc(header, CLASSYC_EVENT_LIST_SIZE(capacity, handler_size));
+        if (!grown) {
+            if (header) {
+                header->last = CLASSYC_NO_SUBSCRIPTION;
+            }
+            return handlers;
+        }
+        if (!header) {
+            grown->count = 0;
+            grown->free_count = 0;
+            grown->retired = NULL;
+            grown->event = NULL;
+        }
+        grown->capacity = capacity;
+        header = grown;
+    }
+    header->last = header->count++;
+    return header + 1;
+}
+
+/* Empty a slot holding a handler and stack it for the next subscription */
+static CLASSYC_INLINE void ADD_PREFIX(event_list_empty_slot)(void *handlers, size_t index, size_t handler_size) {
+    ClassyC_event_list_header *header = (ClassyC_event_list_header *)handlers - 1;
+    memset((char *)handlers + index * handler_size, 0, handler_size);
+    ADD_PREFIX(event_list_free_slots)(header, handler_size)[header->free_count++] = index;
+}
+
+/* Remove the handler of a slot. Returns the list, or NULL if it was freed because no handlers are left. */
+/* Free slots and slots out of the list are ignored. */
+static CLASSYC_INLINE void *ADD_PREFIX(event_list_release)(void *handlers, size_t index, size_t handler_size) {
+    if (index >= ADD_PREFIX(event_list_count)(handlers) || !ADD_PREFIX(event_slot_used)(handlers, index, handler_size)) {
+        return handlers;
+    }
+    if (ADD_PREFIX(event_list_handlers)(handlers) == 1) {
+        free((ClassyC_event_list_header *)handlers - 1);
+        return NULL;
+    }
+    ADD_PREFIX(event_list_empty_slot)(handlers, index, handler_size);
+    return handlers;
+}
+
+/* Remove all the handlers of a list, keeping its memory. Returns the list. */
+static CLASSYC_INLINE void *ADD_PREFIX(event_list_reset)(void *handlers, size_t handler_size) {
+    if (handlers) {
+        ClassyC_event_list_header *header = (ClassyC_event_list_header *)handlers - 1;
+        memset(handlers, 0, header->count * handler_size);
+        header->count = 0;
+        header->free_count = 0;
+    }
+    return handlers;
+}
+
+/* Copy a list to replace it, with room for one more handler. The handlers (and the free slots) are copied if keep */
+/* is true. Returns the copy or NULL if out of memory. */
+static CLASSYC_INLINE void *ADD_PREFIX(event_list_copy)(void *handlers, size_t handler_size, bool keep) {
+    ClassyC_event_list_header *old_header = handlers ? (ClassyC_event_list_header *)handlers - 1 : NULL;
+    size_t count = keep && old_header ? old_header->count : 0;
+    ClassyC_event_list_header *header = (ClassyC_event_list_header *)malloc(CLASSYC_EVENT_LIST_SIZE(count + 1, handler_size));
+    if (!header) {
+        return NULL;
+    }
+    header->count = count;
+    header->capacity = count + 1;
+    header->free_count = count ? old_header->free_count : 0;
+    header->last = CLASSYC_NO_SUBSCRIPTION;
+    header->retired = NULL;
+    header->event = NULL;
+    if (count) {
+        memcpy(header + 1, handlers, count * handler_size);
+        memcpy(ADD_PREFIX(event_list_free_slots)(header, handler_size), ADD_PREFIX(event_list_free_slots)(old_header, handler_size),
+               header->free_count * sizeof(size_t));
+    }
+    return header + 1;
+}
+
+/* Free a copy that could not be published (NULL does nothing) */
+static CLASSYC_INLINE void ADD_PREFIX(event_list_discard)(void *handlers) {
+    if (handlers) {
+        free((ClassyC_event_list_header *)handlers - 1);
+    }
+}
+
+/* Free a list (NULL does nothing) */
+static CLASSYC_INLINE void ADD_PREFIX(event_list_free)(void *handlers) {
+    if (handlers) {
+        free((ClassyC_event_list_header *)handlers - 1);
+    }
+}
+
 #define GET_EVENT_FUNC_NAME(class_name, event_name, handler_ID) \
     CONCAT(TRICAT(ClassyC_, class_name, _), TRICAT(event_name, _hdlr_, handler_ID))
 
@@ -777,36 +3463,593 @@ static CLASSYC_INLINE void PREFIXCONCAT(OBJECT, _user_destructor)(bool is_base,
 #define EVENT_HANDLER(class_name, event_name, handler_ID, ...)                                                   \
     static CLASSYC_INLINE void GET_EVENT_FUNC_NAME(class_name, event_name, handler_ID)(void *self_void WITHOUT_COMMA(__VA_ARGS__));  \
     static CLASSYC_INLINE void GET_EVENT_FUNC_NAME(class_name, event_name, handler_ID)(void *self_void WITHOUT_COMMA(__VA_ARGS__)) { \
+        CLASSYC_PROFILE_ENTER(class_name, #event_name ":" #handler_ID) \
+        CLASSYC_LATENCY_ENTER(QUOTE(class_name) "::" #event_name ":" #handler_ID) \
+        CLASSYC_TRACE_ENTER(QUOTE(class_name) "::" #event_name ":" #handler_ID, "handler", false) \
         class_name *self = (class_name *)self_void; \
         (void)self;                                 \
         /* User code for the event */ 
 
 #define END_EVENT_HANDLER }
 
+#ifdef CLASSYC_ATOMIC_EVENTS
+/* Thread-safe events: the event members are atomic pointers to lists that are never modified once published. */
+/* Changes copy the list and publish the copy with a compare-and-swap, retrying if another thread changed it meanwhile. */
+/* Raising an event is one acquire load of the list, with no writes: the raises are not tracked. So the replaced lists */
+/* are retired, tagged with their event, and only freed at a point where no raise of that event can be in progress: */
+/* by RECLAIM_EVENT, or when the object is destroyed. */
+
+/* Retired lists of all the events, shared by the translation units (weak or selectany definition) */
+typedef struct ClassyC_event_reclaimer ClassyC_event_reclaimer;
+struct ClassyC_event_reclaimer {
+    _Atomic(void *) retired;        /* Stack of the retired lists, linked by their retired member */
+    _Atomic size_t retired_count;   /* Retired lists not freed yet */
+    atomic_flag busy;               /* A thread is reclaiming */
+};
+#if defined(__GNUC__)
+__attribute__((weak)) ClassyC_event_reclaimer ADD_PREFIX(events_reclaimer);
+#elif defined(_MSC_VER)
+__declspec(selectany) ClassyC_event_reclaimer ADD_PREFIX(events_reclaimer) = { 0 };
+#else
+/* One per translation unit: raise and change each event from a single translation unit */
+static ClassyC_event_reclaimer ADD_PREFIX(events_reclaimer);
+#endif
+
+/* Retire a list replaced in an event */
+static CLASSYC_INLINE void ADD_PREFIX(event_retire)(void *event, void *handlers) {
+    ClassyC_event_list_header *header = (ClassyC_event_list_header *)handlers - 1;
+    header->event = event;
+    atomic_fetch_add_explicit(&ADD_PREFIX(events_reclaimer).retired_count, 1, memory_order_relaxed);
+    header->retired = atomic_load_explicit(&ADD_PREFIX(events_reclaimer).retired, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&ADD_PREFIX(events_reclaimer).retired, &header->retired, handlers,
+                                                  memory_order_release, memory_order_relaxed)) {
+    }
+}
+
+/* Free the retired lists of an event. No raise of the event can be in progress (changes can). */
+static CLASSYC_INLINE void ADD_PREFIX(event_reclaim)(void *event) {
+    ClassyC_event_reclaimer *reclaimer = &ADD_PREFIX(events_reclaimer);
+    void *retired, *kept = NULL, *kept_last = NULL;
+    size_t count = 0;
+    if (!atomic_load_explicit(&reclaimer->retired, memory_order_relaxed)) {
+        return;
+    }
+    /* Reclaims take the whole stack: one at a time, so none misses the lists taken by another */
+    while (atomic_flag_test_and_set_explicit(&reclaimer->busy, memory_order_acquire)) {
+    }
+    retired = atomic_exchange_explicit(&reclaimer->retired, NULL, memory_order_acquire);
+    while (retired) {
+        ClassyC_event_list_header *header = (ClassyC_event_list_header *)retired - 1;
+        void *next = header->retired;
+        if (header->event == event) {
+            free(header);
+            count++;
+        } else {
+            /* Keep the lists of the other events, in order */
+            header->retired = NULL;
+            if (kept_last) {
+                ((ClassyC_event_list_header *)kept_last - 1)->retired = retired;
+            } else {
+                kept = retired;
+            }
+            kept_last = retired;
+        }
+        retired = next;
+    }
+    if (kept) {
+        /* Put them back under the lists retired meanwhile */
+        ClassyC_event_list_header *last = (ClassyC_event_list_header *)kept_last - 1;
+        last->retired = atomic_load_explicit(&reclaimer->retired, memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&reclaimer->retired, &last->retired, kept,
+                                                      memory_order_release, memory_order_relaxed)) {
+        }
+    }
+    atomic_fetch_sub_explicit(&reclaimer->retired_count, count, memory_order_relaxed);
+    atomic_flag_clear_explicit(&reclaimer->busy, memory_order_release);
+}
+
+/* Type of the handler list of an event member, without the _Atomic qualifier (the addition converts it to a value) */
+#define CLASSYC_EVENT_LIST_TYPE(event_member) CLASSYC_TYPEOF((event_member) + 0)
+/* Event member as an atomic pointer to the list, its handler size, and a handler of its type passed by address */
+#define CLASSYC_EVENT_ADDRESS(event_member) ((_Atomic(void *) *)(void *)&(event_member))
+#define CLASSYC_EVENT_HANDLER_SIZE(event_member) sizeof(*((event_member) + 0))
+#define CLASSYC_EVENT_HANDLER(event_member, handler) \
+    (const void *)&(CLASSYC_TYPEOF(*((event_member) + 0))){ (handler) }
+
+typedef enum ClassyC_event_change {
+    CLASSYC_EVENT_SUBSCRIBE,
+    CLASSYC_EVENT_REGISTER,
+    CLASSYC_EVENT_UNSUBSCRIBE,
+    CLASSYC_EVENT_UNSUBSCRIBE_ID,
+    CLASSYC_EVENT_CLEAR
+} ClassyC_event_change;
+
+/* Publish a copy of the list of an event with a change (NULL without handlers), retrying if another thread changed it */
+/* meanwhile, and retire the replaced list. Handler is the handler to subscribe or unsubscribe (its first subscription), */
+/* subscription the slot for CLASSYC_EVENT_UNSUBSCRIBE_ID. */
+/* Returns the slot changed, or CLASSYC_NO_SUBSCRIPTION if out of memory or nothing changed. */
+static CLASSYC_INLINE ClassyC_subscription ADD_PREFIX(event_list_publish)(_Atomic(void *) *event, size_t handler_size,
+    ClassyC_event_change change, ClassyC_subscription subscription, const void *handler) {
+    void *old = atomic_load(event);
+    void *new;
+    do {
+        size_t count = ADD_PREFIX(event_list_count)(old);
+        if (change == CLASSYC_EVENT_UNSUBSCRIBE) {
+            for (subscription = 0; subscription < count &&
+                 memcmp((char *)old + subscription * handler_size, handler, handler_size) != 0; subscription++);
+        }
+        if ((change == CLASSYC_EVENT_UNSUBSCRIBE || change == CLASSYC_EVENT_UNSUBSCRIBE_ID) &&
+            (subscription >= count || !ADD_PREFIX(event_slot_used)(old, subscription, handler_size))) {
+            /* Not subscribed */
+            return CLASSYC_NO_SUBSCRIPTION;
+        }
+        if (change == CLASSYC_EVENT_CLEAR && !ADD_PREFIX(event_list_handlers)(old)) {
+            /* Nothing to clear */
+            return CLASSYC_NO_SUBSCRIPTION;
+        }
+        if (change == CLASSYC_EVENT_CLEAR || (change != CLASSYC_EVENT_SUBSCRIBE && change != CLASSYC_EVENT_REGISTER &&
+                                              ADD_PREFIX(event_list_handlers)(old) == 1)) {
+            /* No handlers left */
+            new = NULL;
+        } else {
+            new = ADD_PREFIX(event_list_copy)(old, handler_size, change != CLASSYC_EVENT_REGISTER);
+            if (!new) {
+                return CLASSYC_NO_SUBSCRIPTION;
+            }
+            if (change == CLASSYC_EVENT_SUBSCRIBE || change == CLASSYC_EVENT_REGISTER) {
+                /* The copy has a free slot or room for one more: it does not move */
+                ADD_PREFIX(event_list_reserve)(new, handler_size);
+                subscription = ADD_PREFIX(event_list_last)(new);
+                memcpy((char *)new + subscription * handler_size, handler, handler_size);
+            } else {
+                ADD_PREFIX(event_list_empty_slot)(new, subscription, handler_size);
+            }
+        }
+        if (atomic_compare_exchange_weak(event, &old, new)) {
+            break;
+        }
+        ADD_PREFIX(event_list_discard)(new);
+    } while (1);
+    if (old) {
+        ADD_PREFIX(event_retire)((void *)event, old);
+    }
+    return subscription;
+}
+
+#define CLASSYC_PUBLISH_EVENT_LIST(event_member, change, subscription, handler) \
+    ADD_PREFIX(event_list_publish)(CLASSYC_EVENT_ADDRESS(event_member), CLASSYC_EVENT_HANDLER_SIZE(event_member), \
+                                   (change), (subscription), (handler))
+
+#define SUBSCRIBE_EVENT(class_name, event_name, handler_ID, instance_name) \
+    CLASSYC_PUBLISH_EVENT_LIST((instance_name)->event_name, CLASSYC_EVENT_SUBSCRIBE, CLASSYC_NO_SUBSCRIPTION, \
+        CLASSYC_EVENT_HANDLER((instance_name)->event_name, GET_EVENT_FUNC_NAME(class_name, event_name, handler_ID)))
+#define UNSUBSCRIBE_EVENT(class_name, event_name, handler_ID, instance_name) \
+    ((void)CLASSYC_PUBLISH_EVENT_LIST((instance_name)->event_name, CLASSYC_EVENT_UNSUBSCRIBE, CLASSYC_NO_SUBSCRIPTION, \
+        CLASSYC_EVENT_HANDLER((instance_name)->event_name, GET_EVENT_FUNC_NAME(class_name, event_name, handler_ID))))
+#define UNSUBSCRIBE_EVENT_ID(instance_name, event_name, subscription) \
+    ((void)CLASSYC_PUBLISH_EVENT_LIST((instance_name)->event_name, CLASSYC_EVENT_UNSUBSCRIBE_ID, (subscription), NULL))
+#define CLEAR_EVENT(instance_name, event_name) \
+    ((void)CLASSYC_PUBLISH_EVENT_LIST((instance_name)->event_name, CLASSYC_EVENT_CLEAR, CLASSYC_NO_SUBSCRIPTION, NULL))
+#define REGISTER_EVENT(class_name, event_name, handler_ID, instance_name) \
+    CLASSYC_PUBLISH_EVENT_LIST((instance_name)->event_name, CLASSYC_EVENT_REGISTER, CLASSYC_NO_SUBSCRIPTION, \
+        CLASSYC_EVENT_HANDLER((instance_name)->event_name, GET_EVENT_FUNC_NAME(class_name, event_name, handler_ID)))
+/* Free the lists replaced in an event of an instance. Call it at a point where no thread can be raising the event (for */
+/* instance, once the threads raising it are joined or wait at a barrier); other events can be raised and changed. */
+#define RECLAIM_EVENT(instance_name, event_name) ADD_PREFIX(event_reclaim)((void *)&(instance_name)->event_name)
+
+/* Call the handlers of an event member with the given arguments, using the list loaded once (it is not freed until */
+/* RECLAIM_EVENT or the destruction of the object) */
+#define CLASSYC_CALL_EVENT_HANDLERS(event_member, ...)                                                          \
+    do {                                                                                                        \
+        CLASSYC_EVENT_LIST_TYPE(event_member) ADD_PREFIX(handlers) =                                            \
+            atomic_load_explicit(&(event_member), memory_order_acquire);                                        \
+        if (ADD_PREFIX(handlers)) {                                                                             \
+            size_t ADD_PREFIX(index);                                                                           \
+            size_t ADD_PREFIX(count) = ADD_PREFIX(event_list_count)((void *)ADD_PREFIX(handlers));              \
+            for (ADD_PREFIX(index) = 0; ADD_PREFIX(index) < ADD_PREFIX(count); ADD_PREFIX(index)++) {           \
+                if (ADD_PREFIX(handlers)[ADD_PREFIX(index)]) {                                                  \
+                    ADD_PREFIX(handlers)[ADD_PREFIX(index)](__VA_ARGS__);                                       \
+                }                                                                                               \
+            }                                                                                                   \
+        }                                                                                                       \
+    } while (0)
+
+#else
+/* Subscribe an event handler to an event of an instance, in the slot of the last handler unsubscribed or after the others. */
+/* Handler_ID is a unique ID for the defined event handler (letters, numbers, _). */
+/* Returns the subscription ID (ClassyC_subscription), or CLASSYC_NO_SUBSCRIPTION if out of memory (the handler is not added). */
+#define SUBSCRIBE_EVENT(class_name, event_name, handler_ID, instance_name)                                         \
+    ((instance_name)->event_name = ADD_PREFIX(event_list_reserve)((void *)(instance_name)->event_name,             \
+                                                                 sizeof(*(instance_name)->event_name)),            \
+     ADD_PREFIX(event_list_last)((void *)(instance_name)->event_name) == CLASSYC_NO_SUBSCRIPTION                   \
+        ? CLASSYC_NO_SUBSCRIPTION                                                                                  \
+        : ((instance_name)->event_name[ADD_PREFIX(event_list_last)((void *)(instance_name)->event_name)] =         \
+               GET_EVENT_FUNC_NAME(class_name, event_name, handler_ID),                                            \
+           ADD_PREFIX(event_list_last)((void *)(instance_name)->event_name)))
+
+/* Unsubscribe an event handler from an event of an instance (the first subscription, if it was subscribed several times) */
+#define UNSUBSCRIBE_EVENT(class_name, event_name, handler_ID, instance_name)                                       \
+    do {                                                                                                           \
+        size_t ADD_PREFIX(index);                                                                                  \
+        size_t ADD_PREFIX(count) = ADD_PREFIX(event_list_count)((void *)(instance_name)->event_name);              \
+        for (ADD_PREFIX(index) = 0; ADD_PREFIX(index) < ADD_PREFIX(count); ADD_PREFIX(index)++) {                  \
+            if ((instance_name)->event_name[ADD_PREFIX(index)] == GET_EVENT_FUNC_NAME(class_name, event_name, handler_ID)) { \
+                UNSUBSCRIBE_EVENT_ID(instance_name, event_name, ADD_PREFIX(index));                                \
+                break;                                                                                             \
+            }                                                                                                      \
+        }                                                                                                          \
+    } while (0)
+
+/* Unsubscribe the handler with a subscription ID returned by SUBSCRIBE_EVENT or REGISTER_EVENT, without searching */
+#define UNSUBSCRIBE_EVENT_ID(instance_name, event_name, subscription)                                               \
+    ((void)((instance_name)->event_name = ADD_PREFIX(event_list_release)((void *)(instance_name)->event_name,      \
+                                                                        (subscription), sizeof(*(instance_name)->event_name))))
+
+/* Remove all the handlers of an event of an instance */
+#define CLEAR_EVENT(instance_name, event_name)                                  \
+    do {                                                                        \
+        ADD_PREFIX(event_list_free)((void *)(instance_name)->event_name);       \
+        (instance_name)->event_name = NULL;                                     \
+    } while (0)
+
 /* Register an event handler for an instance. Handler_ID is a unique ID for the defined event handler (letters, numbers, _). */
-/* If another event handler was registered, it is overwritten. */
-#define REGISTER_EVENT(class_name, event_name, handler_ID, instance_name)                    \
-    do {                                                                                     \
-        instance_name->event_name = GET_EVENT_FUNC_NAME(class_name, event_name, handler_ID); \
+/* If other event handlers were registered or subscribed, they are replaced (reusing their list). */
+/* Returns the subscription ID, or CLASSYC_NO_SUBSCRIPTION if out of memory (only possible without handlers to replace). */
+#define REGISTER_EVENT(class_name, event_name, handler_ID, instance_name)                                          \
+    ((instance_name)->event_name = ADD_PREFIX(event_list_reset)((void *)(instance_name)->event_name,               \
+                                                               sizeof(*(instance_name)->event_name)),              \
+     SUBSCRIBE_EVENT(class_name, event_name, handler_ID, instance_name))
+
+/* Lists are changed in place: there are no replaced lists to free */
+#define RECLAIM_EVENT(instance_name, event_name) ((void)0)
+
+/* Call the handlers of an event member with the given arguments */
+/* The list is read again on every step, so handlers can subscribe or unsubscribe handlers while the event is raised: */
+/* the handlers don't move when others are unsubscribed, and the empty slots are skipped. */
+#define CLASSYC_CALL_EVENT_HANDLERS(event_member, ...)                                                          \
+    do {                                                                                                        \
+        size_t ADD_PREFIX(index);                                                                               \
+        for (ADD_PREFIX(index) = 0;                                                                             \
+             ADD_PREFIX(index) < ADD_PREFIX(event_list_count)((void *)(event_member));                          \
+             ADD_PREFIX(index)++) {                                                                             \
+            if ((event_member)[ADD_PREFIX(index)]) {                                                            \
+                (event_member)[ADD_PREFIX(index)](__VA_ARGS__);                                                 \
+            }                                                                                                   \
+        }                                                                                                       \
     } while (0)
+#endif /* CLASSYC_ATOMIC_EVENTS */
 
 /* Raise an event: use inside any function: RAISE_EVENT(self, event_name[, args]) */
-/* The event handler is executed if it has been registered (pointer not NULL). */
-#define RAISE_EVENT(instance_name, event_name, ...)                                                      \
-    do {                                                                                                 \
-        if (instance_name->event_name) instance_name->event_name ((void *)instance_name WITHOUT_COMMA(__VA_ARGS__)); \
-    } while (0)
+/* The subscribed handlers are executed in slot order (see SUBSCRIBE_EVENT). Without handlers, it only checks a NULL pointer. */
+#define RAISE_EVENT(instance_name, event_name, ...) \
+    CLASSYC_TRACE_RAISE(event_name, (instance_name)->event_name, \
+    CLASSYC_LATENCY_RAISE(event_name, (instance_name)->event_name, \
+        CLASSYC_CALL_EVENT_HANDLERS((instance_name)->event_name, (void *)(instance_name) WITHOUT_COMMA(__VA_ARGS__))))
 
 /* Raise an event from an interface: use inside any function: RAISE_INTERFACE_EVENT(interface_struct, event_name[, args]) */
 /* As functions manipulating the interface struct may not be aware of the actual class implementing the interface, we need this extra macro. */
 #define RAISE_INTERFACE_EVENT(interface_struct, event_name, ...)                             \
-    /* We need to dereference the pointer to the function pointer stored in the interface */ \
+    /* We need to dereference the pointer to the handler list pointer stored in the interface */ \
     do {                                                                                     \
-        if (interface_struct.event_name && (*interface_struct.event_name)) {                 \
-            (*interface_struct.event_name)(interface_struct.self WITHOUT_COMMA(__VA_ARGS__));            \
+        if (interface_struct.event_name) {                                                   \
+            CLASSYC_TRACE_RAISE(event_name, *interface_struct.event_name,                    \
+            CLASSYC_LATENCY_RAISE(event_name, *interface_struct.event_name,                  \
+                CLASSYC_CALL_EVENT_HANDLERS(*interface_struct.event_name, interface_struct.self WITHOUT_COMMA(__VA_ARGS__)))); \
         }                                                                                    \
     } while (0)
 
+/* INTERFACE REFERENCES */
+/* An interface reference is the object and the interface descriptor of its class: two pointers. */
+/* Reference: interface_name##_ref ref = INTERFACE_REF(object, interface_name); the object expression is evaluated twice */
+#define INTERFACE_REF(instance_name, interface_name) \
+    ((CONCAT(interface_name, _ref)){ (instance_name), GET_INTERFACE_DESC(instance_name, interface_name) })
+/* Call a method: REF_CALL(ref, method_name[, args]) */
+#define REF_CALL(ref, method_name, ...) \
+    ((*(ref).desc->method_name)((ref).self WITHOUT_COMMA(__VA_ARGS__)))
+/* Access a data member (an lvalue): REF_DATA(ref, interface_name, member_name) */
+/* The interface struct is only used to give the member address its type, and is optimized away */
+#define REF_DATA(ref, interface_name, member_name) \
+    (*(interface_name){ .member_name = (void *)((char *)(ref).self + (ref).desc->member_name) }.member_name)
+/* Raise an event: RAISE_REF_EVENT(ref, interface_name, event_name[, args]) */
+#define RAISE_REF_EVENT(ref, interface_name, event_name, ...) \
+    CLASSYC_TRACE_RAISE(event_name, REF_DATA(ref, interface_name, event_name), \
+    CLASSYC_LATENCY_RAISE(event_name, REF_DATA(ref, interface_name, event_name), \
+        CLASSYC_CALL_EVENT_HANDLERS(REF_DATA(ref, interface_name, event_name), (ref).self WITHOUT_COMMA(__VA_ARGS__))))
+
+/* Find the interface descriptor of the class of an object in its interface table. NULL if the class doesn't implement it. */
+/* Interface ids and infos are the ones of the translation unit: the table of a class of another unit is searched by name */
+static CLASSYC_INLINE const void *ADD_PREFIX(query_interface)(const void *object, const ClassyC_interface_info *interface_info,
+                                                             size_t interface_id) {
+    const ClassyC_class_info *class_info = ADD_PREFIX(class_of)(object);
+    bool foreign = class_info->unit != &ADD_PREFIX(translation_unit);
+    size_t index;
+#ifdef CLASSYC_INTERFACE_INDEX
+    /* The entry of the interface is the one at its id, if the class implements it */
+    if (!foreign) {
+        if (interface_id < class_info->interface_count && class_info->interfaces[interface_id].interface == interface_info) {
+            return class_info->interfaces[interface_id].desc;
+        }
+        return NULL;
+    }
+#else
+    (void)interface_id;
+#endif
+    for (index = 0; index < class_info->interface_count; index++) {
+        const ClassyC_interface_info *entry = class_info->interfaces[index].interface;
+        if (entry == interface_info || (foreign && entry && strcmp(entry->name, interface_info->name) == 0)) {
+            return class_info->interfaces[index].desc;
+        }
+    }
+    return NULL;
+}
+/* Query an interface at runtime, for objects of unknown class: interface_name##_ref ref = QUERY_INTERFACE(object, interface_name); */
+/* ref.desc is NULL if the object doesn't implement the interface. The object must not be NULL and is evaluated twice. */
+#define QUERY_INTERFACE(instance_name, interface_name)                                              \
+    ((CONCAT(interface_name, _ref)){ (instance_name),                                               \
+        (const PREFIXCONCAT(interface_name, _desc) *)ADD_PREFIX(query_interface)((instance_name),     \
+            &PREFIXCONCAT(interface_name, _interface_info), PREFIXCONCAT(interface_name, _interface_id)) })
+
+/* BATCH CALLS */
+/* BATCH_CALL and BATCH_REF_CALL call a method over an array of objects of mixed classes, grouped by implementation, */
+/* so consecutive calls have the same target. The array is read in chunks: the method pointer of every element of a */
+/* chunk is read once, the indices are counting-sorted by implementation and the chunk is called group by group. */
+/* The array is not modified, and the elements of a group are called in their order in the array. */
+/* Method pointers are compared as generic function pointers */
+typedef void (*ClassyC_function)(void);
+/* Number of elements grouped together (at most 65536) */
+#ifndef CLASSYC_BATCH_CHUNK
+#define CLASSYC_BATCH_CHUNK 256
+#endif
+/* Implementations grouped in a chunk (at most 255): the elements of any other implementation are called in one more group */
+#ifndef CLASSYC_BATCH_GROUPS
+#define CLASSYC_BATCH_GROUPS 8
+#endif
+/* Group numbers (the rest included) are stored as unsigned char, and indices in the chunk as unsigned short */
+#if CLASSYC_BATCH_CHUNK < 1 || CLASSYC_BATCH_CHUNK > 65536
+    #error "CLASSYC_BATCH_CHUNK must be between 1 and 65536"
+#endif
+#if CLASSYC_BATCH_GROUPS < 1 || CLASSYC_BATCH_GROUPS > 255
+    #error "CLASSYC_BATCH_GROUPS must be between 1 and 255"
+#endif
+typedef struct ClassyC_batch ClassyC_batch;
+struct ClassyC_batch {
+    ClassyC_function keys[CLASSYC_BATCH_GROUPS];    /* Implementation of each group */
+    size_t group_count;                             /* Groups found in the chunk */
+    size_t sizes[CLASSYC_BATCH_GROUPS + 1];         /* Elements of each group, the last one for the rest */
+    unsigned char groups[CLASSYC_BATCH_CHUNK];      /* Group of each element of the chunk */
+    unsigned short order[CLASSYC_BATCH_CHUNK];      /* Indices of the elements of the chunk, sorted by group */
+};
+/* Start a chunk */
+static CLASSYC_INLINE void ADD_PREFIX(batch_begin)(ClassyC_batch *batch) {
+    batch->group_count = 0;
+    memset(batch->sizes, 0, sizeof(batch->sizes));
+}
+/* Put an element of the chunk in the group of its implementation. The search has no data-dependent branches, */
+/* as the implementations of the elements are as unpredictable as the call targets. */
+static CLASSYC_INLINE void ADD_PREFIX(batch_add)(ClassyC_batch *batch, size_t index, ClassyC_function key) {
+    size_t group = batch->group_count, i;
+    for (i = 0; i < batch->group_count; i++) {
+        group = batch->keys[i] == key ? i : group;
+    }
+    if (group == batch->group_count && group < CLASSYC_BATCH_GROUPS) {
+        /* New implementation */
+        batch->keys[group] = key;
+        batch->group_count++;
+    }
+    batch->groups[index] = (unsigned char)group;
+    batch->sizes[group]++;
+}
+/* Sort the indices of the count elements of the chunk by group (counting sort, keeping their order in each group) */
+static CLASSYC_INLINE void ADD_PREFIX(batch_sort)(ClassyC_batch *batch, size_t count) {
+    size_t starts[CLASSYC_BATCH_GROUPS + 1], start = 0, group, i;
+    for (group = 0; group <= CLASSYC_BATCH_GROUPS; group++) {
+        starts[group] = start;
+        start += batch->sizes[group];
+    }
+    for (i = 0; i < count; i++) {
+        batch->order[starts[batch->groups[i]]++] = (unsigned short)i;
+    }
+}
+/* Group the elements by the key of their method (key_macro(element, method_name)) and call them group by group */
+/* (call_macro(element, method_name, args)). The elements expression is evaluated several times. */
+#define CLASSYC_BATCH(elements, count, key_macro, call_macro, method_name, ...)                            \
+    do {                                                                                                    \
+        ClassyC_batch ClassyC_batch_state;                                                                  \
+        size_t ClassyC_batch_count = (count), ClassyC_batch_start, ClassyC_batch_size, ClassyC_batch_i;     \
+        for (ClassyC_batch_start = 0; ClassyC_batch_start < ClassyC_batch_count;                            \
+             ClassyC_batch_start += ClassyC_batch_size) {                                                   \
+            ClassyC_batch_size = ClassyC_batch_count - ClassyC_batch_start < CLASSYC_BATCH_CHUNK ?          \
+                                 ClassyC_batch_count - ClassyC_batch_start : CLASSYC_BATCH_CHUNK;           \
+            ADD_PREFIX(batch_begin)(&ClassyC_batch_state);                                                  \
+            for (ClassyC_batch_i = 0; ClassyC_batch_i < ClassyC_batch_size; ClassyC_batch_i++) {            \
+                ADD_PREFIX(batch_add)(&ClassyC_batch_state, ClassyC_batch_i,                                \
+                    (ClassyC_function)key_macro((elements)[ClassyC_batch_start + ClassyC_batch_i], method_name)); \
+            }                                                                                               \
+            ADD_PREFIX(batch_sort)(&ClassyC_batch_state, ClassyC_batch_size);                               \
+            /* Call the groups: consecutive calls have the same target */                                   \
+            for (ClassyC_batch_i = 0; ClassyC_batch_i < ClassyC_batch_size; ClassyC_batch_i++) {            \
+                call_macro((elements)[ClassyC_batch_start + ClassyC_batch_state.order[ClassyC_batch_i]],    \
+                           method_name, __VA_ARGS__);                                                       \
+            }                                                                                               \
+        }                                                                                                   \
+    } while (0)
+#define CLASSYC_BATCH_OBJECT_KEY(instance_name, method_name) GET_METHOD_PTR(instance_name, method_name)
+#define CLASSYC_BATCH_OBJECT_CALL(instance_name, method_name, ...) \
+    GET_METHOD_PTR(instance_name, method_name)((instance_name) WITHOUT_COMMA(__VA_ARGS__))
+#define CLASSYC_BATCH_REF_KEY(ref, method_name) (*(ref).desc->method_name)
+/* Call a method over an array of object pointers: BATCH_CALL(objects, count, method_name[, args]) */
+#define BATCH_CALL(objects, count, method_name, ...) \
+    CLASSYC_BATCH(objects, count, CLASSYC_BATCH_OBJECT_KEY, CLASSYC_BATCH_OBJECT_CALL, method_name, __VA_ARGS__)
+/* Call a method over an array of interface references: BATCH_REF_CALL(refs, count, method_name[, args]) */
+#define BATCH_REF_CALL(refs, count, method_name, ...) \
+    CLASSYC_BATCH(refs, count, CLASSYC_BATCH_REF_KEY, REF_CALL, method_name, __VA_ARGS__)
+
+/* DEFERRED EVENTS */
+/* RAISE_EVENT_DEFERRED stores the event, the instance and a copy of the arguments in a ring buffer of fixed-size slots, */
+/* allocated once by EVENT_QUEUE_INIT. CLASSYC_DRAIN_EVENTS calls the handlers of the queued events later, in batches. */
+/* The handlers are the ones subscribed when the event is drained, and the instance must still be alive by then. */
+/* The arguments of a queued event are stored aligned for the basic types */
+typedef union ClassyC_event_args ClassyC_event_args;
+union ClassyC_event_args {
+    long double align_long_double;
+    long long align_long_long;
+    void *align_pointer;
+    void (*align_function_pointer)(void);
+};
+typedef struct ClassyC_event_record ClassyC_event_record;
+struct ClassyC_event_record {
+    /* Function generated by DEFERRABLE_EVENT: raises the event with the stored arguments */
+    void (*dispatch)(void *args);
+    /* Instance and arguments of the event */
+    ClassyC_event_args args[];
+};
+typedef struct ClassyC_event_queue ClassyC_event_queue;
+struct ClassyC_event_queue {
+    unsigned char *slots;
+    size_t slot_size;   /* Bytes of a slot: the record and up to max_args_size bytes of arguments */
+    size_t capacity;    /* Number of slots */
+    size_t head;        /* Slot of the oldest queued event */
+    size_t count;       /* Number of queued events */
+    size_t dropped;     /* Events not queued because the queue was full or their arguments didn't fit in a slot */
+    bool undersized;    /* An event was dropped because its arguments didn't fit in a slot (reported once) */
+};
+
+/* Allocate the slots of a queue for capacity events with up to max_args_size bytes of arguments (instance included). */
+/* Size the arguments with DEFERRED_ARGS_SIZE: the stored arguments include the padding between them. */
+static CLASSYC_INLINE bool ADD_PREFIX(event_queue_init)(ClassyC_event_queue *queue, size_t capacity, size_t max_args_size) {
+    queue->slot_size = CLASSYC_ALIGN_UP(sizeof(ClassyC_event_record) + max_args_size, CLASSYC_ALIGNOF(ClassyC_event_args));
+    queue->capacity = capacity;
+    queue->head = 0;
+    queue->count = 0;
+    queue->dropped = 0;
+    queue->undersized = false;
+    queue->slots = capacity && capacity <= SIZE_MAX / queue->slot_size ? (unsigned char *)malloc(capacity * queue->slot_size) : NULL;
+    if (!queue->slots) {
+        queue->capacity = 0;
+        return false;
+    }
+    return true;
+}
+
+/* Free the slots of a queue; the events still queued are discarded */
+static CLASSYC_INLINE void ADD_PREFIX(event_queue_free)(ClassyC_event_queue *queue) {
+    free(queue->slots);
+    queue->slots = NULL;
+    queue->capacity = 0;
+    queue->count = 0;
+}
+
+/* Take the next free slot for an event. Returns where its arguments must be copied, or NULL if the event is dropped. */
+static CLASSYC_INLINE void *ADD_PREFIX(event_queue_push)(ClassyC_event_queue *queue, void (*dispatch)(void *args), size_t args_size) {
+    ClassyC_event_record *record;
+    size_t tail;
+    if (sizeof(ClassyC_event_record) + args_size > queue->slot_size) {
+#ifndef CLASSYC_DISABLE_RUNTIME_CHECKS
+        if (!queue->undersized) {
+            fprintf(stderr, "ClassyC event queue: %zu bytes of event arguments don't fit in its slots of %zu bytes "
+                            "(size it with DEFERRED_ARGS_SIZE)\n", args_size, queue->slot_size - sizeof(ClassyC_event_record));
+        }
+#endif
+        queue->undersized = true;
+        queue->dropped++;
+        return NULL;
+    }
+    if (queue->count == queue->capacity) {
+        queue->dropped++;
+        return NULL;
+    }
+    tail = queue->head + queue->count;
+    if (tail >= queue->capacity) {
+        tail -= queue->capacity;
+    }
+    record = (ClassyC_event_record *)(queue->slots + tail * queue->slot_size);
+    record->dispatch = dispatch;
+    queue->count++;
+    return record->args;
+}
+
+/* Raise up to max_events queued events, oldest first. Returns the number of events raised. */
+/* Handlers can queue new events: they are raised in the same call if max_events allows it. */
+static CLASSYC_INLINE size_t ADD_PREFIX(event_queue_drain)(ClassyC_event_queue *queue, size_t max_events) {
+    size_t raised = 0;
+    while (queue->count && raised < max_events) {
+        ClassyC_event_record *record = (ClassyC_event_record *)(queue->slots + queue->head * queue->slot_size);
+        /* Release the slot first: dispatch copies the arguments before calling any handler */
+        if (++queue->head == queue->capacity) {
+            queue->head = 0;
+        }
+        queue->count--;
+        record->dispatch(record->args);
+        raised++;
+    }
+    return raised;
+}
+
+#define EVENT_QUEUE_INIT(queue, capacity, max_args_size) ADD_PREFIX(event_queue_init)((queue), (capacity), (max_args_size))
+#define EVENT_QUEUE_FREE(queue) ADD_PREFIX(event_queue_free)(queue)
+/* Raise up to max queued events (SIZE_MAX for all of them). Returns the number of events raised. */
+#define CLASSYC_DRAIN_EVENTS(queue, max) ADD_PREFIX(event_queue_drain)((queue), (max))
+
+/* Count the arguments of a macro (0 to 8) */
+#define CLASSYC_COUNT_ARGS_HELPER(_, a1, a2, a3, a4, a5, a6, a7, a8, count, ...) count
+/* (the extra step expands WITHOUT_COMMA before the arguments of the helper are separated) */
+#define CLASSYC_COUNT_ARGS_APPLY(...) CLASSYC_COUNT_ARGS_HELPER(__VA_ARGS__)
+#define CLASSYC_COUNT_ARGS(...) CLASSYC_COUNT_ARGS_APPLY(_ WITHOUT_COMMA(__VA_ARGS__), 8, 7, 6, 5, 4, 3, 2, 1, 0, _)
+/* Members of the stored arguments struct, one per argument type */
+#define CLASSYC_DEFERRED_FIELDS_0()
+#define CLASSYC_DEFERRED_FIELDS_1(t1) t1 a1;
+#define CLASSYC_DEFERRED_FIELDS_2(t1, t2) CLASSYC_DEFERRED_FIELDS_1(t1) t2 a2;
+#define CLASSYC_DEFERRED_FIELDS_3(t1, t2, t3) CLASSYC_DEFERRED_FIELDS_2(t1, t2) t3 a3;
+#define CLASSYC_DEFERRED_FIELDS_4(t1, t2, t3, t4) CLASSYC_DEFERRED_FIELDS_3(t1, t2, t3) t4 a4;
+#define CLASSYC_DEFERRED_FIELDS_5(t1, t2, t3, t4, t5) CLASSYC_DEFERRED_FIELDS_4(t1, t2, t3, t4) t5 a5;
+#define CLASSYC_DEFERRED_FIELDS_6(t1, t2, t3, t4, t5, t6) CLASSYC_DEFERRED_FIELDS_5(t1, t2, t3, t4, t5) t6 a6;
+#define CLASSYC_DEFERRED_FIELDS_7(t1, t2, t3, t4, t5, t6, t7) CLASSYC_DEFERRED_FIELDS_6(t1, t2, t3, t4, t5, t6) t7 a7;
+#define CLASSYC_DEFERRED_FIELDS_8(t1, t2, t3, t4, t5, t6, t7, t8) CLASSYC_DEFERRED_FIELDS_7(t1, t2, t3, t4, t5, t6, t7) t8 a8;
+/* Stored arguments passed to the handlers (with a leading comma) */
+#define CLASSYC_DEFERRED_ARGS_0(args)
+#define CLASSYC_DEFERRED_ARGS_1(args) , args.a1
+#define CLASSYC_DEFERRED_ARGS_2(args) CLASSYC_DEFERRED_ARGS_1(args), args.a2
+#define CLASSYC_DEFERRED_ARGS_3(args) CLASSYC_DEFERRED_ARGS_2(args), args.a3
+#define CLASSYC_DEFERRED_ARGS_4(args) CLASSYC_DEFERRED_ARGS_3(args), args.a4
+#define CLASSYC_DEFERRED_ARGS_5(args) CLASSYC_DEFERRED_ARGS_4(args), args.a5
+#define CLASSYC_DEFERRED_ARGS_6(args) CLASSYC_DEFERRED_ARGS_5(args), args.a6
+#define CLASSYC_DEFERRED_ARGS_7(args) CLASSYC_DEFERRED_ARGS_6(args), args.a7
+#define CLASSYC_DEFERRED_ARGS_8(args) CLASSYC_DEFERRED_ARGS_7(args), args.a8
+
+#define GET_DEFERRED_ARGS_TYPE(class_name, event_name) PREFIXCONCAT(class_name, TRICAT(_, event_name, _deferred_args))
+#define GET_DEFERRED_DISPATCH_FUNC(class_name, event_name) PREFIXCONCAT(class_name, TRICAT(_, event_name, _deferred))
+
+/* Allow an event of the class to be raised with RAISE_EVENT_DEFERRED: DEFERRABLE_EVENT(event_name[, arg_types]) at global scope, after the CONSTRUCTOR */
+/* arg_types are the types of the event arguments (up to 8), without their names. Use typedefs for array or function pointer types. */
+#define DEFERRABLE_EVENT(event_name, ...)                                                                   \
+    typedef struct {                                                                                        \
+        CLASSYC_CLASS_NAME *self;                                                                           \
+        CONCAT(CLASSYC_DEFERRED_FIELDS_, CLASSYC_COUNT_ARGS(__VA_ARGS__))(__VA_ARGS__)                      \
+    } GET_DEFERRED_ARGS_TYPE(CLASSYC_CLASS_NAME, event_name);                                               \
+    static CLASSYC_INLINE void GET_DEFERRED_DISPATCH_FUNC(CLASSYC_CLASS_NAME, event_name)(void *args_void) { \
+        /* Copy the arguments out of the queue slot, as the handlers can queue new events */                \
+        GET_DEFERRED_ARGS_TYPE(CLASSYC_CLASS_NAME, event_name) args;                                        \
+        memcpy(&args, args_void, sizeof(args));                                                             \
+        CLASSYC_CALL_EVENT_HANDLERS(args.self->event_name,                                                  \
+            (void *)args.self CONCAT(CLASSYC_DEFERRED_ARGS_, CLASSYC_COUNT_ARGS(__VA_ARGS__))(args));       \
+    }
+
+/* Bytes of the stored arguments of a deferrable event (instance and padding included), for EVENT_QUEUE_INIT */
+#define DEFERRED_ARGS_SIZE(class_name, event_name) sizeof(GET_DEFERRED_ARGS_TYPE(class_name, event_name))
+
+/* Queue an event to be raised later by CLASSYC_DRAIN_EVENTS: RAISE_EVENT_DEFERRED(queue, class_name, self, event_name[, args]) */
+/* class_name is the class that declared the event as DEFERRABLE_EVENT. If the queue is full, the event is dropped and counted. */
+#define RAISE_EVENT_DEFERRED(queue, class_name, instance_name, event_name, ...)                             \
+    do {                                                                                                    \
+        GET_DEFERRED_ARGS_TYPE(class_name, event_name) ADD_PREFIX(args) =                                   \
+            { (class_name *)(instance_name) WITHOUT_COMMA(__VA_ARGS__) };                                   \
+        void *ADD_PREFIX(slot) = ADD_PREFIX(event_queue_push)((queue),                                      \
+            GET_DEFERRED_DISPATCH_FUNC(class_name, event_name), sizeof(ADD_PREFIX(args)));                  \
+        if (ADD_PREFIX(slot)) {                                                                             \
+            memcpy(ADD_PREFIX(slot), &ADD_PREFIX(args), sizeof(ADD_PREFIX(args)));                          \
+        }                                                                                                   \
+    } while (0)
+
 /* MACROS FOR INSTANCE DECLARATION */
 /* They provide automatic destruction of objects when they go out of scope if the compiler supports cleanup attribute */
 /* Other than that, it might be clearer to declare with normal C syntax*/
@@ -825,12 +4068,48 @@ static CLASSYC_INLINE void PREFIXCONCAT(OBJECT, _user_destructor)(bool is_base,
 /* Stack allocation: AUTODESTROY(Class) obj; NEW_INPLACE(class_name, &obj, ...); */
 #define AUTODESTROY_PTR(class_name)  class_name CLEANUP_ATTRIBUTE(class_name, _ptr_destructor)
 #define AUTODESTROY(class_name)      class_name CLEANUP_ATTRIBUTE(class_name, _destructor)
-#define NEW_ALLOC(class_name, ...)   PREFIXCONCAT(class_name, _user_constructor)(IS_BASE_FALSE, NULL WITHOUT_COMMA(__VA_ARGS__))
+#define NEW_ALLOC(class_name, ...)   PREFIXCONCAT(class_name, _user_constructor)(IS_BASE_FALSE, NULL, CLASSYC_MEMORY_ALLOC WITHOUT_COMMA(__VA_ARGS__))
 #define NEW_INPLACE(class_name, object_address, ...)   \
     /* Sets the already allocated memory zero; needed to avoid undefined values in nested anonymous structs */ \
     memset(object_address, 0, sizeof(class_name));     \
     /* Call the constructor */                        \
-    PREFIXCONCAT(class_name, _user_constructor)(IS_BASE_FALSE, object_address WITHOUT_COMMA(__VA_ARGS__))
+    PREFIXCONCAT(class_name, _user_constructor)(IS_BASE_FALSE, object_address, CLASSYC_MEMORY_INPLACE WITHOUT_COMMA(__VA_ARGS__))
+/* Construction without zeroing the object memory: only the framework members are set, the CONSTRUCTOR must set all the data members */
+/* Heap allocation: Class *ptr = NEW_ALLOC_NOZERO(class_name, ...); */
+#define NEW_ALLOC_NOZERO(class_name, ...) \
+    PREFIXCONCAT(class_name, _user_constructor)(IS_BASE_FALSE, NULL, CLASSYC_MEMORY_ALLOC_NOZERO WITHOUT_COMMA(__VA_ARGS__))
+/* Stack allocation: Class obj; NEW_INPLACE_NOZERO(class_name, &obj, ...); */
+#define NEW_INPLACE_NOZERO(class_name, object_address, ...) \
+    PREFIXCONCAT(class_name, _user_constructor)(IS_BASE_FALSE, object_address, CLASSYC_MEMORY_INPLACE WITHOUT_COMMA(__VA_ARGS__))
+/* Arena allocation: Class *ptr = NEW_IN_ARENA(&arena, class_name, ...); returns NULL if the arena can't allocate memory */
+#define NEW_IN_ARENA(arena, class_name, ...)                                                         \
+    PREFIXCONCAT(class_name, _user_constructor)(IS_BASE_FALSE,                                       \
+        ADD_PREFIX(arena_alloc)((arena), sizeof(class_name), CLASSYC_ALIGNOF(class_name)),           \
+        CLASSYC_MEMORY_INPLACE WITHOUT_COMMA(__VA_ARGS__))
+/* Slot map allocation: ClassyC_handle handle = HANDLE_NEW(class_name, ...); for classes with SLOT_MAP(). */
+/* Returns a null handle (HANDLE_GET gives NULL) if the slot map can't allocate memory. */
+#define HANDLE_NEW(class_name, ...)                                                              \
+    (ADD_PREFIX(slot_map_alloc)(&SLOT_MAP_OF(class_name), sizeof(class_name))                   \
+        ? (void)PREFIXCONCAT(class_name, _user_constructor)(IS_BASE_FALSE,                       \
+            HANDLE_GET(class_name, SLOT_MAP_OF(class_name).last), CLASSYC_MEMORY_INPLACE WITHOUT_COMMA(__VA_ARGS__)) \
+        : (void)0,                                                                               \
+     SLOT_MAP_OF(class_name).last)
+/* Array allocation: Class *array = NEW_ARRAY(class_name, count, ...); creates count objects in one contiguous block. */
+/* The constructor runs for each element, and the arguments are evaluated for each one. Destroy it with DESTROY_ARRAY. */
+/* Returns NULL if count is 0 or the allocation fails. Needs statement expressions (GCC and Clang). */
+#ifdef __GNUC__
+#define NEW_ARRAY(class_name, count, ...) __extension__ ({                                          \
+    size_t ADD_PREFIX(array_count) = (count), ADD_PREFIX(array_index);                              \
+    class_name *ADD_PREFIX(array) = (class_name *)PREFIXCONCAT(class_name, _array_constructor)(     \
+        ADD_PREFIX(array_alloc)(ADD_PREFIX(array_count), sizeof(class_name)), ADD_PREFIX(array_count)); \
+    for (ADD_PREFIX(array_index) = 0; ADD_PREFIX(array) && ADD_PREFIX(array_index) < ADD_PREFIX(array_count); \
+         ADD_PREFIX(array_index)++) {                                                              \
+        PREFIXCONCAT(class_name, _user_constructor)(IS_BASE_FALSE, ADD_PREFIX(array) + ADD_PREFIX(array_index), \
+            CLASSYC_MEMORY_ELEMENT WITHOUT_COMMA(__VA_ARGS__));                                  \
+    }                                                                                               \
+    ADD_PREFIX(array);                                                                              \
+})
+#endif
 
 
 /* MACROS FOR OBJECT DESTRUCTION */
@@ -839,17 +4118,40 @@ static CLASSYC_INLINE void PREFIXCONCAT(OBJECT, _user_destructor)(bool is_base,
     do {                                               \
         if ((obj_name) && ((obj_name)->_destructor)) { \
             (obj_name)->_destructor((obj_name));       \
-            free((obj_name));                          \
+            CLASSYC_FREE_OBJECT((obj_name));           \
             /* Nullifying the pointer to prevent auto-destructor to call free again */ \
             obj_name = NULL;                           \
         }                                              \
     } while (0)
 
+#ifdef CLASSYC_ENABLE_REFCOUNT
+/* Share a heap object: Class *other_owner = RETAIN(ptr); */
+#define RETAIN(obj_name) ADD_PREFIX(object_retain)((obj_name))
+/* Drop a reference and set the pointer to NULL. The last one destroys and frees the object */
+#define RELEASE(obj_name)                              \
+    do {                                               \
+        ADD_PREFIX(object_release)((obj_name));        \
+        obj_name = NULL;                               \
+    } while (0)
+#endif
+
+/* HANDLE_DESTROY destroys the object of a handle and frees its slot: every copy of the handle becomes stale. */
+/* Does nothing if the handle is already stale. */
+#define HANDLE_DESTROY(class_name, handle) \
+    ADD_PREFIX(slot_map_destroy)(&SLOT_MAP_OF(class_name), (handle), sizeof(class_name))
+
+/* DESTROY_ARRAY destroys all the elements of a NEW_ARRAY array, frees its memory and sets the pointer to NULL */
+#define DESTROY_ARRAY(array_name)                                  \
+    do {                                                           \
+        ADD_PREFIX(array_destroy)((array_name), sizeof(*(array_name))); \
+        array_name = NULL;                                         \
+    } while (0)
+
 /* DESTROY macro to call destructor of an object allocated without freeing the memory */
 #define DESTROY(object_name)                                 \
     do {                                                     \
-        if (object_name._destructor) {                       \
-            object_name._destructor((void *)&(object_name)); \
+        if ((object_name)._destructor) {                     \
+            (object_name)._destructor((void *)&(object_name)); \
             /* DESTROY doesn't free the memory.*/            \
             /* It also doesn't set the pointer to NULL, for it receives the object (stack or dereferenced heap) */ \
         }                                                    \
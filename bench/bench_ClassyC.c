@@ -0,0 +1,834 @@
+/* bench_ClassyC.c - Benchmarks of the ClassyC library
+ *
+ * Measures the cost (ns/op) of construction and destruction, method dispatch (dynamic and static), events,
+ * interface casts and inheritance depth. Every benchmark is run a few times to warm up and then
+ * BENCH_REPETITIONS times; the table printed shows the percentiles of the repetitions.
+ * Usage: run_bench [results.json] writes the results also as JSON, to track them over time.
+ * The configuration macros (CLASSYC_SHARED_VTABLE, CLASSYC_ENABLE_POOLS...) can be passed in CFLAGS to compare modes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ClassyC.h"
+
+/* Repetitions of every benchmark: the first ones are discarded */
+#ifndef BENCH_WARMUP_REPETITIONS
+#define BENCH_WARMUP_REPETITIONS 3
+#endif
+#ifndef BENCH_REPETITIONS
+#define BENCH_REPETITIONS 21
+#endif
+/* Operations per repetition: the iterations of each benchmark are multiplied by this factor */
+#ifndef BENCH_SCALE
+#define BENCH_SCALE 1
+#endif
+
+/* Results of a benchmark, in nanoseconds per operation */
+typedef struct BenchResult {
+    const char *name;
+    size_t iterations;
+    double min, p50, p90, p99, max, mean;
+} BenchResult;
+
+/* A benchmark runs the operation being measured iterations times */
+typedef void (*BenchFunction)(size_t iterations);
+typedef struct Benchmark {
+    const char *name;
+    BenchFunction function;
+    size_t iterations;
+    /* Optional: create and free the data of the benchmark once, out of the timed repetitions */
+    void (*setup)(void);
+    void (*teardown)(void);
+} Benchmark;
+
+/* Results are accumulated in bench_sink and objects go through bench_opaque, so the compiler can't remove */
+/* the operations or resolve the method pointers at compile time */
+static volatile long bench_sink;
+static void *volatile bench_opaque;
+#define BENCH_OPAQUE(type, pointer) (bench_opaque = (pointer), (type *)bench_opaque)
+
+/* Monotonic clock if available; otherwise the C11 calendar clock or, as a last resort, the processor clock */
+static double bench_now_ns(void) {
+#if defined(CLOCK_MONOTONIC)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1e9 + (double)now.tv_nsec;
+#elif defined(TIME_UTC)
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec * 1e9 + (double)now.tv_nsec;
+#else
+    return (double)clock() * (1e9 / CLOCKS_PER_SEC);
+#endif
+}
+
+
+
+/* CLASSES */
+#define I_BenchMoveable(Data, Event, Method) \
+    Data(int, position) \
+    Event(on_move, int distance) \
+    Method(int, move, int distance)
+CREATE_INTERFACE(BenchMoveable)
+
+#undef CLASS
+#define CLASS BenchVehicle
+#define CLASS_BenchVehicle(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) Interface(BenchMoveable) \
+    Data(int, position) \
+    Data(int, km_total) \
+    Event(on_move, int distance) \
+    Method(int, move, int distance)
+CONSTRUCTOR(int km_total)
+    self->km_total = km_total;
+END_CONSTRUCTOR
+DESTRUCTOR()
+END_DESTRUCTOR
+METHOD(int, move, int distance)
+    self->position += distance;
+    return self->position;
+END_METHOD
+
+#undef CLASS
+#define CLASS BenchCar
+#define CLASS_BenchCar(Base, Interface, Data, Event, Method, Override) \
+    Base(BenchVehicle) \
+    Data(int, fuel) \
+    Override(int, move, int distance)
+CONSTRUCTOR(int km_total)
+    INIT_BASE(km_total);
+    self->fuel = 100;
+END_CONSTRUCTOR
+DESTRUCTOR()
+END_DESTRUCTOR
+METHOD(int, move, int distance)
+    self->position += distance;
+    self->km_total += distance;
+    return self->position;
+END_METHOD
+
+static long bench_events_received = 0;
+EVENT_HANDLER(BenchCar, on_move, counter, int distance)
+    bench_events_received += distance;
+END_EVENT_HANDLER
+
+/* Inheritance chain of depth 1 to 9: every level adds a data member and overrides get_level */
+#undef CLASS
+#define CLASS BenchDepth1
+#define CLASS_BenchDepth1(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) Data(int, level1) Method(int, get_level)
+CONSTRUCTOR() self->level1 = 1; END_CONSTRUCTOR
+DESTRUCTOR() END_DESTRUCTOR
+METHOD(int, get_level) return self->level1; END_METHOD
+
+#undef CLASS
+#define CLASS BenchDepth2
+#define CLASS_BenchDepth2(Base, Interface, Data, Event, Method, Override) \
+    Base(BenchDepth1) Data(int, level2) Override(int, get_level)
+CONSTRUCTOR() INIT_BASE(); self->level2 = 2; END_CONSTRUCTOR
+DESTRUCTOR() END_DESTRUCTOR
+METHOD(int, get_level) return self->level2; END_METHOD
+
+#undef CLASS
+#define CLASS BenchDepth3
+#define CLASS_BenchDepth3(Base, Interface, Data, Event, Method, Override) \
+    Base(BenchDepth2) Data(int, level3) Override(int, get_level)
+CONSTRUCTOR() INIT_BASE(); self->level3 = 3; END_CONSTRUCTOR
+DESTRUCTOR() END_DESTRUCTOR
+METHOD(int, get_level) return self->level3; END_METHOD
+
+#undef CLASS
+#define CLASS BenchDepth4
+#define CLASS_BenchDepth4(Base, Interface, Data, Event, Method, Override) \
+    Base(BenchDepth3) Data(int, level4) Override(int, get_level)
+CONSTRUCTOR() INIT_BASE(); self->level4 = 4; END_CONSTRUCTOR
+DESTRUCTOR() END_DESTRUCTOR
+METHOD(int, get_level) return self->level4; END_METHOD
+
+#undef CLASS
+#define CLASS BenchDepth5
+#define CLASS_BenchDepth5(Base, Interface, Data, Event, Method, Override) \
+    Base(BenchDepth4) Data(int, level5) Override(int, get_level)
+CONSTRUCTOR() INIT_BASE(); self->level5 = 5; END_CONSTRUCTOR
+DESTRUCTOR() END_DESTRUCTOR
+METHOD(int, get_level) return self->level5; END_METHOD
+
+#undef CLASS
+#define CLASS BenchDepth6
+#define CLASS_BenchDepth6(Base, Interface, Data, Event, Method, Override) \
+    Base(BenchDepth5) Data(int, level6) Override(int, get_level)
+CONSTRUCTOR() INIT_BASE(); self->level6 = 6; END_CONSTRUCTOR
+DESTRUCTOR() END_DESTRUCTOR
+METHOD(int, get_level) return self->level6; END_METHOD
+
+#undef CLASS
+#define CLASS BenchDepth7
+#define CLASS_BenchDepth7(Base, Interface, Data, Event, Method, Override) \
+    Base(BenchDepth6) Data(int, level7) Override(int, get_level)
+CONSTRUCTOR() INIT_BASE(); self->level7 = 7; END_CONSTRUCTOR
+DESTRUCTOR() END_DESTRUCTOR
+METHOD(int, get_level) return self->level7; END_METHOD
+
+#undef CLASS
+#define CLASS BenchDepth8
+#define CLASS_BenchDepth8(Base, Interface, Data, Event, Method, Override) \
+    Base(BenchDepth7) Data(int, level8) Override(int, get_level)
+CONSTRUCTOR() INIT_BASE(); self->level8 = 8; END_CONSTRUCTOR
+DESTRUCTOR() END_DESTRUCTOR
+METHOD(int, get_level) return self->level8; END_METHOD
+
+#undef CLASS
+#define CLASS BenchDepth9
+#define CLASS_BenchDepth9(Base, Interface, Data, Event, Method, Override) \
+    Base(BenchDepth8) Data(int, level9) Override(int, get_level)
+CONSTRUCTOR() INIT_BASE(); self->level9 = 9; END_CONSTRUCTOR
+DESTRUCTOR() END_DESTRUCTOR
+METHOD(int, get_level) return self->level9; END_METHOD
+
+/* Closed hierarchy of shapes, used in mixed-type loops */
+#undef CLASS
+#define CLASS BenchShape
+#define CLASS_BenchShape(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) Data(int, side) Method(int, area) Method(void, add_area, long *total)
+CONSTRUCTOR(int side) self->side = side; END_CONSTRUCTOR
+DESTRUCTOR() END_DESTRUCTOR
+METHOD(int, area) return 0; END_METHOD
+METHOD(void, add_area, long *total) (void)total; END_METHOD
+
+#undef CLASS
+#define CLASS BenchSquare
+#define CLASS_BenchSquare(Base, Interface, Data, Event, Method, Override) \
+    Base(BenchShape) Override(int, area) Override(void, add_area, long *total)
+CONSTRUCTOR(int side) INIT_BASE(side); END_CONSTRUCTOR
+DESTRUCTOR() END_DESTRUCTOR
+METHOD(int, area) return self->side * self->side; END_METHOD
+METHOD(void, add_area, long *total) *total += self->side * self->side; END_METHOD
+
+#undef CLASS
+#define CLASS BenchTriangle
+#define CLASS_BenchTriangle(Base, Interface, Data, Event, Method, Override) \
+    Base(BenchShape) Override(int, area) Override(void, add_area, long *total)
+CONSTRUCTOR(int side) INIT_BASE(side); END_CONSTRUCTOR
+DESTRUCTOR() END_DESTRUCTOR
+METHOD(int, area) return self->side * self->side / 2; END_METHOD
+METHOD(void, add_area, long *total) *total += self->side * self->side / 2; END_METHOD
+
+#undef CLASS
+#define CLASS BenchCircle
+#define CLASS_BenchCircle(Base, Interface, Data, Event, Method, Override) \
+    Base(BenchShape) Override(int, area) Override(void, add_area, long *total)
+CONSTRUCTOR(int side) INIT_BASE(side); END_CONSTRUCTOR
+DESTRUCTOR() END_DESTRUCTOR
+METHOD(int, area) return self->side * self->side * 3; END_METHOD
+METHOD(void, add_area, long *total) *total += self->side * self->side * 3; END_METHOD
+
+#define HIERARCHY_BenchShape(Class) Class(BenchSquare) Class(BenchTriangle) Class(BenchCircle)
+CLOSED_HIERARCHY(BenchShape)
+
+/* Records with rarely used metadata, stored in the objects or in their cold blocks */
+#undef CLASS
+#define CLASS BenchRecordInline
+#define CLASS_BenchRecordInline(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) Data(int, value) Data(char, name[48]) Data(long, created)
+CONSTRUCTOR(int value) self->value = value; END_CONSTRUCTOR
+DESTRUCTOR() END_DESTRUCTOR
+
+#undef CLASS
+#define CLASS BenchRecordCold
+#define CLASS_BenchRecordCold(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) Data(int, value) COLD_DATA(Data, BenchRecordCold)
+#define COLD_BenchRecordCold(ColdData) ColdData(char, name[48]) ColdData(long, created)
+CONSTRUCTOR(int value) self->value = value; END_CONSTRUCTOR
+COLD_BLOCK()
+DESTRUCTOR() END_DESTRUCTOR
+
+/* Particles updated in analytics passes, as objects or as a struct of arrays */
+#undef CLASS
+#define CLASS BenchParticle
+#define CLASS_BenchParticle(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) Data(int, position) Data(int, speed) Data(double, mass) Data(double, charge) Method(int, get_position)
+CONSTRUCTOR(int speed) self->speed = speed; END_CONSTRUCTOR
+DESTRUCTOR() END_DESTRUCTOR
+METHOD(int, get_position) return self->position; END_METHOD
+SOA(BenchParticle)
+
+/* Nodes of a graph, allocated in the heap or kept in a slot map */
+#undef CLASS
+#define CLASS BenchNode
+#define CLASS_BenchNode(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) Data(int, weight) Data(ClassyC_handle, next)
+SLOT_MAP()
+CONSTRUCTOR(int weight) self->weight = weight; END_CONSTRUCTOR
+DESTRUCTOR() END_DESTRUCTOR
+
+
+
+/* BENCHMARKS */
+static void bench_construct_destroy_heap(size_t iterations) {
+    size_t i;
+    for (i = 0; i < iterations; i++) {
+        BenchCar *car = NEW_ALLOC(BenchCar, (int)i);
+        bench_sink += car->fuel;
+        DESTROY_FREE(car);
+    }
+}
+
+static void bench_construct_destroy_inplace(size_t iterations) {
+    size_t i;
+    for (i = 0; i < iterations; i++) {
+        BenchCar car;
+        NEW_INPLACE(BenchCar, BENCH_OPAQUE(BenchCar, &car), (int)i);
+        bench_sink += car.fuel;
+        DESTROY(car);
+    }
+}
+
+static void bench_dispatch_direct(size_t iterations) {
+    BenchCar car;
+    BenchCar *object;
+    size_t i;
+    long sum = 0;
+    NEW_INPLACE(BenchCar, &car, 0);
+    object = BENCH_OPAQUE(BenchCar, &car);
+    for (i = 0; i < iterations; i++) {
+        sum += CALL(object, move, 1);
+    }
+    bench_sink += sum;
+    DESTROY(car);
+}
+
+/* Same call without reading the method pointer: the method can be inlined */
+static void bench_dispatch_static(size_t iterations) {
+    BenchCar car;
+    BenchCar *object;
+    size_t i;
+    long sum = 0;
+    NEW_INPLACE(BenchCar, &car, 0);
+    object = BENCH_OPAQUE(BenchCar, &car);
+    for (i = 0; i < iterations; i++) {
+        sum += CALL_STATIC(BenchCar, move, object, 1);
+    }
+    bench_sink += sum;
+    DESTROY(car);
+}
+
+static void bench_dispatch_base_cast(size_t iterations) {
+    BenchCar car;
+    BenchVehicle *object;
+    size_t i;
+    long sum = 0;
+    NEW_INPLACE(BenchCar, &car, 0);
+    object = BENCH_OPAQUE(BenchVehicle, &car);
+    for (i = 0; i < iterations; i++) {
+        sum += CALL(object, move, 1);
+    }
+    bench_sink += sum;
+    DESTROY(car);
+}
+
+static void bench_dispatch_interface(size_t iterations) {
+    BenchCar car;
+    BenchCar *object;
+    BenchMoveable moveable;
+    size_t i;
+    long sum = 0;
+    NEW_INPLACE(BenchCar, &car, 0);
+    object = BENCH_OPAQUE(BenchCar, &car);
+    moveable = CALL(object, to_BenchMoveable);
+    for (i = 0; i < iterations; i++) {
+        sum += moveable.move(moveable.self, 1);
+    }
+    bench_sink += sum;
+    DESTROY(car);
+}
+
+static void bench_interface_cast(size_t iterations) {
+    BenchCar car;
+    BenchCar *object;
+    size_t i;
+    long sum = 0;
+    NEW_INPLACE(BenchCar, &car, 0);
+    object = BENCH_OPAQUE(BenchCar, &car);
+    for (i = 0; i < iterations; i++) {
+        BenchMoveable moveable = CALL(object, to_BenchMoveable);
+        sum += *moveable.position;
+    }
+    bench_sink += sum;
+    DESTROY(car);
+}
+
+static void bench_dispatch_interface_ref(size_t iterations) {
+    BenchCar car;
+    BenchCar *object;
+    BenchMoveable_ref moveable;
+    size_t i;
+    long sum = 0;
+    NEW_INPLACE(BenchCar, &car, 0);
+    object = BENCH_OPAQUE(BenchCar, &car);
+    moveable = INTERFACE_REF(object, BenchMoveable);
+    for (i = 0; i < iterations; i++) {
+        sum += REF_CALL(moveable, move, 1);
+    }
+    bench_sink += sum;
+    DESTROY(car);
+}
+
+static void bench_interface_ref_cast(size_t iterations) {
+    BenchCar car;
+    BenchCar *object;
+    size_t i;
+    long sum = 0;
+    NEW_INPLACE(BenchCar, &car, 0);
+    object = BENCH_OPAQUE(BenchCar, &car);
+    for (i = 0; i < iterations; i++) {
+        /* Without the function call of to_BenchMoveable, the cast would be hoisted out of the loop */
+        BenchMoveable_ref moveable = INTERFACE_REF(BENCH_OPAQUE(BenchCar, object), BenchMoveable);
+        sum += REF_DATA(moveable, BenchMoveable, position);
+    }
+    bench_sink += sum;
+    DESTROY(car);
+}
+
+static void bench_raise_event(size_t iterations) {
+    BenchCar car;
+    BenchCar *object;
+    size_t i;
+    NEW_INPLACE(BenchCar, &car, 0);
+    object = BENCH_OPAQUE(BenchCar, &car);
+    REGISTER_EVENT(BenchCar, on_move, counter, object);
+    for (i = 0; i < iterations; i++) {
+        RAISE_EVENT(object, on_move, 1);
+    }
+    bench_sink += bench_events_received;
+    DESTROY(car);
+}
+
+static void bench_raise_interface_event(size_t iterations) {
+    BenchCar car;
+    BenchCar *object;
+    BenchMoveable moveable;
+    size_t i;
+    NEW_INPLACE(BenchCar, &car, 0);
+    object = BENCH_OPAQUE(BenchCar, &car);
+    REGISTER_EVENT(BenchCar, on_move, counter, object);
+    moveable = CALL(object, to_BenchMoveable);
+    for (i = 0; i < iterations; i++) {
+        RAISE_INTERFACE_EVENT(moveable, on_move, 1);
+    }
+    bench_sink += bench_events_received;
+    DESTROY(car);
+}
+
+/* Mixed-type loop: the class of every object is pseudo-random, so the branch predictor can't learn the call targets */
+/* (with fewer objects, it learns the sequence of classes repeated by every pass) */
+#define BENCH_SHAPES 4096
+static void bench_shapes_create(BenchShape **shapes) {
+    unsigned int seed = 12345;
+    size_t i;
+    for (i = 0; i < BENCH_SHAPES; i++) {
+        seed = seed * 1103515245u + 12345u;
+        switch ((seed >> 16) % 3) {
+            case 0: shapes[i] = (BenchShape *)NEW_ALLOC(BenchSquare, (int)(i % 7)); break;
+            case 1: shapes[i] = (BenchShape *)NEW_ALLOC(BenchTriangle, (int)(i % 7)); break;
+            default: shapes[i] = (BenchShape *)NEW_ALLOC(BenchCircle, (int)(i % 7)); break;
+        }
+    }
+}
+static void bench_shapes_destroy(BenchShape **shapes) {
+    size_t i;
+    for (i = 0; i < BENCH_SHAPES; i++) {
+        DESTROY_FREE(shapes[i]);
+    }
+}
+
+static void bench_mixed_dispatch_pointer(size_t iterations) {
+    BenchShape *shapes[BENCH_SHAPES];
+    size_t i;
+    long sum = 0;
+    bench_shapes_create(shapes);
+    for (i = 0; i < iterations; i++) {
+        BenchShape *object = shapes[i % BENCH_SHAPES];
+        sum += CALL(object, area);
+    }
+    bench_sink += sum;
+    bench_shapes_destroy(shapes);
+}
+
+/* Same loop, dispatched with the closed hierarchy of the shapes */
+static void bench_mixed_dispatch_closed(size_t iterations) {
+    BenchShape *shapes[BENCH_SHAPES];
+    size_t i;
+    long sum = 0;
+    bench_shapes_create(shapes);
+    for (i = 0; i < iterations; i++) {
+        BenchShape *object = shapes[i % BENCH_SHAPES];
+        sum += CLOSED_CALL(BenchShape, area, object);
+    }
+    bench_sink += sum;
+    bench_shapes_destroy(shapes);
+}
+
+/* Scan loop reading one hot member of every record: with the metadata in cold blocks, more records fit in each cache line */
+/* The records are created by the setup, so only the scans are timed */
+#define BENCH_RECORDS 16384
+static BenchRecordInline *bench_records_inline;
+static BenchRecordCold *bench_records_cold;
+static void bench_records_inline_create(void) {
+    bench_records_inline = NEW_ARRAY(BenchRecordInline, BENCH_RECORDS, 1);
+}
+static void bench_records_inline_destroy(void) {
+    DESTROY_ARRAY(bench_records_inline);
+}
+static void bench_records_cold_create(void) {
+    bench_records_cold = NEW_ARRAY(BenchRecordCold, BENCH_RECORDS, 1);
+}
+static void bench_records_cold_destroy(void) {
+    DESTROY_ARRAY(bench_records_cold);
+}
+
+static void bench_scan_hot_inline(size_t iterations) {
+    BenchRecordInline *records = bench_records_inline;
+    size_t i;
+    long sum = 0;
+    for (i = 0; i < iterations; i++) {
+        sum += records[i % BENCH_RECORDS].value;
+    }
+    bench_sink += sum;
+}
+
+static void bench_scan_hot_cold_split(size_t iterations) {
+    BenchRecordCold *records = bench_records_cold;
+    size_t i;
+    long sum = 0;
+    for (i = 0; i < iterations; i++) {
+        sum += records[i % BENCH_RECORDS].value;
+    }
+    bench_sink += sum;
+}
+
+/* Pass updating one member from another one of every particle (iterations is rounded down to whole passes) */
+#define BENCH_PARTICLES 16384
+static void bench_update_objects(size_t iterations) {
+    BenchParticle *particles = NEW_ARRAY(BenchParticle, BENCH_PARTICLES, 1);
+    size_t pass, i;
+    for (pass = 0; pass < iterations / BENCH_PARTICLES; pass++) {
+        for (i = 0; i < BENCH_PARTICLES; i++) {
+            particles[i].position += particles[i].speed;
+        }
+    }
+    bench_sink += particles[BENCH_PARTICLES - 1].position;
+    DESTROY_ARRAY(particles);
+}
+
+static void bench_update_soa(size_t iterations) {
+    SOA_OF(BenchParticle) particles = { 0 };
+    size_t pass, i;
+    for (i = 0; i < BENCH_PARTICLES; i++) {
+        size_t row = SOA_APPEND(BenchParticle, &particles);
+        particles.speed[row] = 1;
+    }
+    for (pass = 0; pass < iterations / BENCH_PARTICLES; pass++) {
+        /* Local restrict copies of the columns and the count: the stores change neither, so the loop can be vectorized (-O3) */
+        int *restrict position = particles.position;
+        const int *restrict speed = particles.speed;
+        size_t count = particles.count;
+        for (i = 0; i < count; i++) {
+            position[i] += speed[i];
+        }
+    }
+    bench_sink += particles.position[BENCH_PARTICLES - 1];
+    SOA_FREE(BenchParticle, &particles);
+}
+
+/* Whole-population pass over nodes reached through pointers to heap objects, or over the dense block of a slot map */
+/* (iterations is rounded down to whole passes) */
+#define BENCH_NODES 16384
+static void bench_pass_heap_pointers(size_t iterations) {
+    BenchNode **nodes = (BenchNode **)malloc(BENCH_NODES * sizeof(BenchNode *));
+    size_t pass, i;
+    long sum = 0;
+    for (i = 0; i < BENCH_NODES; i++) {
+        nodes[i] = NEW_ALLOC(BenchNode, 1);
+    }
+    for (pass = 0; pass < iterations / BENCH_NODES; pass++) {
+        for (i = 0; i < BENCH_NODES; i++) {
+            sum += nodes[i]->weight;
+        }
+    }
+    bench_sink += sum;
+    for (i = 0; i < BENCH_NODES; i++) {
+        DESTROY_FREE(nodes[i]);
+    }
+    free(nodes);
+}
+
+static void bench_pass_slot_map(size_t iterations) {
+    size_t pass, i;
+    long sum = 0;
+    for (i = 0; i < BENCH_NODES; i++) {
+        (void)HANDLE_NEW(BenchNode, 1);
+    }
+    for (pass = 0; pass < iterations / BENCH_NODES; pass++) {
+        const BenchNode *nodes = SLOT_MAP_OBJECTS(BenchNode);
+        size_t count = SLOT_MAP_COUNT(BenchNode);
+        for (i = 0; i < count; i++) {
+            sum += nodes[i].weight;
+        }
+    }
+    bench_sink += sum;
+    SLOT_MAP_RELEASE(BenchNode);
+}
+
+/* Handle lookups compared to pointer dereferences, in a random order */
+static void bench_lookup_pointer(size_t iterations) {
+    BenchNode **nodes = (BenchNode **)malloc(BENCH_NODES * sizeof(BenchNode *));
+    size_t i;
+    long sum = 0;
+    for (i = 0; i < BENCH_NODES; i++) {
+        nodes[i] = NEW_ALLOC(BenchNode, (int)i);
+    }
+    for (i = 0; i < iterations; i++) {
+        sum += nodes[(i * 7919) % BENCH_NODES]->weight;
+    }
+    bench_sink += sum;
+    for (i = 0; i < BENCH_NODES; i++) {
+        DESTROY_FREE(nodes[i]);
+    }
+    free(nodes);
+}
+
+static void bench_lookup_handle(size_t iterations) {
+    ClassyC_handle *handles = (ClassyC_handle *)malloc(BENCH_NODES * sizeof(ClassyC_handle));
+    size_t i;
+    long sum = 0;
+    for (i = 0; i < BENCH_NODES; i++) {
+        handles[i] = HANDLE_NEW(BenchNode, (int)i);
+    }
+    for (i = 0; i < iterations; i++) {
+        sum += HANDLE_GET(BenchNode, handles[(i * 7919) % BENCH_NODES])->weight;
+    }
+    bench_sink += sum;
+    SLOT_MAP_RELEASE(BenchNode);
+    free(handles);
+}
+
+/* Mixed-type passes calling a method with no result, one object at a time or grouped by implementation */
+/* (iterations is rounded down to whole passes) */
+static void bench_mixed_pass_pointer(size_t iterations) {
+    BenchShape *shapes[BENCH_SHAPES];
+    size_t pass, i;
+    long sum = 0;
+    bench_shapes_create(shapes);
+    for (pass = 0; pass < iterations / BENCH_SHAPES; pass++) {
+        for (i = 0; i < BENCH_SHAPES; i++) {
+            CALL(shapes[i], add_area, &sum);
+        }
+    }
+    bench_sink += sum;
+    bench_shapes_destroy(shapes);
+}
+
+static void bench_mixed_pass_batch(size_t iterations) {
+    BenchShape *shapes[BENCH_SHAPES];
+    size_t pass;
+    long sum = 0;
+    bench_shapes_create(shapes);
+    for (pass = 0; pass < iterations / BENCH_SHAPES; pass++) {
+        BATCH_CALL(shapes, BENCH_SHAPES, add_area, &sum);
+    }
+    bench_sink += sum;
+    bench_shapes_destroy(shapes);
+}
+
+/* Construction and destruction, dispatch through the base class of the chain and type checks, for every inheritance depth */
+#define BENCH_DEPTH_FUNCTIONS(depth)                                                \
+    static void bench_depth##depth##_construct_destroy_heap(size_t iterations) {    \
+        size_t i;                                                                   \
+        for (i = 0; i < iterations; i++) {                                          \
+            BenchDepth##depth *object = NEW_ALLOC(BenchDepth##depth);               \
+            bench_sink += object->level##depth;                                     \
+            DESTROY_FREE(object);                                                   \
+        }                                                                           \
+    }                                                                               \
+    static void bench_depth##depth##_dispatch_base_cast(size_t iterations) {        \
+        BenchDepth##depth derived;                                                  \
+        BenchDepth1 *object;                                                        \
+        size_t i;                                                                   \
+        long sum = 0;                                                               \
+        NEW_INPLACE(BenchDepth##depth, &derived);                                   \
+        object = BENCH_OPAQUE(BenchDepth1, &derived);                               \
+        for (i = 0; i < iterations; i++) {                                          \
+            sum += CALL(object, get_level);                                         \
+        }                                                                           \
+        bench_sink += sum;                                                          \
+        DESTROY(derived);                                                           \
+    }                                                                               \
+    /* Check the deepest class against the class of this depth */                   \
+    static void bench_depth##depth##_is_a(size_t iterations) {                      \
+        BenchDepth9 derived;                                                        \
+        size_t i;                                                                   \
+        long sum = 0;                                                               \
+        NEW_INPLACE(BenchDepth9, &derived);                                         \
+        for (i = 0; i < iterations; i++) {                                          \
+            sum += IS_A(BENCH_OPAQUE(BenchDepth1, &derived), BenchDepth##depth);    \
+        }                                                                           \
+        bench_sink += sum;                                                          \
+        DESTROY(derived);                                                           \
+    }
+BENCH_DEPTH_FUNCTIONS(1)
+BENCH_DEPTH_FUNCTIONS(2)
+BENCH_DEPTH_FUNCTIONS(3)
+BENCH_DEPTH_FUNCTIONS(4)
+BENCH_DEPTH_FUNCTIONS(5)
+BENCH_DEPTH_FUNCTIONS(6)
+BENCH_DEPTH_FUNCTIONS(7)
+BENCH_DEPTH_FUNCTIONS(8)
+BENCH_DEPTH_FUNCTIONS(9)
+
+#define CONSTRUCTION_ITERATIONS (200000 * BENCH_SCALE)
+#define CALL_ITERATIONS (2000000 * BENCH_SCALE)
+/* Passes over whole collections: enough of them to make the setup negligible */
+#define PASS_ITERATIONS (20000000 * BENCH_SCALE)
+#define BENCH_DEPTH_ENTRIES(depth)                                                                                                   \
+    { "depth_" #depth "/construct_destroy_heap", bench_depth##depth##_construct_destroy_heap, CONSTRUCTION_ITERATIONS, NULL, NULL }, \
+    { "depth_" #depth "/dispatch_base_cast", bench_depth##depth##_dispatch_base_cast, CALL_ITERATIONS, NULL, NULL },                 \
+    { "depth_" #depth "/is_a", bench_depth##depth##_is_a, CALL_ITERATIONS, NULL, NULL },
+
+static const Benchmark benchmarks[] = {
+    { "construct_destroy_heap", bench_construct_destroy_heap, CONSTRUCTION_ITERATIONS, NULL, NULL },
+    { "construct_destroy_inplace", bench_construct_destroy_inplace, CONSTRUCTION_ITERATIONS, NULL, NULL },
+    { "dispatch_direct", bench_dispatch_direct, CALL_ITERATIONS, NULL, NULL },
+    { "dispatch_static", bench_dispatch_static, CALL_ITERATIONS, NULL, NULL },
+    { "dispatch_base_cast", bench_dispatch_base_cast, CALL_ITERATIONS, NULL, NULL },
+    { "dispatch_interface", bench_dispatch_interface, CALL_ITERATIONS, NULL, NULL },
+    { "interface_cast", bench_interface_cast, CALL_ITERATIONS, NULL, NULL },
+    { "dispatch_interface_ref", bench_dispatch_interface_ref, CALL_ITERATIONS, NULL, NULL },
+    { "interface_ref_cast", bench_interface_ref_cast, CALL_ITERATIONS, NULL, NULL },
+    { "mixed_dispatch_pointer", bench_mixed_dispatch_pointer, CALL_ITERATIONS, NULL, NULL },
+    { "mixed_dispatch_closed", bench_mixed_dispatch_closed, CALL_ITERATIONS, NULL, NULL },
+    { "mixed_pass_pointer", bench_mixed_pass_pointer, CALL_ITERATIONS, NULL, NULL },
+    { "mixed_pass_batch", bench_mixed_pass_batch, CALL_ITERATIONS, NULL, NULL },
+    { "pass_heap_pointers", bench_pass_heap_pointers, PASS_ITERATIONS, NULL, NULL },
+    { "pass_slot_map", bench_pass_slot_map, PASS_ITERATIONS, NULL, NULL },
+    { "lookup_pointer", bench_lookup_pointer, CALL_ITERATIONS, NULL, NULL },
+    { "lookup_handle", bench_lookup_handle, CALL_ITERATIONS, NULL, NULL },
+    { "scan_hot_inline", bench_scan_hot_inline, CALL_ITERATIONS, bench_records_inline_create, bench_records_inline_destroy },
+    { "scan_hot_cold_split", bench_scan_hot_cold_split, CALL_ITERATIONS, bench_records_cold_create, bench_records_cold_destroy },
+    { "update_objects", bench_update_objects, PASS_ITERATIONS, NULL, NULL },
+    { "update_soa", bench_update_soa, PASS_ITERATIONS, NULL, NULL },
+    { "raise_event", bench_raise_event, CALL_ITERATIONS, NULL, NULL },
+    { "raise_interface_event", bench_raise_interface_event, CALL_ITERATIONS, NULL, NULL },
+    BENCH_DEPTH_ENTRIES(1)
+    BENCH_DEPTH_ENTRIES(2)
+    BENCH_DEPTH_ENTRIES(3)
+    BENCH_DEPTH_ENTRIES(4)
+    BENCH_DEPTH_ENTRIES(5)
+    BENCH_DEPTH_ENTRIES(6)
+    BENCH_DEPTH_ENTRIES(7)
+    BENCH_DEPTH_ENTRIES(8)
+    BENCH_DEPTH_ENTRIES(9)
+};
+#define NUM_BENCHMARKS (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+
+
+/* RUNNER */
+static int bench_compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of sorted samples */
+static double bench_percentile(const double *sorted, size_t count, double percentile) {
+    size_t rank = (size_t)(percentile / 100.0 * (double)count + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+static BenchResult bench_run(const Benchmark *benchmark) {
+    double samples[BENCH_REPETITIONS];
+    double total = 0;
+    BenchResult result;
+    int repetition;
+    if (benchmark->setup) {
+        benchmark->setup();
+    }
+    for (repetition = 0; repetition < BENCH_WARMUP_REPETITIONS; repetition++) {
+        benchmark->function(benchmark->iterations);
+    }
+    for (repetition = 0; repetition < BENCH_REPETITIONS; repetition++) {
+        double start = bench_now_ns();
+        benchmark->function(benchmark->iterations);
+        samples[repetition] = (bench_now_ns() - start) / (double)benchmark->iterations;
+        total += samples[repetition];
+    }
+    if (benchmark->teardown) {
+        benchmark->teardown();
+    }
+    qsort(samples, BENCH_REPETITIONS, sizeof(double), bench_compare_doubles);
+    result.name = benchmark->name;
+    result.iterations = benchmark->iterations;
+    result.min = samples[0];
+    result.p50 = bench_percentile(samples, BENCH_REPETITIONS, 50);
+    result.p90 = bench_percentile(samples, BENCH_REPETITIONS, 90);
+    result.p99 = bench_percentile(samples, BENCH_REPETITIONS, 99);
+    result.max = samples[BENCH_REPETITIONS - 1];
+    result.mean = total / BENCH_REPETITIONS;
+    return result;
+}
+
+static bool bench_write_json(const char *path, const BenchResult *results, size_t count) {
+    size_t i;
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    fprintf(file, "{\n  \"config\": {\n");
+#ifdef CLASSYC_SHARED_VTABLE
+    fprintf(file, "    \"shared_vtable\": true,\n");
+#else
+    fprintf(file, "    \"shared_vtable\": false,\n");
+#endif
+#ifdef CLASSYC_ENABLE_POOLS
+    fprintf(file, "    \"pools\": true,\n");
+#else
+    fprintf(file, "    \"pools\": false,\n");
+#endif
+#ifdef CLASSYC_DISABLE_RUNTIME_CHECKS
+    fprintf(file, "    \"runtime_checks\": false,\n");
+#else
+    fprintf(file, "    \"runtime_checks\": true,\n");
+#endif
+    fprintf(file, "    \"warmup_repetitions\": %d,\n    \"repetitions\": %d\n  },\n", BENCH_WARMUP_REPETITIONS, BENCH_REPETITIONS);
+    fprintf(file, "  \"unit\": \"ns/op\",\n  \"benchmarks\": [\n");
+    for (i = 0; i < count; i++) {
+        const BenchResult *r = &results[i];
+        fprintf(file, "    {\"name\": \"%s\", \"iterations\": %lu, \"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f, \"mean\": %.3f}%s\n",
+                r->name, (unsigned long)r->iterations, r->min, r->p50, r->p90, r->p99, r->max, r->mean, i + 1 < count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0;
+}
+
+int main(int argc, char *argv[]) {
+    BenchResult results[NUM_BENCHMARKS];
+    size_t i;
+    printf("%-36s %12s %10s %10s %10s %10s %10s\n", "benchmark (ns/op)", "iterations", "min", "p50", "p90", "p99", "max");
+    for (i = 0; i < NUM_BENCHMARKS; i++) {
+        results[i] = bench_run(&benchmarks[i]);
+        printf("%-36s %12lu %10.2f %10.2f %10.2f %10.2f %10.2f\n", results[i].name, (unsigned long)results[i].iterations,
+               results[i].min, results[i].p50, results[i].p90, results[i].p99, results[i].max);
+    }
+    if (argc > 1) {
+        if (!bench_write_json(argv[1], results, NUM_BENCHMARKS)) {
+            fprintf(stderr, "Failed to write %s\n", argv[1]);
+            return EXIT_FAILURE;
+        }
+        printf("Results written to %s\n", argv[1]);
+    }
+    return EXIT_SUCCESS;
+}
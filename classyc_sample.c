@@ -2,7 +2,6 @@
 
 #include <stdlib.h>
 #include <stdio.h>
-#include <time.h>
 
 /* Some (optional) macros can be used to configure the library naming conventions
  * In this case, we are using the default ones: CLASS, CLASS_ and I_, so the
@@ -16,8 +15,6 @@
   
 #include "ClassyC.h"
 
-/* Number of objects to create and destroy in the speed test */
-#define TEST_NUM_OBJECTS 1000000ull
 /* We'll count instances created and destroyed to show how auto-destruction works to prevent memory leaks */
 size_t unique_objects_created = 0;
 size_t unique_objects_destroyed = 0;
@@ -70,9 +67,10 @@ END_METHOD
     Data(int, km_total) \
     Data(int, km_since_last_fuel) \
     Event(on_need_fuel, int km_to_collapse) \
-    Method(void, park) \
     Override(int, estimate_price) \
     Override(void, move, int speed, int distance)
+/* No class derives from Car */
+SEALED()
 CONSTRUCTOR(int km_total_when_bought)
     INIT_BASE();
     self->position = 0;
@@ -97,7 +95,8 @@ END_METHOD
 METHOD(int, estimate_price)
     return 15000;
 END_METHOD
-METHOD(void, park)
+/* park is never overridden: it is a final method, called with CALL_FINAL(Car, park, my_car) */
+FINAL_METHOD(void, park)
     self->position = 0;
 END_METHOD
 
@@ -225,37 +224,7 @@ int main(void){
     swap_movables_position(((Vehicle *)my_car)->to_Moveable((Vehicle *)my_car), my_elephant.to_Moveable(&my_elephant)); /* Using the interface for polymorphism */
     printf("Positions ->  (Vehicle *)my_car: %d, my_elephant: %d\n", ((Vehicle *)my_car)->position, my_elephant.position);
 
-    printf("\nCreating a large number of objects in the heap and the stack\n");
-    clock_t start_time = clock();
-    size_t iter;
-    for (iter = 0; iter < TEST_NUM_OBJECTS; iter++) {
-        AUTODESTROY_PTR(Car) *car_heap_object = NEW_ALLOC(Car, rand());
-        if (car_heap_object == NULL) {
-            printf("Memory allocation failed\n");
-            return 1;
-        }
-#if CLASSYC_AUTO_DESTROY_SUPPORTED == 0 
-        /* Compiler doesn't support auto-destruction; destroy the objects manually */
-        DESTROY_FREE(car_heap_object);
-#endif
-    }
-    clock_t end_time = clock();
-    double cpu_time_used = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
-    printf("Time taken to create and destroy %llu objects of size %d in the heap: %f seconds. (%.2f objects/second)\n", TEST_NUM_OBJECTS, (int)sizeof(Car), cpu_time_used, TEST_NUM_OBJECTS / cpu_time_used);
-
-    start_time = clock();
-    for (iter = 0; iter < TEST_NUM_OBJECTS; iter++) {
-        AUTODESTROY(Car) car_stack_object;
-        NEW_INPLACE(Car, &car_stack_object, rand());
-
-#if CLASSYC_AUTO_DESTROY_SUPPORTED == 0
-        /* Compiler doesn't support auto-destruction; destroy the objects manually */
-        DESTROY(car_stack_object);
-#endif
-    }
-    end_time = clock();
-    cpu_time_used = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
-    printf("Time taken to create and destroy %llu objects of size %d in the stack: %f seconds. (%.2f objects/second)\n", TEST_NUM_OBJECTS, (int)sizeof(Car), cpu_time_used, TEST_NUM_OBJECTS / cpu_time_used);
+    /* For performance measurements of object creation, method calls and events, see the benchmarks in the bench folder */
 
 #if CLASSYC_AUTO_DESTROY_SUPPORTED == 0
     /* Compiler doesn't support auto-destruction; destroy the objects manually */
@@ -285,6 +285,1188 @@ void test_AutoDestructionManualDestruct(void) {
 
 
 
+/* Test Case: Arena allocation and bulk reset */
+#undef CLASS
+#define CLASS ArenaObject
+#define CLASS_ArenaObject(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(int, id) \
+    Data(long double, payload) \
+    Method(int, get_id)
+
+CONSTRUCTOR(int id)
+    self->id = id;
+END_CONSTRUCTOR
+
+static int arena_destroyed_ids[16];
+static int arena_destruct_calls = 0;
+DESTRUCTOR()
+    arena_destroyed_ids[arena_destruct_calls++] = self->id;
+END_DESTRUCTOR
+
+METHOD(int, get_id)
+    return self->id;
+END_METHOD
+
+void test_ArenaAllocationAndReset(void) {
+    ClassyC_arena arena, *arenas[2] = { NULL, NULL };
+    ArenaObject *objects[6];
+    int i, arena_index = 0;
+    arena_destruct_calls = 0;
+    /* Small blocks: the objects span several blocks */
+    ARENA_INIT(&arena, 2 * sizeof(ArenaObject));
+    for (i = 0; i < 6; i++) {
+        objects[i] = NEW_IN_ARENA(&arena, ArenaObject, i);
+        TEST_ASSERT_NOT_NULL(objects[i]);
+        TEST_ASSERT_EQUAL_INT(0, (int)((uintptr_t)objects[i] % CLASSYC_ALIGNOF(ArenaObject)));
+        TEST_ASSERT_EQUAL_INT(i, objects[i]->get_id(objects[i]));
+        TEST_ASSERT_EQUAL_INT(0, (int)objects[i]->payload);
+    }
+    /* Objects destroyed before the reset are not destroyed again */
+    DESTROY(*objects[2]);
+    TEST_ASSERT_EQUAL_INT(1, arena_destruct_calls);
+
+    ARENA_RESET(&arena);
+    TEST_ASSERT_EQUAL_INT(6, arena_destruct_calls);
+    TEST_ASSERT_EQUAL_INT(5, arena_destroyed_ids[1]);
+    TEST_ASSERT_EQUAL_INT(4, arena_destroyed_ids[2]);
+    TEST_ASSERT_EQUAL_INT(3, arena_destroyed_ids[3]);
+    TEST_ASSERT_EQUAL_INT(1, arena_destroyed_ids[4]);
+    TEST_ASSERT_EQUAL_INT(0, arena_destroyed_ids[5]);
+    TEST_ASSERT_NULL(arena.blocks);
+
+    /* The arena can be used again after a reset (and the arena argument is evaluated once) */
+    arenas[0] = &arena;
+    objects[0] = NEW_IN_ARENA(arenas[arena_index++], ArenaObject, 7);
+    TEST_ASSERT_EQUAL_INT(1, arena_index);
+    TEST_ASSERT_NOT_NULL(objects[0]);
+    TEST_ASSERT_EQUAL_INT(7, objects[0]->id);
+    ARENA_RESET(&arena);
+    TEST_ASSERT_EQUAL_INT(7, arena_destroyed_ids[6]);
+}
+
+
+
+
+/* Test Case: Contiguous object arrays */
+#undef CLASS
+#define CLASS ArrayElement
+#define CLASS_ArrayElement(Base, Interface, Data, Event, Method, Override) \
+    Base(BaseClass) \
+    Data(int, index) \
+    Data(bool, even) \
+    Override(int, get_overridable_value)
+
+static int array_constructed = 0;
+CONSTRUCTOR(int base_initial)
+    INIT_BASE(base_initial);
+    if (!is_base) self->index = array_constructed++;
+    /* A return only ends the construction of the current element */
+    if (self->index % 2) return self;
+    self->even = true;
+END_CONSTRUCTOR
+
+static int array_destructed = 0;
+DESTRUCTOR()
+    if (!is_base) array_destructed++;
+END_DESTRUCTOR
+
+METHOD(int, get_overridable_value)
+    return 10 + self->index;
+END_METHOD
+
+void test_ArrayConstructionAndDestruction(void) {
+    int i;
+    array_constructed = 0;
+    array_destructed = 0;
+    ArrayElement *array = NEW_ARRAY(ArrayElement, 5, 42);
+    TEST_ASSERT_NOT_NULL(array);
+    TEST_ASSERT_EQUAL_INT(5, array_constructed);
+    for (i = 0; i < 5; i++) {
+        BaseClass *as_base = (BaseClass *)&array[i];
+        TEST_ASSERT_EQUAL_INT(i, array[i].index);
+        TEST_ASSERT_EQUAL_INT(42, array[i].get_base_value(&array[i]));
+        TEST_ASSERT_EQUAL_INT(10 + i, as_base->get_overridable_value(as_base));
+        TEST_ASSERT_EQUAL_INT(1, array[i].get_incremental_value(&array[i]));
+        TEST_ASSERT_EQUAL(i % 2 == 0, array[i].even);
+    }
+    /* Elements destroyed before the array are not destroyed again */
+    DESTROY(array[3]);
+    TEST_ASSERT_EQUAL_INT(1, array_destructed);
+    DESTROY_ARRAY(array);
+    TEST_ASSERT_NULL(array);
+    TEST_ASSERT_EQUAL_INT(5, array_destructed);
+
+    array = NEW_ARRAY(ArrayElement, 0, 42);
+    TEST_ASSERT_NULL(array);
+    DESTROY_ARRAY(array);
+}
+
+
+
+
+/* Test Case: Construction without zeroing the object memory */
+#undef CLASS
+#define CLASS NoZeroObject
+#define CLASS_NoZeroObject(Base, Interface, Data, Event, Method, Override) \
+    Base(BaseClass) \
+    Data(int, value) \
+    Data(unsigned char, buffer[256]) \
+    Event(on_value_read) \
+    Method(int, read_value)
+
+CONSTRUCTOR(int initial_value)
+    INIT_BASE(initial_value);
+    self->value = initial_value;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(int, read_value)
+    RAISE_EVENT(self, on_value_read);
+    return self->value;
+END_METHOD
+
+void test_NoZeroConstruction(void) {
+    NoZeroObject stack_obj;
+    memset(&stack_obj, 0xAB, sizeof(stack_obj));
+    NEW_INPLACE_NOZERO(NoZeroObject, &stack_obj, 7);
+    /* The framework members are set and the events are unregistered */
+    TEST_ASSERT_NULL(stack_obj.on_value_read);
+    TEST_ASSERT_EQUAL_INT(7, stack_obj.read_value(&stack_obj));
+    TEST_ASSERT_EQUAL_INT(7, stack_obj.get_base_value(&stack_obj));
+    TEST_ASSERT_EQUAL_INT(1, stack_obj.get_incremental_value(&stack_obj));
+    /* The data members not set by the constructor are left untouched */
+    TEST_ASSERT_EQUAL_HEX8(0xAB, stack_obj.buffer[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xAB, stack_obj.buffer[255]);
+    DESTROY(stack_obj);
+
+    NoZeroObject *heap_obj = NEW_ALLOC_NOZERO(NoZeroObject, 9);
+    TEST_ASSERT_NOT_NULL(heap_obj);
+    TEST_ASSERT_NULL(heap_obj->on_value_read);
+    TEST_ASSERT_EQUAL_INT(9, heap_obj->read_value(heap_obj));
+    DESTROY_FREE(heap_obj);
+    TEST_ASSERT_NULL(heap_obj);
+}
+
+
+
+
+/* Test Case: Multicast events */
+#define I_Notifier(Data, Event, Method) \
+    Event(on_notify, int value)
+CREATE_INTERFACE(Notifier)
+
+#undef CLASS
+#define CLASS MulticastClass
+#define CLASS_MulticastClass(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) Interface(Notifier) \
+    Event(on_notify, int value)
+
+CONSTRUCTOR()
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+static char multicast_log[16];
+static int multicast_log_length = 0;
+static int multicast_sum = 0;
+EVENT_HANDLER(MulticastClass, on_notify, metrics, int value)
+    multicast_log[multicast_log_length++] = 'm';
+    multicast_sum += value;
+END_EVENT_HANDLER
+EVENT_HANDLER(MulticastClass, on_notify, audit, int value)
+    multicast_log[multicast_log_length++] = 'a';
+    multicast_sum += value;
+END_EVENT_HANDLER
+EVENT_HANDLER(MulticastClass, on_notify, logic, int value)
+    multicast_log[multicast_log_length++] = 'l';
+    multicast_sum += value;
+END_EVENT_HANDLER
+
+static void multicast_reset(void) {
+    memset(multicast_log, 0, sizeof(multicast_log));
+    multicast_log_length = 0;
+    multicast_sum = 0;
+}
+
+void test_MulticastEvents(void) {
+    AUTODESTROY_PTR(MulticastClass) *obj = NEW_ALLOC(MulticastClass);
+    TEST_ASSERT_NOT_NULL(obj);
+    /* Without subscribers the event is a NULL pointer and raising it does nothing */
+    TEST_ASSERT_NULL(obj->on_notify);
+    multicast_reset();
+    RAISE_EVENT(obj, on_notify, 1);
+    TEST_ASSERT_EQUAL_INT(0, multicast_log_length);
+
+    /* Handlers run in subscription order, also through the interface */
+    SUBSCRIBE_EVENT(MulticastClass, on_notify, metrics, obj);
+    SUBSCRIBE_EVENT(MulticastClass, on_notify, audit, obj);
+    SUBSCRIBE_EVENT(MulticastClass, on_notify, logic, obj);
+    RAISE_EVENT(obj, on_notify, 2);
+    TEST_ASSERT_EQUAL_STRING("mal", multicast_log);
+    TEST_ASSERT_EQUAL_INT(6, multicast_sum);
+    Notifier notifier = obj->to_Notifier(obj);
+    multicast_reset();
+    RAISE_INTERFACE_EVENT(notifier, on_notify, 1);
+    TEST_ASSERT_EQUAL_STRING("mal", multicast_log);
+
+    /* Unsubscribing keeps the other handlers in their slots */
+    UNSUBSCRIBE_EVENT(MulticastClass, on_notify, audit, obj);
+    multicast_reset();
+    RAISE_EVENT(obj, on_notify, 1);
+    TEST_ASSERT_EQUAL_STRING("ml", multicast_log);
+
+    /* REGISTER_EVENT replaces all the handlers */
+    REGISTER_EVENT(MulticastClass, on_notify, audit, obj);
+    multicast_reset();
+    RAISE_INTERFACE_EVENT(notifier, on_notify, 1);
+    TEST_ASSERT_EQUAL_STRING("a", multicast_log);
+
+    /* The list is freed when the last handler is unsubscribed */
+    UNSUBSCRIBE_EVENT(MulticastClass, on_notify, audit, obj);
+    TEST_ASSERT_NULL(obj->on_notify);
+    SUBSCRIBE_EVENT(MulticastClass, on_notify, logic, obj);
+    SUBSCRIBE_EVENT(MulticastClass, on_notify, metrics, obj);
+    CLEAR_EVENT(obj, on_notify);
+    TEST_ASSERT_NULL(obj->on_notify);
+    multicast_reset();
+    RAISE_INTERFACE_EVENT(notifier, on_notify, 1);
+    TEST_ASSERT_EQUAL_INT(0, multicast_log_length);
+
+    /* Lists still holding handlers are freed by the destructor */
+    SUBSCRIBE_EVENT(MulticastClass, on_notify, logic, obj);
+}
+
+/* A handler that unsubscribes itself by its subscription ID while the event is raised */
+static ClassyC_subscription multicast_once_id = CLASSYC_NO_SUBSCRIPTION;
+EVENT_HANDLER(MulticastClass, on_notify, once, int value)
+    multicast_log[multicast_log_length++] = 'o';
+    multicast_sum += value;
+    UNSUBSCRIBE_EVENT_ID(self, on_notify, multicast_once_id);
+END_EVENT_HANDLER
+
+void test_EventSubscriptions(void) {
+    AUTODESTROY_PTR(MulticastClass) *obj = NEW_ALLOC(MulticastClass);
+    ClassyC_subscription metrics_id, logic_id;
+    TEST_ASSERT_NOT_NULL(obj);
+
+    /* Subscriptions return their slot */
+    metrics_id = SUBSCRIBE_EVENT(MulticastClass, on_notify, metrics, obj);
+    multicast_once_id = SUBSCRIBE_EVENT(MulticastClass, on_notify, once, obj);
+    logic_id = SUBSCRIBE_EVENT(MulticastClass, on_notify, logic, obj);
+    TEST_ASSERT_EQUAL_size_t(0, metrics_id);
+    TEST_ASSERT_EQUAL_size_t(1, multicast_once_id);
+    TEST_ASSERT_EQUAL_size_t(2, logic_id);
+
+    /* The handler after the one unsubscribing itself is still called */
+    multicast_reset();
+    RAISE_EVENT(obj, on_notify, 1);
+    TEST_ASSERT_EQUAL_STRING("mol", multicast_log);
+    multicast_reset();
+    RAISE_EVENT(obj, on_notify, 1);
+    TEST_ASSERT_EQUAL_STRING("ml", multicast_log);
+
+    /* The next subscription reuses the free slot */
+    TEST_ASSERT_EQUAL_size_t(1, SUBSCRIBE_EVENT(MulticastClass, on_notify, audit, obj));
+    multicast_reset();
+    RAISE_EVENT(obj, on_notify, 1);
+    TEST_ASSERT_EQUAL_STRING("mal", multicast_log);
+
+    /* Unsubscribing by ID, twice or a free slot does nothing */
+    UNSUBSCRIBE_EVENT_ID(obj, on_notify, metrics_id);
+    UNSUBSCRIBE_EVENT_ID(obj, on_notify, metrics_id);
+    UNSUBSCRIBE_EVENT_ID(obj, on_notify, 10);
+    multicast_reset();
+    RAISE_EVENT(obj, on_notify, 1);
+    TEST_ASSERT_EQUAL_STRING("al", multicast_log);
+
+    /* REGISTER_EVENT reuses the list of the handlers it replaces */
+    TEST_ASSERT_EQUAL_size_t(0, REGISTER_EVENT(MulticastClass, on_notify, logic, obj));
+    multicast_reset();
+    RAISE_EVENT(obj, on_notify, 1);
+    TEST_ASSERT_EQUAL_STRING("l", multicast_log);
+
+    /* The list is freed when the handler unsubscribing itself is the last one */
+    multicast_once_id = REGISTER_EVENT(MulticastClass, on_notify, once, obj);
+    multicast_reset();
+    RAISE_EVENT(obj, on_notify, 1);
+    TEST_ASSERT_EQUAL_STRING("o", multicast_log);
+    TEST_ASSERT_NULL(obj->on_notify);
+}
+
+
+
+
+/* Test Case: Deferred events */
+#undef CLASS
+#define CLASS DeferredClass
+#define CLASS_DeferredClass(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(int, total) \
+    Event(on_value, int value, double weight) \
+    Event(on_ping)
+
+CONSTRUCTOR()
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+DEFERRABLE_EVENT(on_value, int, double)
+DEFERRABLE_EVENT(on_ping)
+
+static ClassyC_event_queue deferred_queue;
+EVENT_HANDLER(DeferredClass, on_value, accumulate, int value, double weight)
+    self->total += value * (int)weight;
+END_EVENT_HANDLER
+EVENT_HANDLER(DeferredClass, on_ping, requeue)
+    /* Handlers can queue new events while the queue is drained */
+    RAISE_EVENT_DEFERRED(&deferred_queue, DeferredClass, self, on_value, 100, 1.0);
+END_EVENT_HANDLER
+
+void test_DeferredEvents(void) {
+    AUTODESTROY(DeferredClass) obj;
+    int i;
+    NEW_INPLACE(DeferredClass, &obj);
+    SUBSCRIBE_EVENT(DeferredClass, on_value, accumulate, &obj);
+    SUBSCRIBE_EVENT(DeferredClass, on_ping, requeue, &obj);
+    TEST_ASSERT_TRUE(EVENT_QUEUE_INIT(&deferred_queue, 4, DEFERRED_ARGS_SIZE(DeferredClass, on_value)));
+
+    /* Events are only raised when the queue is drained, in batches */
+    RAISE_EVENT_DEFERRED(&deferred_queue, DeferredClass, &obj, on_value, 1, 2.0);
+    RAISE_EVENT_DEFERRED(&deferred_queue, DeferredClass, &obj, on_value, 3, 2.0);
+    RAISE_EVENT_DEFERRED(&deferred_queue, DeferredClass, &obj, on_value, 5, 2.0);
+    TEST_ASSERT_EQUAL_INT(0, obj.total);
+    TEST_ASSERT_EQUAL_size_t(2, CLASSYC_DRAIN_EVENTS(&deferred_queue, 2));
+    TEST_ASSERT_EQUAL_INT(8, obj.total);
+    TEST_ASSERT_EQUAL_size_t(1, CLASSYC_DRAIN_EVENTS(&deferred_queue, SIZE_MAX));
+    TEST_ASSERT_EQUAL_INT(18, obj.total);
+    TEST_ASSERT_EQUAL_size_t(0, CLASSYC_DRAIN_EVENTS(&deferred_queue, SIZE_MAX));
+
+    /* Events queued by handlers are raised in the same drain */
+    RAISE_EVENT_DEFERRED(&deferred_queue, DeferredClass, &obj, on_ping);
+    TEST_ASSERT_EQUAL_size_t(2, CLASSYC_DRAIN_EVENTS(&deferred_queue, SIZE_MAX));
+    TEST_ASSERT_EQUAL_INT(118, obj.total);
+
+    /* When the queue is full, events are dropped and counted; the ring buffer wraps around */
+    for (i = 0; i < 6; i++) {
+        RAISE_EVENT_DEFERRED(&deferred_queue, DeferredClass, &obj, on_value, 1, 1.0);
+    }
+    TEST_ASSERT_EQUAL_size_t(2, deferred_queue.dropped);
+    TEST_ASSERT_EQUAL_size_t(4, CLASSYC_DRAIN_EVENTS(&deferred_queue, SIZE_MAX));
+    TEST_ASSERT_EQUAL_INT(122, obj.total);
+    EVENT_QUEUE_FREE(&deferred_queue);
+
+    /* The stored arguments include their padding: a queue sized by adding the argument sizes can be too small */
+    TEST_ASSERT_TRUE(DEFERRED_ARGS_SIZE(DeferredClass, on_value) >= sizeof(DeferredClass *) + sizeof(int) + sizeof(double));
+    TEST_ASSERT_TRUE(EVENT_QUEUE_INIT(&deferred_queue, 4, sizeof(DeferredClass *)));
+    RAISE_EVENT_DEFERRED(&deferred_queue, DeferredClass, &obj, on_ping);
+    TEST_ASSERT_FALSE(deferred_queue.undersized);
+    RAISE_EVENT_DEFERRED(&deferred_queue, DeferredClass, &obj, on_value, 1, 1.0);
+    RAISE_EVENT_DEFERRED(&deferred_queue, DeferredClass, &obj, on_value, 1, 1.0);
+    TEST_ASSERT_TRUE(deferred_queue.undersized);
+    TEST_ASSERT_EQUAL_size_t(2, deferred_queue.dropped);
+    TEST_ASSERT_EQUAL_size_t(1, deferred_queue.count);
+    EVENT_QUEUE_FREE(&deferred_queue);
+}
+
+
+
+
+
+/* Test Case: Interface references */
+#define I_Gauge(Data, Event, Method) \
+    Data(int, level) \
+    Event(on_level, int level) \
+    Method(int, read_level)
+CREATE_INTERFACE(Gauge)
+
+#undef CLASS
+#define CLASS GaugeBase
+#define CLASS_GaugeBase(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) Interface(Gauge) \
+    Data(char, tag) \
+    Data(int, level) \
+    Event(on_level, int level) \
+    Method(int, read_level)
+
+CONSTRUCTOR(int level)
+    self->level = level;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(int, read_level)
+    return self->level;
+END_METHOD
+
+#undef CLASS
+#define CLASS GaugeDerived
+#define CLASS_GaugeDerived(Base, Interface, Data, Event, Method, Override) \
+    Base(GaugeBase) \
+    Data(int, scale) \
+    Override(int, read_level)
+
+CONSTRUCTOR(int level, int scale)
+    INIT_BASE(level);
+    self->scale = scale;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(int, read_level)
+    return self->level * self->scale;
+END_METHOD
+
+static int gauge_level_received = 0;
+EVENT_HANDLER(GaugeBase, on_level, store_level, int level)
+    (void)self;
+    gauge_level_received = level;
+END_EVENT_HANDLER
+
+void test_InterfaceReferences(void) {
+    AUTODESTROY(GaugeBase) base_obj;
+    AUTODESTROY(GaugeBase) other_base_obj;
+    AUTODESTROY(GaugeDerived) derived_obj;
+    NEW_INPLACE(GaugeBase, &base_obj, 3);
+    NEW_INPLACE(GaugeBase, &other_base_obj, 4);
+    NEW_INPLACE(GaugeDerived, &derived_obj, 5, 10);
+
+    /* The objects of a class share their descriptor */
+    Gauge_ref base_ref = INTERFACE_REF(&base_obj, Gauge);
+    TEST_ASSERT_EQUAL_PTR(&base_obj, base_ref.self);
+    TEST_ASSERT_EQUAL_PTR(base_ref.desc, INTERFACE_REF(&other_base_obj, Gauge).desc);
+    TEST_ASSERT_EQUAL_INT(3, REF_CALL(base_ref, read_level));
+
+    /* Through a base class pointer, the reference uses the descriptor of the actual class */
+    GaugeBase *derived_as_base = (GaugeBase *)&derived_obj;
+    Gauge_ref derived_ref = INTERFACE_REF(derived_as_base, Gauge);
+    TEST_ASSERT_NOT_EQUAL(base_ref.desc, derived_ref.desc);
+    TEST_ASSERT_EQUAL_INT(50, REF_CALL(derived_ref, read_level));
+    /* Descriptors are constant data of their class, with the slots of its static method table */
+    TEST_ASSERT_EQUAL_PTR(&ClassyC_GaugeDerived_class_info, derived_ref.desc->_class);
+    TEST_ASSERT_EQUAL_PTR(&ClassyC_GaugeDerived_static_vtable.read_level, derived_ref.desc->read_level);
+
+    /* Data members are accessed through their offsets */
+    TEST_ASSERT_EQUAL_INT(5, REF_DATA(derived_ref, Gauge, level));
+    REF_DATA(derived_ref, Gauge, level) = 6;
+    TEST_ASSERT_EQUAL_INT(6, derived_obj.level);
+    TEST_ASSERT_EQUAL_INT(6, *derived_obj.to_Gauge(&derived_obj).level);
+
+    /* Events too */
+    SUBSCRIBE_EVENT(GaugeBase, on_level, store_level, &base_obj);
+    RAISE_REF_EVENT(base_ref, Gauge, on_level, 7);
+    TEST_ASSERT_EQUAL_INT(7, gauge_level_received);
+    RAISE_REF_EVENT(derived_ref, Gauge, on_level, 8);
+    TEST_ASSERT_EQUAL_INT(7, gauge_level_received);
+}
+
+
+
+
+
+/* Test Case: Type descriptors and checked casts */
+void test_TypeChecks(void) {
+    AUTODESTROY(BaseClass) base_obj;
+    AUTODESTROY(DerivedClass) derived_obj;
+    AUTODESTROY(TestObject) other_obj;
+    NEW_INPLACE(BaseClass, &base_obj, 1);
+    NEW_INPLACE(DerivedClass, &derived_obj, 2, 3);
+    NEW_INPLACE(TestObject, &other_obj, 4);
+
+    /* Descriptors record the class name, size, depth and ancestors */
+    TEST_ASSERT_EQUAL_PTR(CLASS_INFO(DerivedClass), CLASS_OF(&derived_obj));
+    TEST_ASSERT_EQUAL_STRING("DerivedClass", CLASS_OF(&derived_obj)->name);
+    TEST_ASSERT_EQUAL_size_t(sizeof(DerivedClass), CLASS_INFO(DerivedClass)->size);
+    TEST_ASSERT_EQUAL_INT(1, CLASS_INFO(OBJECT)->depth);
+    TEST_ASSERT_EQUAL_INT(2, CLASS_INFO(BaseClass)->depth);
+    TEST_ASSERT_EQUAL_INT(3, CLASS_INFO(DerivedClass)->depth);
+    TEST_ASSERT_EQUAL_PTR(CLASS_INFO(BaseClass), CLASS_INFO(DerivedClass)->ancestors[2]);
+    TEST_ASSERT_EQUAL_PTR(CLASS_INFO(OBJECT), CLASS_INFO(DerivedClass)->ancestors[1]);
+
+    /* The actual class is kept when the object is used through a base class pointer */
+    BaseClass *derived_as_base = (BaseClass *)&derived_obj;
+    TEST_ASSERT_EQUAL_STRING("DerivedClass", CLASS_OF(derived_as_base)->name);
+    TEST_ASSERT_TRUE(IS_A(derived_as_base, DerivedClass));
+    TEST_ASSERT_TRUE(IS_A(derived_as_base, BaseClass));
+    TEST_ASSERT_TRUE(IS_A(derived_as_base, OBJECT));
+    TEST_ASSERT_FALSE(IS_A(&base_obj, DerivedClass));
+    TEST_ASSERT_FALSE(IS_A(&other_obj, BaseClass));
+
+    TEST_ASSERT_EQUAL_PTR(&derived_obj, DYNAMIC_CAST(derived_as_base, DerivedClass));
+    TEST_ASSERT_NULL(DYNAMIC_CAST(&base_obj, DerivedClass));
+    TEST_ASSERT_NULL(DYNAMIC_CAST((BaseClass *)NULL, BaseClass));
+
+    /* Arrays and objects constructed without zeroing also get their descriptor */
+    BaseClass *array = NEW_ARRAY(BaseClass, 3, 5);
+    TEST_ASSERT_TRUE(IS_A(&array[2], BaseClass));
+    DESTROY_ARRAY(array);
+    DerivedClass *nozero = NEW_ALLOC_NOZERO(DerivedClass, 6, 7);
+    TEST_ASSERT_TRUE(IS_A(nozero, BaseClass));
+    DESTROY_FREE(nozero);
+}
+
+
+
+
+
+/* Test Case: Runtime interface queries */
+void test_QueryInterface(void) {
+    AUTODESTROY(GaugeDerived) gauge_obj;
+    AUTODESTROY(MulticastClass) notifier_obj;
+    AUTODESTROY(TestObject) plain_obj;
+    NEW_INPLACE(GaugeDerived, &gauge_obj, 2, 3);
+    NEW_INPLACE(MulticastClass, &notifier_obj);
+    NEW_INPLACE(TestObject, &plain_obj, 1);
+    OBJECT *objects[3];
+    objects[0] = (OBJECT *)&gauge_obj;
+    objects[1] = (OBJECT *)&notifier_obj;
+    objects[2] = (OBJECT *)&plain_obj;
+
+    /* Interfaces declared in a base class are found, with the descriptor of the actual class */
+    Gauge_ref gauge = QUERY_INTERFACE(objects[0], Gauge);
+    TEST_ASSERT_EQUAL_PTR(&gauge_obj, gauge.self);
+    TEST_ASSERT_EQUAL_PTR(INTERFACE_REF(&gauge_obj, Gauge).desc, gauge.desc);
+    TEST_ASSERT_EQUAL_INT(6, REF_CALL(gauge, read_level));
+    TEST_ASSERT_NULL(QUERY_INTERFACE(objects[0], Notifier).desc);
+
+    TEST_ASSERT_NOT_NULL(QUERY_INTERFACE(objects[1], Notifier).desc);
+    TEST_ASSERT_NULL(QUERY_INTERFACE(objects[1], Gauge).desc);
+    TEST_ASSERT_NULL(QUERY_INTERFACE(objects[2], Gauge).desc);
+    TEST_ASSERT_NULL(QUERY_INTERFACE(objects[2], Notifier).desc);
+
+#ifdef CLASSYC_INTERFACE_INDEX
+    /* The interface table holds the interfaces of the class and its bases at their ids */
+    TEST_ASSERT_EQUAL_PTR(&ClassyC_Gauge_interface_info, CLASS_OF(objects[0])->interfaces[ClassyC_Gauge_interface_id].interface);
+    TEST_ASSERT_EQUAL_STRING("Gauge", CLASS_OF(objects[0])->interfaces[ClassyC_Gauge_interface_id].interface->name);
+    TEST_ASSERT_EQUAL_size_t(ClassyC_Gauge_interface_id + 1, CLASS_OF(objects[0])->interface_count);
+    TEST_ASSERT_NULL(CLASS_OF(objects[0])->interfaces[0].interface);
+    TEST_ASSERT_NULL(CLASS_OF(objects[0])->interfaces[ClassyC_Notifier_interface_id].interface);
+    /* Gauge was created after MulticastClass: its id is past the table of MulticastClass */
+    TEST_ASSERT_TRUE(ClassyC_Gauge_interface_id >= CLASS_OF(objects[1])->interface_count);
+#endif
+}
+
+
+
+
+
+/* Test Case: Static method calls */
+void test_StaticCalls(void) {
+    AUTODESTROY(DerivedClass) derived_obj;
+    AUTODESTROY(GaugeDerived) gauge_obj;
+    NEW_INPLACE(DerivedClass, &derived_obj, 100, 200);
+    NEW_INPLACE(GaugeDerived, &gauge_obj, 2, 3);
+
+    /* New, inherited and overridden methods resolve to the implementation of the named class */
+    TEST_ASSERT_EQUAL_INT(200, CALL_STATIC(DerivedClass, get_derived_value, &derived_obj));
+    TEST_ASSERT_EQUAL_INT(100, CALL_STATIC(DerivedClass, get_base_value, &derived_obj));
+    TEST_ASSERT_EQUAL_INT(2, CALL_STATIC(DerivedClass, get_overridable_value, &derived_obj));
+    TEST_ASSERT_EQUAL_INT(3, CALL_STATIC(DerivedClass, get_incremental_value, &derived_obj));
+    TEST_ASSERT_EQUAL_INT(1, CALL_STATIC(BaseClass, get_overridable_value, &derived_obj));
+    TEST_ASSERT_EQUAL_PTR(ClassyC_DerivedClass_get_overridable_value, ClassyC_DerivedClass_static_vtable.get_overridable_value);
+    TEST_ASSERT_EQUAL_PTR(ClassyC_BaseClass_get_base_value, ClassyC_DerivedClass_static_vtable.get_base_value);
+
+    /* Method pointers of the object are not read */
+    derived_obj.get_derived_value = ClassyC_BaseClass_get_base_value;
+    TEST_ASSERT_EQUAL_INT(200, CALL_STATIC(DerivedClass, get_derived_value, &derived_obj));
+
+    /* Interface casts of a base class interface use the class of the table */
+    Gauge gauge = CALL_STATIC(GaugeDerived, to_Gauge, &gauge_obj);
+    TEST_ASSERT_EQUAL_INT(6, gauge.read_level(gauge.self));
+    TEST_ASSERT_EQUAL_PTR(INTERFACE_REF(&gauge_obj, Gauge).desc, ClassyC_GaugeDerived_static_vtable._desc_Gauge);
+    TEST_ASSERT_EQUAL_INT(sizeof(GaugeDerived), ClassyC_GaugeDerived_static_vtable._size);
+}
+
+
+
+
+/* Test Case: Final methods and sealed classes */
+#undef CLASS
+#define CLASS FinalBase
+#define CLASS_FinalBase(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(int, value)
+
+CONSTRUCTOR(int initial_value)
+    self->value = initial_value;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+FINAL_METHOD(int, get_value)
+    return self->value;
+END_METHOD
+
+FINAL_METHOD(int, add_value, int amount)
+    self->value += amount;
+    return self->value;
+END_METHOD
+
+
+#undef CLASS
+#define CLASS SealedLeaf
+#define CLASS_SealedLeaf(Base, Interface, Data, Event, Method, Override) \
+    Base(FinalBase) \
+    Data(int, scale)
+
+SEALED()
+
+CONSTRUCTOR(int initial_value, int scale)
+    INIT_BASE(initial_value);
+    self->scale = scale;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+FINAL_METHOD(int, get_scaled_value)
+    return CALL_FINAL(FinalBase, get_value, self) * self->scale;
+END_METHOD
+
+void test_FinalMethodsAndSealedClasses(void) {
+    AUTODESTROY(SealedLeaf) leaf;
+    NEW_INPLACE(SealedLeaf, &leaf, 4, 3);
+    TEST_ASSERT_EQUAL_INT(4, CALL_FINAL(FinalBase, get_value, &leaf));
+    TEST_ASSERT_EQUAL_INT(6, CALL_FINAL(FinalBase, add_value, &leaf, 2));
+    TEST_ASSERT_EQUAL_INT(18, CALL_FINAL(SealedLeaf, get_scaled_value, &leaf));
+    TEST_ASSERT_EQUAL_INT(1, ClassyC_SealedLeaf_is_sealed);
+
+    /* Final methods have no method pointers */
+    TEST_ASSERT_EQUAL_INT(sizeof(ClassyC_vtable_header), sizeof(ClassyC_FinalBase_vtable));
+    TEST_ASSERT_EQUAL_INT(sizeof(ClassyC_vtable_header), sizeof(ClassyC_SealedLeaf_vtable));
+}
+
+
+
+
+/* Test Case: Closed hierarchies */
+#define HIERARCHY_BaseClass(Class) Class(BaseClass) Class(DerivedClass)
+CLOSED_HIERARCHY(BaseClass)
+
+void test_ClosedHierarchy(void) {
+    AUTODESTROY(BaseClass) base_obj;
+    AUTODESTROY(DerivedClass) derived_obj;
+    AUTODESTROY(ArrayElement) unlisted_obj;
+    NEW_INPLACE(BaseClass, &base_obj, 1);
+    NEW_INPLACE(DerivedClass, &derived_obj, 2, 3);
+    NEW_INPLACE(ArrayElement, &unlisted_obj, 4);
+    BaseClass *objects[3];
+    objects[0] = &base_obj;
+    objects[1] = (BaseClass *)&derived_obj;
+    objects[2] = (BaseClass *)&unlisted_obj;
+
+    /* Dense ids in the order of the list */
+    TEST_ASSERT_EQUAL_INT(2, ClassyC_BaseClass_class_count);
+    TEST_ASSERT_EQUAL_INT(ClassyC_BaseClass_hierarchy_id, CLASS_ID(BaseClass, objects[0]));
+    TEST_ASSERT_EQUAL_INT(ClassyC_DerivedClass_hierarchy_id, CLASS_ID(BaseClass, objects[1]));
+    TEST_ASSERT_EQUAL_INT(1, CLASS_ID(BaseClass, objects[1]));
+    TEST_ASSERT_EQUAL_INT(-1, CLASS_ID(BaseClass, objects[2]));
+
+    /* Listed classes are called directly, the others through their method pointers */
+    TEST_ASSERT_EQUAL_INT(1, CLOSED_CALL(BaseClass, get_overridable_value, objects[0]));
+    TEST_ASSERT_EQUAL_INT(2, CLOSED_CALL(BaseClass, get_overridable_value, objects[1]));
+    TEST_ASSERT_EQUAL_INT(3, CLOSED_CALL(BaseClass, get_incremental_value, objects[1]));
+    TEST_ASSERT_EQUAL_INT(2, CLOSED_CALL(BaseClass, get_base_value, objects[1]));
+    TEST_ASSERT_EQUAL_INT(10 + unlisted_obj.index, CLOSED_CALL(BaseClass, get_overridable_value, objects[2]));
+    objects[1]->get_overridable_value = ClassyC_BaseClass_get_overridable_value;
+    TEST_ASSERT_EQUAL_INT(2, CLOSED_CALL(BaseClass, get_overridable_value, objects[1]));
+
+#ifdef CLASSYC_CLASS_UIDS
+    /* Classes are numbered in the translation unit, and selected with a switch */
+    TEST_ASSERT_NOT_EQUAL(0, CLASS_INFO(BaseClass)->uid);
+    TEST_ASSERT_NOT_EQUAL(CLASS_INFO(BaseClass)->uid, CLASS_INFO(DerivedClass)->uid);
+#endif
+#ifdef CLASSYC_CLOSED_SWITCH
+    /* The object expression is evaluated once */
+    int next = 0;
+    TEST_ASSERT_EQUAL_INT(1, CLOSED_CALL(BaseClass, get_overridable_value, objects[next++]));
+    TEST_ASSERT_EQUAL_INT(1, next);
+#endif
+}
+
+
+
+
+/* Test Case: Padding report and packed classes */
+#undef CLASS
+#define CLASS UnpackedSample
+#define CLASS_UnpackedSample(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(char, flag) \
+    Data(double, value) \
+    Data(char, other_flag) \
+    Method(double, get_value)
+
+CONSTRUCTOR(double value)
+    self->value = value;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(double, get_value)
+    return self->value;
+END_METHOD
+
+
+#undef CLASS
+#define CLASS PackedSample
+#define CLASS_PackedSample(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(char, flag) \
+    Data(double, value) \
+    Data(char, other_flag) \
+    Method(double, get_value)
+
+PACKED_CONSTRUCTOR(double value)
+    self->value = value;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(double, get_value)
+    return self->value;
+END_METHOD
+
+void test_LayoutPadding(void) {
+    /* The padding is what is left of the object after all its members */
+    TEST_ASSERT_EQUAL_size_t(0, CLASS_INFO(OBJECT)->padding);
+    TEST_ASSERT_TRUE(CLASS_INFO(UnpackedSample)->padding >= 2 * (_Alignof(double) - 1));
+    TEST_ASSERT_TRUE(CLASS_INFO(UnpackedSample)->padding < CLASS_INFO(UnpackedSample)->size);
+
+    /* The data members of a packed class have no padding between them */
+    TEST_ASSERT_EQUAL_INT(1, ClassyC_PackedSample_is_sealed);
+    TEST_ASSERT_EQUAL_size_t(offsetof(PackedSample, flag) + 1, offsetof(PackedSample, value));
+    TEST_ASSERT_EQUAL_size_t(offsetof(PackedSample, value) + sizeof(double), offsetof(PackedSample, other_flag));
+    TEST_ASSERT_TRUE(sizeof(PackedSample) < sizeof(UnpackedSample));
+    TEST_ASSERT_TRUE(CLASS_INFO(PackedSample)->padding < CLASS_INFO(UnpackedSample)->padding);
+
+    AUTODESTROY(PackedSample) packed;
+    NEW_INPLACE(PackedSample, &packed, 2.5);
+    packed.flag = 'a';
+    packed.other_flag = 'b';
+    TEST_ASSERT_EQUAL_INT(5, (int)(2 * packed.get_value(&packed)));
+    TEST_ASSERT_EQUAL_INT('a', packed.flag);
+    TEST_ASSERT_EQUAL_INT('b', packed.other_flag);
+}
+
+
+
+
+/* Test Case: Cold data members */
+#undef CLASS
+#define CLASS HotCold
+#define CLASS_HotCold(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(int, position) \
+    COLD_DATA(Data, HotCold) \
+    Method(int, get_year)
+#define COLD_HotCold(ColdData) \
+    ColdData(char, owner[16]) \
+    ColdData(int, year)
+
+CONSTRUCTOR(int position)
+    self->position = position;
+END_CONSTRUCTOR
+
+COLD_BLOCK()
+
+static int cold_blocks_destroyed = 0;
+DESTRUCTOR()
+    if (COLD_PEEK(self, HotCold)) cold_blocks_destroyed++;
+END_DESTRUCTOR
+
+METHOD(int, get_year)
+    return COLD(self, HotCold)->year;
+END_METHOD
+
+
+#undef CLASS
+#define CLASS HotColdDerived
+#define CLASS_HotColdDerived(Base, Interface, Data, Event, Method, Override) \
+    Base(HotCold) \
+    Data(int, speed) \
+    COLD_DATA(Data, HotColdDerived)
+#define COLD_HotColdDerived(ColdData) \
+    ColdData(double, price)
+
+CONSTRUCTOR(int position, int speed)
+    INIT_BASE(position);
+    self->speed = speed;
+END_CONSTRUCTOR
+
+COLD_BLOCK()
+
+DESTRUCTOR()
+    if (COLD_PEEK(self, HotColdDerived)) cold_blocks_destroyed++;
+END_DESTRUCTOR
+
+void test_ColdData(void) {
+    cold_blocks_destroyed = 0;
+    HotCold *hot = NEW_ALLOC(HotCold, 3);
+    /* The objects only hold a pointer per class with cold members */
+    TEST_ASSERT_EQUAL_size_t(sizeof(void *), sizeof(hot->ClassyC_HotCold_cold));
+    TEST_ASSERT_NULL(COLD_PEEK(hot, HotCold));
+    COLD(hot, HotCold)->year = 1990;
+    TEST_ASSERT_NOT_NULL(COLD_PEEK(hot, HotCold));
+    TEST_ASSERT_EQUAL_INT(1990, hot->get_year(hot));
+    TEST_ASSERT_EQUAL_INT(0, COLD(hot, HotCold)->owner[0]);
+    TEST_ASSERT_EQUAL_INT(3, hot->position);
+    DESTROY_FREE(hot);
+    TEST_ASSERT_EQUAL_INT(1, cold_blocks_destroyed);
+
+    /* Each level has its own cold block, freed by its destructor */
+    HotColdDerived *derived = NEW_ALLOC_NOZERO(HotColdDerived, 4, 5);
+    TEST_ASSERT_NULL(COLD_PEEK(derived, HotCold));
+    TEST_ASSERT_NULL(COLD_PEEK(derived, HotColdDerived));
+    COLD(derived, HotColdDerived)->price = 2.5;
+    TEST_ASSERT_NULL(COLD_PEEK(derived, HotCold));
+    TEST_ASSERT_EQUAL_INT(0, derived->get_year(derived));
+    TEST_ASSERT_EQUAL_INT(5, (int)(2 * COLD(derived, HotColdDerived)->price));
+    DESTROY_FREE(derived);
+    TEST_ASSERT_EQUAL_INT(3, cold_blocks_destroyed);
+
+    /* Objects in the stack free their cold blocks when destroyed */
+    HotColdDerived stack_obj;
+    NEW_INPLACE(HotColdDerived, &stack_obj, 1, 2);
+    COLD((HotCold *)&stack_obj, HotCold)->year = 2000;
+    TEST_ASSERT_EQUAL_INT(2000, stack_obj.get_year(&stack_obj));
+    DESTROY(stack_obj);
+    TEST_ASSERT_NULL(COLD_PEEK(&stack_obj, HotCold));
+    TEST_ASSERT_EQUAL_INT(4, cold_blocks_destroyed);
+}
+
+
+
+
+/* Test Case: Structs of arrays */
+#undef CLASS
+#define CLASS Particle
+#define CLASS_Particle(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(int, position) \
+    Data(int, speed) \
+    Method(int, get_position)
+
+CONSTRUCTOR(int position, int speed)
+    self->position = position;
+    self->speed = speed;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(int, get_position)
+    return self->position;
+END_METHOD
+
+
+#undef CLASS
+#define CLASS TaggedParticle
+#define CLASS_TaggedParticle(Base, Interface, Data, Event, Method, Override) \
+    Base(Particle) \
+    Data(char, tag)
+
+CONSTRUCTOR(int position, int speed, char tag)
+    INIT_BASE(position, speed);
+    self->tag = tag;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+SOA(TaggedParticle)
+
+void test_StructOfArrays(void) {
+    SOA_OF(TaggedParticle) particles = { 0 };
+    size_t i;
+    /* One column per data member of the class and its base classes */
+    TEST_ASSERT_EQUAL_size_t(2 * sizeof(size_t) + 3 * sizeof(int *), sizeof(particles));
+
+    for (i = 0; i < 100; i++) {
+        size_t row = SOA_APPEND(TaggedParticle, &particles);
+        TEST_ASSERT_EQUAL_size_t(i, row);
+        TEST_ASSERT_EQUAL_INT(0, particles.position[row]);
+        particles.position[row] = (int)i;
+        particles.speed[row] = 2;
+        particles.tag[row] = 'a';
+    }
+    AUTODESTROY(TaggedParticle) object;
+    NEW_INPLACE(TaggedParticle, &object, 1000, 3, 'z');
+    TEST_ASSERT_EQUAL_size_t(100, SOA_APPEND_OBJECT(TaggedParticle, &particles, &object));
+    TEST_ASSERT_EQUAL_size_t(101, particles.count);
+    TEST_ASSERT_TRUE(particles.capacity >= particles.count);
+
+    /* Loops over one or two columns */
+    for (i = 0; i < particles.count; i++) {
+        particles.position[i] += particles.speed[i];
+    }
+    TEST_ASSERT_EQUAL_INT(2, particles.position[0]);
+    TEST_ASSERT_EQUAL_INT(1003, particles.position[100]);
+
+    /* Views point to the members of a row */
+    SOA_VIEW_OF(TaggedParticle) view = SOA_VIEW(TaggedParticle, &particles, 100);
+    TEST_ASSERT_EQUAL_INT('z', *view.tag);
+    *view.speed = 7;
+    TEST_ASSERT_EQUAL_INT(7, particles.speed[100]);
+
+    /* The last row takes the place of the removed one */
+    TEST_ASSERT_TRUE(SOA_REMOVE(TaggedParticle, &particles, 5));
+    TEST_ASSERT_EQUAL_size_t(100, particles.count);
+    TEST_ASSERT_EQUAL_INT(1003, particles.position[5]);
+    TEST_ASSERT_EQUAL_INT('z', particles.tag[5]);
+    TEST_ASSERT_TRUE(SOA_REMOVE(TaggedParticle, &particles, 99));
+    TEST_ASSERT_EQUAL_size_t(99, particles.count);
+    TEST_ASSERT_EQUAL_INT(100, particles.position[98]);
+    /* No row at the index: nothing is removed */
+    TEST_ASSERT_FALSE(SOA_REMOVE(TaggedParticle, &particles, 99));
+    TEST_ASSERT_EQUAL_size_t(99, particles.count);
+
+    /* Capacities whose columns can't be allocated: the rows are kept */
+    TEST_ASSERT_FALSE(SOA_RESERVE(TaggedParticle, &particles, SIZE_MAX / sizeof(int) + 1));
+    TEST_ASSERT_EQUAL_size_t(99, particles.count);
+
+    TEST_ASSERT_TRUE(SOA_RESERVE(TaggedParticle, &particles, 1000));
+    TEST_ASSERT_EQUAL_size_t(1000, particles.capacity);
+    TEST_ASSERT_EQUAL_INT(1003, particles.position[5]);
+    SOA_FREE(TaggedParticle, &particles);
+    TEST_ASSERT_EQUAL_size_t(0, particles.count);
+    TEST_ASSERT_NULL(particles.position);
+    /* Removing from an empty collection */
+    TEST_ASSERT_FALSE(SOA_REMOVE(TaggedParticle, &particles, 0));
+    TEST_ASSERT_EQUAL_size_t(0, particles.count);
+}
+
+
+
+
+/* Test Case: Batch calls */
+static int batch_log[2 * CLASSYC_BATCH_CHUNK + 16];
+static int batch_log_count = 0;
+
+#undef CLASS
+#define CLASS BatchBase
+#define CLASS_BatchBase(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(int, id) \
+    Method(void, visit, int offset)
+
+CONSTRUCTOR(int id)
+    self->id = id;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(void, visit, int offset)
+    batch_log[batch_log_count++] = self->id + offset;
+END_METHOD
+
+
+#undef CLASS
+#define CLASS BatchDerived
+#define CLASS_BatchDerived(Base, Interface, Data, Event, Method, Override) \
+    Base(BatchBase) \
+    Override(void, visit, int offset)
+
+CONSTRUCTOR(int id)
+    INIT_BASE(id);
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(void, visit, int offset)
+    batch_log[batch_log_count++] = -(self->id + offset);
+END_METHOD
+
+/* Closed hierarchies also call void methods */
+#define HIERARCHY_BatchBase(Class) Class(BatchBase) Class(BatchDerived)
+CLOSED_HIERARCHY(BatchBase)
+
+void test_ClosedHierarchyVoidMethods(void) {
+    AUTODESTROY(BatchBase) base_obj;
+    AUTODESTROY(BatchDerived) derived_obj;
+    NEW_INPLACE(BatchBase, &base_obj, 1);
+    NEW_INPLACE(BatchDerived, &derived_obj, 2);
+    batch_log_count = 0;
+    CLOSED_CALL(BatchBase, visit, &base_obj, 10);
+    CLOSED_CALL(BatchBase, visit, (BatchBase *)&derived_obj, 10);
+    TEST_ASSERT_EQUAL_INT(2, batch_log_count);
+    TEST_ASSERT_EQUAL_INT(11, batch_log[0]);
+    TEST_ASSERT_EQUAL_INT(-12, batch_log[1]);
+}
+
+void test_BatchCalls(void) {
+    AUTODESTROY(BatchBase) base_objs[3];
+    AUTODESTROY(BatchDerived) derived_objs[3];
+    BatchBase *objects[6];
+    int i;
+    for (i = 0; i < 3; i++) {
+        NEW_INPLACE(BatchBase, &base_objs[i], 2 * i);
+        NEW_INPLACE(BatchDerived, &derived_objs[i], 2 * i + 1);
+        objects[2 * i] = &base_objs[i];
+        objects[2 * i + 1] = (BatchBase *)&derived_objs[i];
+    }
+
+    /* The objects are called grouped by implementation, the group of the first object first, each group in order */
+    batch_log_count = 0;
+    BATCH_CALL(objects, 6, visit, 10);
+    TEST_ASSERT_EQUAL_INT(6, batch_log_count);
+    TEST_ASSERT_EQUAL_INT(10, batch_log[0]);
+    TEST_ASSERT_EQUAL_INT(12, batch_log[1]);
+    TEST_ASSERT_EQUAL_INT(14, batch_log[2]);
+    TEST_ASSERT_EQUAL_INT(-11, batch_log[3]);
+    TEST_ASSERT_EQUAL_INT(-13, batch_log[4]);
+    TEST_ASSERT_EQUAL_INT(-15, batch_log[5]);
+    /* The array is not modified */
+    for (i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_PTR(&base_objs[i], objects[2 * i]);
+        TEST_ASSERT_EQUAL_PTR(&derived_objs[i], objects[2 * i + 1]);
+    }
+
+    /* Long arrays are grouped chunk by chunk: in each chunk, the objects of the base class and then the derived ones */
+    BatchBase *many[2 * CLASSYC_BATCH_CHUNK + 10];
+    for (i = 0; i < (int)(sizeof(many) / sizeof(many[0])); i++) {
+        many[i] = objects[i % 6];
+    }
+    batch_log_count = 0;
+    BATCH_CALL(many, sizeof(many) / sizeof(many[0]), visit, 0);
+    TEST_ASSERT_EQUAL_INT(2 * CLASSYC_BATCH_CHUNK + 10, batch_log_count);
+    for (i = 0; i < batch_log_count; i++) {
+        int chunk_start = i - i % CLASSYC_BATCH_CHUNK;
+        int chunk_size = batch_log_count - chunk_start < CLASSYC_BATCH_CHUNK ? batch_log_count - chunk_start : CLASSYC_BATCH_CHUNK;
+        TEST_ASSERT_EQUAL_INT(i - chunk_start < chunk_size / 2, batch_log[i] >= 0);
+    }
+
+    /* Interface references are grouped the same way, and the array is not modified either */
+    AUTODESTROY(GaugeBase) gauge_base;
+    AUTODESTROY(GaugeDerived) gauge_derived;
+    NEW_INPLACE(GaugeBase, &gauge_base, 2);
+    NEW_INPLACE(GaugeDerived, &gauge_derived, 2, 3);
+    Gauge_ref refs[4] = { INTERFACE_REF((GaugeBase *)&gauge_derived, Gauge), INTERFACE_REF(&gauge_base, Gauge),
+                          INTERFACE_REF((GaugeBase *)&gauge_derived, Gauge), INTERFACE_REF(&gauge_base, Gauge) };
+    BATCH_REF_CALL(refs, 4, read_level);
+    TEST_ASSERT_EQUAL_PTR(&gauge_derived, refs[0].self);
+    TEST_ASSERT_EQUAL_PTR(&gauge_base, refs[1].self);
+    TEST_ASSERT_EQUAL_PTR(&gauge_derived, refs[2].self);
+    TEST_ASSERT_EQUAL_PTR(&gauge_base, refs[3].self);
+}
+
+
+
+/* Test Case: Slot map handles */
+static int slot_destruct_calls = 0;
+
+#undef CLASS
+#define CLASS SlotNode
+#define CLASS_SlotNode(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(int, value) \
+    Data(ClassyC_handle, child) \
+    Method(int, get_value)
+
+SLOT_MAP()
+
+CONSTRUCTOR(int value)
+    self->value = value;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+    if (!is_base) slot_destruct_calls++;
+    /* Destroying another object of the slot map from a destructor moves the objects */
+    HANDLE_DESTROY(SlotNode, self->child);
+END_DESTRUCTOR
+
+METHOD(int, get_value)
+    return self->value;
+END_METHOD
+
+void test_SlotMapHandles(void) {
+    ClassyC_handle handles[40];
+    ClassyC_handle null_handle = 0;
+    int i;
+    /* The slot index and the generation share 32 bits */
+    TEST_ASSERT_EQUAL_size_t(4, sizeof(ClassyC_handle));
+    slot_destruct_calls = 0;
+    TEST_ASSERT_NULL(HANDLE_GET(SlotNode, null_handle));
+    for (i = 0; i < 40; i++) {
+        handles[i] = HANDLE_NEW(SlotNode, i);
+        TEST_ASSERT_NOT_NULL(HANDLE_GET(SlotNode, handles[i]));
+    }
+    TEST_ASSERT_EQUAL_size_t(40, SLOT_MAP_COUNT(SlotNode));
+    TEST_ASSERT_NULL(HANDLE_GET(SlotNode, null_handle));
+
+    /* Destroyed objects make all the copies of their handle stale; the rest keep resolving */
+    ClassyC_handle copy = handles[3];
+    TEST_ASSERT_TRUE(HANDLE_DESTROY(SlotNode, handles[3]));
+    TEST_ASSERT_FALSE(HANDLE_DESTROY(SlotNode, copy));
+    TEST_ASSERT_NULL(HANDLE_GET(SlotNode, copy));
+    TEST_ASSERT_EQUAL_INT(1, slot_destruct_calls);
+    TEST_ASSERT_EQUAL_size_t(39, SLOT_MAP_COUNT(SlotNode));
+    for (i = 0; i < 40; i++) {
+        if (i != 3) {
+            SlotNode *node = HANDLE_GET(SlotNode, handles[i]);
+            TEST_ASSERT_EQUAL_INT(i, CALL(node, get_value));
+        }
+    }
+
+    /* The slot is reused with a new generation */
+    ClassyC_handle reused = HANDLE_NEW(SlotNode, 100);
+    TEST_ASSERT_EQUAL_UINT32(HANDLE_INDEX(copy), HANDLE_INDEX(reused));
+    TEST_ASSERT_NOT_EQUAL(HANDLE_GENERATION(copy), HANDLE_GENERATION(reused));
+    TEST_ASSERT_NULL(HANDLE_GET(SlotNode, copy));
+    TEST_ASSERT_EQUAL_INT(100, HANDLE_GET(SlotNode, reused)->value);
+
+    /* Dense iteration over the live objects */
+    int sum = 0;
+    for (i = 0; i < (int)SLOT_MAP_COUNT(SlotNode); i++) {
+        SlotNode *node = &SLOT_MAP_OBJECTS(SlotNode)[i];
+        sum += node->value;
+        TEST_ASSERT_EQUAL_PTR(node, HANDLE_GET(SlotNode, SLOT_MAP_HANDLE(SlotNode, i)));
+    }
+    TEST_ASSERT_EQUAL_INT(39 * 40 / 2 - 3 + 100, sum);
+
+    /* Destructors can destroy other objects of the same class */
+    HANDLE_GET(SlotNode, handles[39])->child = handles[0];
+    HANDLE_GET(SlotNode, handles[0])->child = handles[20];
+    slot_destruct_calls = 0;
+    TEST_ASSERT_TRUE(HANDLE_DESTROY(SlotNode, handles[39]));
+    TEST_ASSERT_EQUAL_INT(3, slot_destruct_calls);
+    TEST_ASSERT_NULL(HANDLE_GET(SlotNode, handles[0]));
+    TEST_ASSERT_NULL(HANDLE_GET(SlotNode, handles[20]));
+    TEST_ASSERT_EQUAL_INT(38, HANDLE_GET(SlotNode, handles[38])->value);
+    TEST_ASSERT_EQUAL_size_t(37, SLOT_MAP_COUNT(SlotNode));
+
+    slot_destruct_calls = 0;
+    SLOT_MAP_RELEASE(SlotNode);
+    TEST_ASSERT_EQUAL_INT(37, slot_destruct_calls);
+    TEST_ASSERT_EQUAL_size_t(0, SLOT_MAP_COUNT(SlotNode));
+    TEST_ASSERT_NULL(HANDLE_GET(SlotNode, reused));
+
+    /* The generation of a slot wraps within its bits, skipping the 0 of null handles */
+    ClassyC_handle first = HANDLE_NEW(SlotNode, 1), handle = first;
+    TEST_ASSERT_EQUAL_UINT32(1, HANDLE_GENERATION(first));
+    for (i = 0; i < (int)CLASSYC_HANDLE_GENERATION_MASK; i++) {
+        TEST_ASSERT_TRUE(HANDLE_DESTROY(SlotNode, handle));
+        handle = HANDLE_NEW(SlotNode, 1);
+        TEST_ASSERT_EQUAL_UINT32(HANDLE_INDEX(first), HANDLE_INDEX(handle));
+        TEST_ASSERT_NOT_EQUAL(0, HANDLE_GENERATION(handle));
+    }
+    TEST_ASSERT_EQUAL(first, handle);
+    SLOT_MAP_RELEASE(SlotNode);
+}
+
+
+
 
 /* ==========================
    Unity Setup
@@ -302,6 +1484,24 @@ int main(void) {
     RUN_TEST(test_Polymorphism);
     RUN_TEST(test_Events);
     RUN_TEST(test_AutoDestructionManualDestruct);
+    RUN_TEST(test_ArenaAllocationAndReset);
+    RUN_TEST(test_ArrayConstructionAndDestruction);
+    RUN_TEST(test_NoZeroConstruction);
+    RUN_TEST(test_MulticastEvents);
+    RUN_TEST(test_EventSubscriptions);
+    RUN_TEST(test_DeferredEvents);
+    RUN_TEST(test_InterfaceReferences);
+    RUN_TEST(test_TypeChecks);
+    RUN_TEST(test_QueryInterface);
+    RUN_TEST(test_StaticCalls);
+    RUN_TEST(test_FinalMethodsAndSealedClasses);
+    RUN_TEST(test_ClosedHierarchy);
+    RUN_TEST(test_LayoutPadding);
+    RUN_TEST(test_ColdData);
+    RUN_TEST(test_StructOfArrays);
+    RUN_TEST(test_ClosedHierarchyVoidMethods);
+    RUN_TEST(test_BatchCalls);
+    RUN_TEST(test_SlotMapHandles);
 
     return UNITY_END();
 }
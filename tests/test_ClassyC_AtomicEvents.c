@@ -0,0 +1,216 @@
+// test_ClassyC_AtomicEvents.c
+#define CLASSYC_ATOMIC_EVENTS
+#include "unity.h"
+#include "../ClassyC.h"
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+
+
+
+
+
+
+/* Test Case: Events with atomic handler lists behave like the default ones */
+#define I_AtomicNotifier(Data, Event, Method) \
+    Event(on_notify, int value)
+CREATE_INTERFACE(AtomicNotifier)
+
+#undef CLASS
+#define CLASS AtomicEventClass
+#define CLASS_AtomicEventClass(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) Interface(AtomicNotifier) \
+    Data(int, total) \
+    Event(on_notify, int value)
+
+CONSTRUCTOR()
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+DEFERRABLE_EVENT(on_notify, int)
+
+static char atomic_log[16];
+static int atomic_log_length = 0;
+EVENT_HANDLER(AtomicEventClass, on_notify, first, int value)
+    atomic_log[atomic_log_length++] = 'f';
+    self->total += value;
+END_EVENT_HANDLER
+EVENT_HANDLER(AtomicEventClass, on_notify, second, int value)
+    atomic_log[atomic_log_length++] = 's';
+    self->total += value;
+END_EVENT_HANDLER
+EVENT_HANDLER(AtomicEventClass, on_notify, unsubscriber, int value)
+    /* Changing the handlers while the event is raised doesn't affect the handlers being called */
+    (void)value;
+    atomic_log[atomic_log_length++] = 'u';
+    UNSUBSCRIBE_EVENT(AtomicEventClass, on_notify, second, self);
+END_EVENT_HANDLER
+
+static void atomic_log_reset(void) {
+    memset(atomic_log, 0, sizeof(atomic_log));
+    atomic_log_length = 0;
+}
+
+void test_AtomicSubscribeAndRaise(void) {
+    AUTODESTROY_PTR(AtomicEventClass) *obj = NEW_ALLOC(AtomicEventClass);
+    TEST_ASSERT_NOT_NULL(obj);
+    TEST_ASSERT_NULL(atomic_load(&obj->on_notify));
+    atomic_log_reset();
+    RAISE_EVENT(obj, on_notify, 1);
+    TEST_ASSERT_EQUAL_INT(0, atomic_log_length);
+
+    SUBSCRIBE_EVENT(AtomicEventClass, on_notify, first, obj);
+    SUBSCRIBE_EVENT(AtomicEventClass, on_notify, second, obj);
+    RAISE_EVENT(obj, on_notify, 2);
+    TEST_ASSERT_EQUAL_STRING("fs", atomic_log);
+    TEST_ASSERT_EQUAL_INT(4, obj->total);
+
+    AtomicNotifier notifier = obj->to_AtomicNotifier(obj);
+    atomic_log_reset();
+    RAISE_INTERFACE_EVENT(notifier, on_notify, 1);
+    TEST_ASSERT_EQUAL_STRING("fs", atomic_log);
+
+    UNSUBSCRIBE_EVENT(AtomicEventClass, on_notify, first, obj);
+    atomic_log_reset();
+    RAISE_EVENT(obj, on_notify, 1);
+    TEST_ASSERT_EQUAL_STRING("s", atomic_log);
+
+    /* Subscriptions return their slot, reusing the free ones, and can be unsubscribed by it */
+    TEST_ASSERT_EQUAL_size_t(0, SUBSCRIBE_EVENT(AtomicEventClass, on_notify, first, obj));
+    UNSUBSCRIBE_EVENT_ID(obj, on_notify, 1);
+    atomic_log_reset();
+    RAISE_EVENT(obj, on_notify, 1);
+    TEST_ASSERT_EQUAL_STRING("f", atomic_log);
+
+    TEST_ASSERT_EQUAL_size_t(0, REGISTER_EVENT(AtomicEventClass, on_notify, first, obj));
+    atomic_log_reset();
+    RAISE_INTERFACE_EVENT(notifier, on_notify, 1);
+    TEST_ASSERT_EQUAL_STRING("f", atomic_log);
+
+    /* Without handlers the event is NULL again. The replaced lists are kept until reclaimed. */
+    CLEAR_EVENT(obj, on_notify);
+    TEST_ASSERT_NULL(atomic_load(&obj->on_notify));
+    TEST_ASSERT_EQUAL_size_t(6, atomic_load(&ClassyC_events_reclaimer.retired_count));
+    atomic_log_reset();
+    RAISE_EVENT(obj, on_notify, 1);
+    TEST_ASSERT_EQUAL_INT(0, atomic_log_length);
+    RECLAIM_EVENT(obj, on_notify);
+    TEST_ASSERT_EQUAL_size_t(0, atomic_load(&ClassyC_events_reclaimer.retired_count));
+}
+
+void test_AtomicChangesWhileRaising(void) {
+    {
+        AUTODESTROY_PTR(AtomicEventClass) *obj = NEW_ALLOC(AtomicEventClass);
+        SUBSCRIBE_EVENT(AtomicEventClass, on_notify, unsubscriber, obj);
+        SUBSCRIBE_EVENT(AtomicEventClass, on_notify, second, obj);
+        /* The raise uses the list loaded when it started: second is still called */
+        atomic_log_reset();
+        RAISE_EVENT(obj, on_notify, 1);
+        TEST_ASSERT_EQUAL_STRING("us", atomic_log);
+        atomic_log_reset();
+        RAISE_EVENT(obj, on_notify, 1);
+        TEST_ASSERT_EQUAL_STRING("u", atomic_log);
+        /* The list replaced during the first raise is retired, with the one replaced by the second subscription */
+        TEST_ASSERT_EQUAL_size_t(2, atomic_load(&ClassyC_events_reclaimer.retired_count));
+    }
+    /* Destroying the object freed them */
+    TEST_ASSERT_EQUAL_size_t(0, atomic_load(&ClassyC_events_reclaimer.retired_count));
+}
+
+/* Changes while other threads raise the event, reclaimed once the raising threads are joined */
+#define CHURN_RAISERS 3
+#define CHURN_CHANGES 10000
+static _Atomic bool churn_stop;
+static _Atomic size_t churn_raised;
+EVENT_HANDLER(AtomicEventClass, on_notify, churn, int value)
+    (void)self;
+    atomic_fetch_add_explicit(&churn_raised, (size_t)value, memory_order_relaxed);
+END_EVENT_HANDLER
+EVENT_HANDLER(AtomicEventClass, on_notify, churn_extra, int value)
+    (void)self;
+    (void)value;
+END_EVENT_HANDLER
+
+static void *churn_raiser(void *argument) {
+    AtomicEventClass *obj = (AtomicEventClass *)argument;
+    while (!atomic_load_explicit(&churn_stop, memory_order_relaxed)) {
+        RAISE_EVENT(obj, on_notify, 1);
+    }
+    return NULL;
+}
+
+void test_AtomicReclaimAfterChurn(void) {
+    AUTODESTROY_PTR(AtomicEventClass) *obj = NEW_ALLOC(AtomicEventClass);
+    AUTODESTROY_PTR(AtomicEventClass) *other = NEW_ALLOC(AtomicEventClass);
+    pthread_t raisers[CHURN_RAISERS];
+    int i;
+    SUBSCRIBE_EVENT(AtomicEventClass, on_notify, churn, obj);
+    for (i = 0; i < CHURN_RAISERS; i++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&raisers[i], NULL, churn_raiser, obj));
+    }
+    for (i = 0; i < CHURN_CHANGES; i++) {
+        SUBSCRIBE_EVENT(AtomicEventClass, on_notify, churn_extra, obj);
+        UNSUBSCRIBE_EVENT(AtomicEventClass, on_notify, churn_extra, obj);
+        /* Another event changed meanwhile */
+        if (i % 100 == 0) {
+            SUBSCRIBE_EVENT(AtomicEventClass, on_notify, churn_extra, other);
+        }
+        if (i % 64 == 0) {
+            /* Let the raisers run, even on a single core */
+            sched_yield();
+        }
+    }
+    atomic_store(&churn_stop, true);
+    for (i = 0; i < CHURN_RAISERS; i++) {
+        pthread_join(raisers[i], NULL);
+    }
+    TEST_ASSERT_TRUE(atomic_load(&churn_raised) > 0);
+    /* Every change retired a list; reclaiming an event only frees its own lists */
+    TEST_ASSERT_EQUAL_size_t(2 * CHURN_CHANGES + CHURN_CHANGES / 100 - 1, atomic_load(&ClassyC_events_reclaimer.retired_count));
+    RECLAIM_EVENT(other, on_notify);
+    TEST_ASSERT_EQUAL_size_t(2 * CHURN_CHANGES, atomic_load(&ClassyC_events_reclaimer.retired_count));
+    RECLAIM_EVENT(obj, on_notify);
+    TEST_ASSERT_EQUAL_size_t(0, atomic_load(&ClassyC_events_reclaimer.retired_count));
+}
+
+void test_AtomicDeferredEvents(void) {
+    ClassyC_event_queue queue;
+    AUTODESTROY_PTR(AtomicEventClass) *obj = NEW_ALLOC(AtomicEventClass);
+    SUBSCRIBE_EVENT(AtomicEventClass, on_notify, first, obj);
+    TEST_ASSERT_TRUE(EVENT_QUEUE_INIT(&queue, 2, DEFERRED_ARGS_SIZE(AtomicEventClass, on_notify)));
+    RAISE_EVENT_DEFERRED(&queue, AtomicEventClass, obj, on_notify, 5);
+    TEST_ASSERT_EQUAL_INT(0, obj->total);
+    TEST_ASSERT_EQUAL_size_t(1, CLASSYC_DRAIN_EVENTS(&queue, SIZE_MAX));
+    TEST_ASSERT_EQUAL_INT(5, obj->total);
+    EVENT_QUEUE_FREE(&queue);
+}
+
+
+
+
+
+/* ==========================
+   Unity Setup
+   ========================== */
+void setUp(void) {
+    // Set up code if needed
+}
+
+void tearDown(void) {
+    // Clean up code if needed
+}
+
+/* ==========================
+   Main Function to Run Tests
+   ========================== */
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_AtomicSubscribeAndRaise);
+    RUN_TEST(test_AtomicChangesWhileRaising);
+    RUN_TEST(test_AtomicReclaimAfterChurn);
+    RUN_TEST(test_AtomicDeferredEvents);
+    return UNITY_END();
+}
@@ -0,0 +1,135 @@
+// test_ClassyC_CompileFail.c
+/* Definitions that must not compile, each enabled by a macro (see the makefile). Without any, the file must compile. */
+#include "../ClassyC.h"
+
+#undef CLASS
+#define CLASS FinalRoot
+#define CLASS_FinalRoot(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(int, value)
+
+CONSTRUCTOR()
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+FINAL_METHOD(int, get_value)
+    return self->value;
+END_METHOD
+
+
+#undef CLASS
+#define CLASS FinalMiddle
+#define CLASS_FinalMiddle(Base, Interface, Data, Event, Method, Override) \
+    Base(FinalRoot)
+
+CONSTRUCTOR()
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+#ifdef COMPILE_FAIL_FINAL_HIDES_FINAL
+/* A final method with the name of a final method of the base class */
+FINAL_METHOD(int, get_value)
+    return 0;
+END_METHOD
+#endif
+
+
+#undef CLASS
+#define CLASS FinalLeaf
+#ifdef COMPILE_FAIL_METHOD_HIDES_FINAL
+/* A new method with the name of a final method of a class two levels up */
+#define CLASS_FinalLeaf(Base, Interface, Data, Event, Method, Override) \
+    Base(FinalMiddle) \
+    Method(int, get_value)
+#else
+#define CLASS_FinalLeaf(Base, Interface, Data, Event, Method, Override) \
+    Base(FinalMiddle)
+#endif
+
+SEALED()
+
+CONSTRUCTOR()
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+#ifdef COMPILE_FAIL_METHOD_HIDES_FINAL
+METHOD(int, get_value)
+    return 0;
+END_METHOD
+#endif
+
+
+#undef CLASS
+#define CLASS FinalOther
+#ifdef COMPILE_FAIL_SEALED_BASE
+/* A class derived from a sealed class */
+#define CLASS_FinalOther(Base, Interface, Data, Event, Method, Override) \
+    Base(FinalLeaf)
+#else
+#define CLASS_FinalOther(Base, Interface, Data, Event, Method, Override) \
+    Base(FinalMiddle)
+#endif
+
+CONSTRUCTOR()
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+
+/* A packed class, which can't implement interfaces */
+#define I_PackedGauge(Data, Event, Method) \
+    Data(char, level)
+CREATE_INTERFACE(PackedGauge)
+
+#undef CLASS
+#define CLASS PackedLeaf
+#ifdef COMPILE_FAIL_PACKED_INTERFACE
+#define CLASS_PackedLeaf(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) Interface(PackedGauge) \
+    Data(char, level) \
+    Data(double, weight)
+#else
+#define CLASS_PackedLeaf(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(char, level) \
+    Data(double, weight)
+#endif
+
+PACKED_CONSTRUCTOR()
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+
+/* Data members declared as arrays can't be columns of a struct of arrays */
+#undef CLASS
+#define CLASS NamedPoint
+#define CLASS_NamedPoint(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(int, x) \
+    Data(char, name[16])
+
+CONSTRUCTOR()
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+#ifdef COMPILE_FAIL_SOA_ARRAY_MEMBER
+SOA(NamedPoint)
+#endif
+
+
+int main(void) {
+    AUTODESTROY(FinalLeaf) leaf;
+    NEW_INPLACE(FinalLeaf, &leaf);
+    return CALL_FINAL(FinalRoot, get_value, &leaf);
+}
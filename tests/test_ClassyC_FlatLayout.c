@@ -0,0 +1,113 @@
+// test_ClassyC_FlatLayout.c
+#define CLASSYC_FLAT_LAYOUT
+#include "unity.h"
+#include "../ClassyC.h"
+#include <stdlib.h>
+
+
+
+
+
+
+
+/* Test Case: The members of derived classes use the tail padding of their base classes */
+/* The smallest members are declared last, so that the tail padding of each level is at the end of the object */
+#undef CLASS
+#define CLASS FlatBase
+#define CLASS_FlatBase(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Method(int, get_tag) \
+    Data(double, weight) \
+    Data(char, tag)
+
+CONSTRUCTOR(char tag)
+    self->weight = 1.5;
+    self->tag = tag;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(int, get_tag)
+    return self->tag;
+END_METHOD
+
+
+#undef CLASS
+#define CLASS FlatMiddle
+#define CLASS_FlatMiddle(Base, Interface, Data, Event, Method, Override) \
+    Base(FlatBase) \
+    Data(char, middle_tag) \
+    Override(int, get_tag)
+
+CONSTRUCTOR(char tag, char middle_tag)
+    INIT_BASE(tag);
+    self->middle_tag = middle_tag;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(int, get_tag)
+    return self->middle_tag;
+END_METHOD
+
+
+#undef CLASS
+#define CLASS FlatLeaf
+#define CLASS_FlatLeaf(Base, Interface, Data, Event, Method, Override) \
+    Base(FlatMiddle) \
+    Data(char, leaf_tag)
+
+CONSTRUCTOR(char tag, char middle_tag, char leaf_tag)
+    INIT_BASE(tag, middle_tag);
+    self->leaf_tag = leaf_tag;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+void test_FlatLayoutUsesTailPadding(void) {
+    /* The char members of the three levels are contiguous */
+    TEST_ASSERT_EQUAL_size_t(offsetof(FlatLeaf, tag) + 1, offsetof(FlatLeaf, middle_tag));
+    TEST_ASSERT_EQUAL_size_t(offsetof(FlatLeaf, middle_tag) + 1, offsetof(FlatLeaf, leaf_tag));
+    TEST_ASSERT_EQUAL_size_t(sizeof(FlatBase), sizeof(FlatLeaf));
+    TEST_ASSERT_EQUAL_size_t(CLASS_INFO(FlatBase)->padding - 2, CLASS_INFO(FlatLeaf)->padding);
+}
+
+void test_FlatLayoutKeepsBaseOffsets(void) {
+    TEST_ASSERT_EQUAL_size_t(offsetof(FlatBase, weight), offsetof(FlatLeaf, weight));
+    TEST_ASSERT_EQUAL_size_t(offsetof(FlatBase, tag), offsetof(FlatLeaf, tag));
+    TEST_ASSERT_EQUAL_size_t(offsetof(FlatBase, _destructor), offsetof(FlatLeaf, _destructor));
+    TEST_ASSERT_EQUAL_size_t(offsetof(FlatMiddle, middle_tag), offsetof(FlatLeaf, middle_tag));
+
+    AUTODESTROY_PTR(FlatLeaf) *leaf = NEW_ALLOC(FlatLeaf, 'a', 'b', 'c');
+    TEST_ASSERT_NOT_NULL(leaf);
+    FlatBase *as_base = (FlatBase *)leaf;
+    TEST_ASSERT_EQUAL_INT('a', as_base->tag);
+    TEST_ASSERT_EQUAL_INT('b', CALL(as_base, get_tag));
+    TEST_ASSERT_EQUAL_INT('b', ((FlatMiddle *)leaf)->middle_tag);
+    TEST_ASSERT_EQUAL_INT('c', leaf->leaf_tag);
+    TEST_ASSERT_EQUAL_INT(3, (int)(2 * leaf->weight));
+    TEST_ASSERT_TRUE(IS_A(leaf, FlatBase));
+}
+
+
+
+
+
+/* ==========================
+   Unity Setup
+   ========================== */
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_FlatLayoutUsesTailPadding);
+    RUN_TEST(test_FlatLayoutKeepsBaseOffsets);
+
+    return UNITY_END();
+}
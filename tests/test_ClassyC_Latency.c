@@ -0,0 +1,140 @@
+// test_ClassyC_Latency.c
+#include <stdint.h>
+/* A clock driven by the tests, so the recorded latencies are known */
+static uint64_t latency_clock = 0;
+#define CLASSYC_PROFILE_CLOCK() (latency_clock)
+#define CLASSYC_PROFILE_CLOCK_UNIT "ticks"
+#define CLASSYC_LATENCY
+#include "unity.h"
+#include "../ClassyC.h"
+#include <string.h>
+
+
+
+
+
+
+
+/* Test Case: Timed methods, event raises and event handlers record their latency */
+#define I_Ticker(Data, Event, Method) \
+    Event(on_tick, int ticks)
+CREATE_INTERFACE(Ticker)
+
+#undef CLASS
+#define CLASS LatencyClass
+#define CLASS_LatencyClass(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) Interface(Ticker) \
+    Event(on_tick, int ticks) \
+    Method(void, work, int ticks) \
+    Method(int, untimed, int ticks)
+
+CONSTRUCTOR()
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+/* Several returns: every call is recorded once */
+TIMED_METHOD(void, work, int ticks)
+    latency_clock += (uint64_t)ticks;
+    if (ticks > 1000) {
+        return;
+    }
+END_METHOD
+
+METHOD(int, untimed, int ticks)
+    latency_clock += (uint64_t)ticks;
+    return ticks;
+END_METHOD
+
+EVENT_HANDLER(LatencyClass, on_tick, slow_handler, int ticks)
+    latency_clock += (uint64_t)ticks;
+END_EVENT_HANDLER
+
+void test_LatencyTimedMethod(void) {
+    AUTODESTROY(LatencyClass) object;
+    int i;
+    NEW_INPLACE(LatencyClass, &object);
+    CLASSYC_LATENCY_RESET();
+    for (i = 0; i < 990; i++) object.work(&object, 10);
+    for (i = 0; i < 9; i++) object.work(&object, 100);
+    object.work(&object, 5000);
+    object.untimed(&object, 10);
+
+    TEST_ASSERT_EQUAL_UINT64(1000, CLASSYC_LATENCY_COUNT("LatencyClass::work"));
+    TEST_ASSERT_EQUAL_UINT64(0, CLASSYC_LATENCY_COUNT("LatencyClass::untimed"));
+    /* Values below 16 ticks are exact; above, buckets are 1/16 of a power of two wide */
+    TEST_ASSERT_EQUAL_UINT64(10, CLASSYC_LATENCY_PERCENTILE("LatencyClass::work", 50.0));
+    TEST_ASSERT_EQUAL_UINT64(10, CLASSYC_LATENCY_PERCENTILE("LatencyClass::work", 99.0));
+    TEST_ASSERT_EQUAL_UINT64(103, CLASSYC_LATENCY_PERCENTILE("LatencyClass::work", 99.9));
+    TEST_ASSERT_EQUAL_UINT64(5119, CLASSYC_LATENCY_PERCENTILE("LatencyClass::work", 100.0));
+    TEST_ASSERT_EQUAL_UINT64(0, CLASSYC_LATENCY_PERCENTILE("missing", 50.0));
+}
+
+void test_LatencyEvents(void) {
+    AUTODESTROY(LatencyClass) object;
+    int i;
+    NEW_INPLACE(LatencyClass, &object);
+    CLASSYC_LATENCY_RESET();
+
+    /* Raises without handlers are not recorded */
+    RAISE_EVENT(&object, on_tick, 1);
+    TEST_ASSERT_EQUAL_UINT64(0, CLASSYC_LATENCY_COUNT("on_tick"));
+
+    REGISTER_EVENT(LatencyClass, on_tick, slow_handler, &object);
+    for (i = 0; i < 10; i++) {
+        RAISE_EVENT(&object, on_tick, 50);
+    }
+    Ticker ticker = object.to_Ticker(&object);
+    RAISE_INTERFACE_EVENT(ticker, on_tick, 50);
+    Ticker_ref ref = INTERFACE_REF(&object, Ticker);
+    RAISE_REF_EVENT(ref, Ticker, on_tick, 50);
+
+    /* The raise sites of an event are merged by name; each handler has its own histogram */
+    TEST_ASSERT_EQUAL_UINT64(12, CLASSYC_LATENCY_COUNT("on_tick"));
+    TEST_ASSERT_EQUAL_UINT64(12, CLASSYC_LATENCY_COUNT("LatencyClass::on_tick:slow_handler"));
+    TEST_ASSERT_EQUAL_UINT64(51, CLASSYC_LATENCY_PERCENTILE("on_tick", 99.9));
+    TEST_ASSERT_EQUAL_UINT64(51, CLASSYC_LATENCY_PERCENTILE("LatencyClass::on_tick:slow_handler", 50.0));
+}
+
+void test_LatencyDump(void) {
+    char report[4096];
+    FILE *file = tmpfile();
+    size_t length;
+    AUTODESTROY(LatencyClass) object;
+    NEW_INPLACE(LatencyClass, &object);
+    CLASSYC_LATENCY_RESET();
+    object.work(&object, 3);
+
+    TEST_ASSERT_NOT_NULL(file);
+    CLASSYC_LATENCY_DUMP(file);
+    rewind(file);
+    length = fread(report, 1, sizeof(report) - 1, file);
+    report[length] = '\0';
+    fclose(file);
+    /* Names without values since the reset are left out */
+    TEST_ASSERT_NOT_NULL(strstr(report, "LatencyClass::work"));
+    TEST_ASSERT_NOT_NULL(strstr(report, "(ticks)"));
+    TEST_ASSERT_NULL(strstr(report, "on_tick"));
+}
+
+
+
+
+
+/* ==========================
+   Unity Setup
+   ========================== */
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_LatencyTimedMethod);
+    RUN_TEST(test_LatencyEvents);
+    RUN_TEST(test_LatencyDump);
+
+    return UNITY_END();
+}
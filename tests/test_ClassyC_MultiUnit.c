@@ -0,0 +1,90 @@
+// test_ClassyC_MultiUnit.c
+#include "unity.h"
+#include "test_ClassyC_MultiUnit.h"
+#include <stdlib.h>
+
+
+
+
+
+
+
+/* Test Case: Objects constructed in another translation unit have the type descriptors of that unit */
+/* The classes are defined in test_ClassyC_MultiUnit.h, included by both units */
+
+void test_MultiUnitTypeChecks(void) {
+    UnitShape *square = multi_unit_new_square(3);
+    UnitPlain *plain = multi_unit_new_plain();
+    TEST_ASSERT_NOT_NULL(square);
+    TEST_ASSERT_NOT_NULL(plain);
+
+    /* A copy of the descriptor, of the same class */
+    TEST_ASSERT_TRUE(CLASS_OF(square) != CLASS_INFO(UnitSquare));
+    TEST_ASSERT_EQUAL_STRING("UnitSquare", CLASS_OF(square)->name);
+    TEST_ASSERT_TRUE(IS_A(square, UnitSquare));
+    TEST_ASSERT_TRUE(IS_A(square, UnitShape));
+    TEST_ASSERT_TRUE(IS_A(square, OBJECT));
+    TEST_ASSERT_EQUAL_PTR(square, DYNAMIC_CAST(square, UnitSquare));
+    TEST_ASSERT_FALSE(IS_A(plain, UnitShape));
+    TEST_ASSERT_NULL(DYNAMIC_CAST(plain, UnitSquare));
+
+    /* And the other way round */
+    AUTODESTROY(UnitSquare) local_square;
+    AUTODESTROY(UnitShape) local_shape;
+    NEW_INPLACE(UnitSquare, &local_square, 2);
+    NEW_INPLACE(UnitShape, &local_shape, 2);
+    TEST_ASSERT_TRUE(multi_unit_is_square(&local_square));
+    TEST_ASSERT_FALSE(multi_unit_is_square(&local_shape));
+    TEST_ASSERT_FALSE(multi_unit_is_square(plain));
+
+    DESTROY_FREE(square);
+    DESTROY_FREE(plain);
+}
+
+void test_MultiUnitInterfaces(void) {
+    UnitShape *square = multi_unit_new_square(3);
+    UnitPlain *plain = multi_unit_new_plain();
+
+    /* The interface has another id in the other unit */
+    TEST_ASSERT_EQUAL_INT(9, REF_CALL(QUERY_INTERFACE(square, Area), area));
+    TEST_ASSERT_EQUAL_INT(9, REF_CALL(INTERFACE_REF(square, Area), area));
+    TEST_ASSERT_EQUAL_INT(3, REF_DATA(INTERFACE_REF(square, Area), Area, side));
+    TEST_ASSERT_NULL(QUERY_INTERFACE(plain, Area).desc);
+
+    AUTODESTROY(UnitSquare) local_square;
+    NEW_INPLACE(UnitSquare, &local_square, 4);
+    TEST_ASSERT_EQUAL_INT(16, multi_unit_ref_area(&local_square));
+    TEST_ASSERT_EQUAL_INT(-1, multi_unit_ref_area(plain));
+
+    DESTROY_FREE(square);
+    DESTROY_FREE(plain);
+}
+
+void test_MultiUnitClosedHierarchy(void) {
+    UnitShape *square = multi_unit_new_square(5);
+    TEST_ASSERT_EQUAL_INT(ClassyC_UnitSquare_hierarchy_id, CLASS_ID(UnitShape, square));
+    /* Not selected as a listed class, but called through its method table */
+    TEST_ASSERT_EQUAL_INT(25, CLOSED_CALL(UnitShape, area, square));
+    DESTROY_FREE(square);
+}
+
+
+
+
+
+/* ==========================
+   Unity Setup
+   ========================== */
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_MultiUnitTypeChecks);
+    RUN_TEST(test_MultiUnitInterfaces);
+    RUN_TEST(test_MultiUnitClosedHierarchy);
+
+    return UNITY_END();
+}
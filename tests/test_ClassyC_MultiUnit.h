@@ -0,0 +1,71 @@
+// test_ClassyC_MultiUnit.h
+/* Classes shared by the translation units of the multi-unit tests: each unit has its own copy of their descriptors */
+#ifndef TEST_CLASSYC_MULTI_UNIT_H
+#define TEST_CLASSYC_MULTI_UNIT_H
+#include "../ClassyC.h"
+
+#define I_Area(Data, Event, Method) \
+    Data(int, side) \
+    Method(int, area)
+CREATE_INTERFACE(Area)
+
+#undef CLASS
+#define CLASS UnitShape
+#define CLASS_UnitShape(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) Interface(Area) \
+    Data(int, side) \
+    Method(int, area)
+
+CONSTRUCTOR(int side)
+    self->side = side;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(int, area)
+    return 0;
+END_METHOD
+
+
+#undef CLASS
+#define CLASS UnitSquare
+#define CLASS_UnitSquare(Base, Interface, Data, Event, Method, Override) \
+    Base(UnitShape) \
+    Override(int, area)
+
+CONSTRUCTOR(int side)
+    INIT_BASE(side);
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(int, area)
+    return self->side * self->side;
+END_METHOD
+
+
+#undef CLASS
+#define CLASS UnitPlain
+#define CLASS_UnitPlain(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(int, side)
+
+CONSTRUCTOR()
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+
+#define HIERARCHY_UnitShape(Class) Class(UnitShape) Class(UnitSquare)
+CLOSED_HIERARCHY(UnitShape)
+
+/* Defined in test_ClassyC_MultiUnit_other.c */
+UnitShape *multi_unit_new_square(int side);
+UnitPlain *multi_unit_new_plain(void);
+bool multi_unit_is_square(const void *object);
+int multi_unit_ref_area(void *object);
+
+#endif
@@ -0,0 +1,27 @@
+// test_ClassyC_MultiUnit_other.c
+/* The second translation unit of the multi-unit tests */
+#include "../ClassyC.h"
+
+/* An interface that only this unit defines, so the interfaces of the classes have other ids than in the first unit */
+#define I_UnitOnly(Data, Event, Method) \
+    Data(int, side)
+CREATE_INTERFACE(UnitOnly)
+
+#include "test_ClassyC_MultiUnit.h"
+
+UnitShape *multi_unit_new_square(int side) {
+    return (UnitShape *)NEW_ALLOC(UnitSquare, side);
+}
+
+UnitPlain *multi_unit_new_plain(void) {
+    return NEW_ALLOC(UnitPlain);
+}
+
+bool multi_unit_is_square(const void *object) {
+    return IS_A(object, UnitSquare);
+}
+
+int multi_unit_ref_area(void *object) {
+    Area_ref ref = QUERY_INTERFACE(object, Area);
+    return ref.desc ? REF_CALL(ref, area) : -1;
+}
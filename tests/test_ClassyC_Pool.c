@@ -0,0 +1,192 @@
+// test_ClassyC_Pool.c
+#define CLASSYC_ENABLE_POOLS
+#include "unity.h"
+#include "../ClassyC.h"
+#include <stdlib.h>
+
+
+
+
+
+
+
+/* Test Case: Pooled classes allocate their heap objects from the class pool */
+#undef CLASS
+#define CLASS PooledBase
+#define CLASS_PooledBase(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(int, value) \
+    Data(double, weight) \
+    Method(int, get_value)
+
+POOL(4)
+
+CONSTRUCTOR(int initial_value)
+    self->value = initial_value;
+END_CONSTRUCTOR
+
+static int pooled_destruct_calls = 0;
+DESTRUCTOR()
+    if (!is_base) pooled_destruct_calls++;
+END_DESTRUCTOR
+
+METHOD(int, get_value)
+    return self->value;
+END_METHOD
+
+
+#undef CLASS
+#define CLASS PooledDerived
+#define CLASS_PooledDerived(Base, Interface, Data, Event, Method, Override) \
+    Base(PooledBase) \
+    Data(char, tag)
+
+CONSTRUCTOR(int initial_value, char tag)
+    INIT_BASE(initial_value);
+    self->tag = tag;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+    if (!is_base) pooled_destruct_calls++;
+END_DESTRUCTOR
+
+POOL(2)
+
+
+/* Not pooled: uses calloc and free */
+#undef CLASS
+#define CLASS Unpooled
+#define CLASS_Unpooled(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(int, value)
+
+CONSTRUCTOR(int initial_value)
+    self->value = initial_value;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+void test_PoolAllocation(void) {
+    PooledBase *objects[10];
+    int i;
+    for (i = 0; i < 10; i++) {
+        objects[i] = NEW_ALLOC(PooledBase, i);
+        TEST_ASSERT_NOT_NULL(objects[i]);
+        TEST_ASSERT_EQUAL_PTR(&ClassyC_PooledBase_pool, objects[i]->_pool);
+        TEST_ASSERT_EQUAL_INT(i, objects[i]->get_value(objects[i]));
+        TEST_ASSERT_EQUAL_INT(0, (int)objects[i]->weight);
+    }
+    /* Slots of the same chunk are contiguous */
+    TEST_ASSERT_EQUAL_PTR((char *)objects[0] + ClassyC_PooledBase_pool.slot_size, objects[1]);
+    for (i = 0; i < 10; i++) {
+        DESTROY_FREE(objects[i]);
+        TEST_ASSERT_NULL(objects[i]);
+    }
+}
+
+void test_PoolReusesFreedSlots(void) {
+    pooled_destruct_calls = 0;
+    PooledBase *first = NEW_ALLOC(PooledBase, 1);
+    void *first_address = first;
+    DESTROY_FREE(first);
+    TEST_ASSERT_EQUAL_INT(1, pooled_destruct_calls);
+
+    /* The last freed slot is the next one handed out, zeroed */
+    AUTODESTROY_PTR(PooledBase) *second = NEW_ALLOC(PooledBase, 2);
+    TEST_ASSERT_EQUAL_PTR(first_address, second);
+    TEST_ASSERT_EQUAL_INT(2, second->value);
+    TEST_ASSERT_EQUAL_INT(0, (int)second->weight);
+}
+
+void test_PoolDerivedClassAndBaseCast(void) {
+    pooled_destruct_calls = 0;
+    PooledDerived *derived = NEW_ALLOC(PooledDerived, 5, 'x');
+    TEST_ASSERT_NOT_NULL(derived);
+    TEST_ASSERT_EQUAL_PTR(&ClassyC_PooledDerived_pool, derived->_pool);
+    TEST_ASSERT_EQUAL_INT(5, derived->get_value(derived));
+
+    /* Destroying through the base class returns the object to the pool of the derived class */
+    PooledBase *as_base = (PooledBase *)derived;
+    DESTROY_FREE(as_base);
+    TEST_ASSERT_EQUAL_INT(1, pooled_destruct_calls);
+    TEST_ASSERT_EQUAL_PTR(derived, ClassyC_PooledDerived_pool.free_list);
+}
+
+void test_PoolNoZeroAllocation(void) {
+    PooledBase *first = NEW_ALLOC(PooledBase, 1);
+    void *first_address = first;
+    first->weight = 2.5;
+    DESTROY_FREE(first);
+
+    /* The freed slot is reused without zeroing, but its pool is recorded */
+    PooledBase *second = NEW_ALLOC_NOZERO(PooledBase, 2);
+    TEST_ASSERT_EQUAL_PTR(first_address, second);
+    TEST_ASSERT_EQUAL_PTR(&ClassyC_PooledBase_pool, second->_pool);
+    TEST_ASSERT_EQUAL_INT(2, second->get_value(second));
+    DESTROY_FREE(second);
+
+    Unpooled *unpooled = NEW_ALLOC_NOZERO(Unpooled, 3);
+    TEST_ASSERT_NOT_NULL(unpooled);
+    TEST_ASSERT_NULL(unpooled->_pool);
+    TEST_ASSERT_EQUAL_INT(3, unpooled->value);
+    DESTROY_FREE(unpooled);
+
+    /* Memory given to the constructor has no pool, even if it is not zeroed */
+    PooledBase stack_obj;
+    memset(&stack_obj, 0xAB, sizeof(stack_obj));
+    NEW_INPLACE_NOZERO(PooledBase, &stack_obj, 4);
+    TEST_ASSERT_NULL(stack_obj._pool);
+    TEST_ASSERT_EQUAL_INT(4, stack_obj.get_value(&stack_obj));
+    DESTROY(stack_obj);
+}
+
+void test_PoolUnpooledAndInplaceObjects(void) {
+    AUTODESTROY_PTR(Unpooled) *heap_obj = NEW_ALLOC(Unpooled, 1);
+    AUTODESTROY(PooledBase) stack_obj;
+    NEW_INPLACE(PooledBase, &stack_obj, 3);
+    TEST_ASSERT_NOT_NULL(heap_obj);
+    TEST_ASSERT_NULL(heap_obj->_pool);
+    TEST_ASSERT_NULL(stack_obj._pool);
+    TEST_ASSERT_EQUAL_INT(3, stack_obj.get_value(&stack_obj));
+    DESTROY_FREE(heap_obj);
+}
+
+void test_PoolRelease(void) {
+    AUTODESTROY_PTR(PooledDerived) *derived = NEW_ALLOC(PooledDerived, 1, 'a');
+    DESTROY_FREE(derived);
+    POOL_RELEASE(PooledDerived);
+    TEST_ASSERT_NULL(ClassyC_PooledDerived_pool.chunks);
+    TEST_ASSERT_NULL(ClassyC_PooledDerived_pool.free_list);
+
+    /* The pool can still be used after being released */
+    derived = NEW_ALLOC(PooledDerived, 2, 'b');
+    TEST_ASSERT_NOT_NULL(derived);
+    TEST_ASSERT_EQUAL_INT(2, derived->value);
+}
+
+
+
+
+
+/* ==========================
+   Unity Setup
+   ========================== */
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_PoolAllocation);
+    RUN_TEST(test_PoolReusesFreedSlots);
+    RUN_TEST(test_PoolDerivedClassAndBaseCast);
+    RUN_TEST(test_PoolNoZeroAllocation);
+    RUN_TEST(test_PoolUnpooledAndInplaceObjects);
+    RUN_TEST(test_PoolRelease);
+
+    POOL_RELEASE(PooledBase);
+    POOL_RELEASE(PooledDerived);
+    return UNITY_END();
+}
@@ -0,0 +1,203 @@
+// test_ClassyC_Profile.c
+#define CLASSYC_PROFILE
+#include "unity.h"
+#include "../ClassyC.h"
+#include <pthread.h>
+#include <sched.h>
+
+
+
+
+
+
+
+/* Test Case: Methods, constructors, destructors and event handlers count their calls */
+#undef CLASS
+#define CLASS ProfiledBase
+#define CLASS_ProfiledBase(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(int, value) \
+    Event(on_change, int value) \
+    Method(int, get_value) \
+    Method(int, sum_to, int limit)
+
+CONSTRUCTOR(int initial_value)
+    self->value = initial_value;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(int, get_value)
+    return self->value;
+END_METHOD
+
+/* Recursive, with several returns: every call is counted once */
+METHOD(int, sum_to, int limit)
+    if (limit <= 0) {
+        return 0;
+    }
+    return limit + self->sum_to(self, limit - 1);
+END_METHOD
+
+
+#undef CLASS
+#define CLASS ProfiledDerived
+#define CLASS_ProfiledDerived(Base, Interface, Data, Event, Method, Override) \
+    Base(ProfiledBase) \
+    Override(int, get_value)
+
+CONSTRUCTOR(int initial_value)
+    INIT_BASE(initial_value);
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(int, get_value)
+    return 2 * self->value;
+END_METHOD
+
+static int profiled_changes = 0;
+EVENT_HANDLER(ProfiledBase, on_change, count_change, int value)
+    profiled_changes += value;
+END_EVENT_HANDLER
+
+void test_ProfileCounts(void) {
+    CLASSYC_PROFILE_RESET();
+    ProfiledBase *base = NEW_ALLOC(ProfiledBase, 3);
+    ProfiledDerived *derived = NEW_ALLOC(ProfiledDerived, 4);
+    int i;
+    for (i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_INT(3, base->get_value(base));
+        TEST_ASSERT_EQUAL_INT(8, derived->get_value(derived));
+    }
+    TEST_ASSERT_EQUAL_INT(10, base->sum_to(base, 4));
+    REGISTER_EVENT(ProfiledBase, on_change, count_change, base);
+    RAISE_EVENT(base, on_change, 7);
+    TEST_ASSERT_EQUAL_INT(7, profiled_changes);
+    DESTROY_FREE(base);
+    DESTROY_FREE(derived);
+
+    TEST_ASSERT_EQUAL_UINT64(5, CLASSYC_PROFILE_GET(ProfiledBase, "get_value").calls);
+    TEST_ASSERT_EQUAL_UINT64(5, CLASSYC_PROFILE_GET(ProfiledDerived, "get_value").calls);
+    TEST_ASSERT_EQUAL_UINT64(5, CLASSYC_PROFILE_GET(ProfiledBase, "sum_to").calls);
+    TEST_ASSERT_EQUAL_UINT64(1, CLASSYC_PROFILE_GET(ProfiledBase, "on_change:count_change").calls);
+    /* Base class constructors and destructors run for the derived objects too */
+    TEST_ASSERT_EQUAL_UINT64(2, CLASSYC_PROFILE_GET(ProfiledBase, "constructor").calls);
+    TEST_ASSERT_EQUAL_UINT64(1, CLASSYC_PROFILE_GET(ProfiledDerived, "constructor").calls);
+    TEST_ASSERT_EQUAL_UINT64(2, CLASSYC_PROFILE_GET(ProfiledBase, "destructor").calls);
+    TEST_ASSERT_EQUAL_UINT64(0, CLASSYC_PROFILE_GET(ProfiledDerived, "missing").calls);
+    /* The outer recursive call includes the time of the inner ones */
+    TEST_ASSERT_TRUE(CLASSYC_PROFILE_GET(ProfiledBase, "sum_to").ticks > 0);
+
+    CLASSYC_PROFILE_RESET();
+    TEST_ASSERT_EQUAL_UINT64(0, CLASSYC_PROFILE_GET(ProfiledBase, "get_value").calls);
+}
+
+/* Every thread counts in its own counters, merged when read */
+#define PROFILE_THREADS 4
+#define PROFILE_THREAD_CALLS 1000
+static int profile_thread_ids[PROFILE_THREADS];
+static _Atomic int profile_threads_done;
+static void *profile_thread(void *argument) {
+    ProfiledBase object;
+    int i, sum = 0;
+    NEW_INPLACE(ProfiledBase, &object, 1);
+    for (i = 0; i < PROFILE_THREAD_CALLS; i++) {
+        sum += object.get_value(&object);
+    }
+    DESTROY(object);
+    /* Wait for the other threads of the round, so they all hold their counters at once: the number of counters */
+    /* doesn't depend on how the threads were scheduled */
+    atomic_fetch_add(&profile_threads_done, 1);
+    while (atomic_load(&profile_threads_done) < PROFILE_THREADS) {
+        sched_yield();
+    }
+    return sum == PROFILE_THREAD_CALLS ? argument : NULL;
+}
+
+static void profile_run_threads(void) {
+    pthread_t threads[PROFILE_THREADS];
+    int i;
+    atomic_store(&profile_threads_done, 0);
+    for (i = 0; i < PROFILE_THREADS; i++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, profile_thread, &profile_thread_ids[i]));
+    }
+    for (i = 0; i < PROFILE_THREADS; i++) {
+        void *result;
+        pthread_join(threads[i], &result);
+        TEST_ASSERT_NOT_NULL(result);
+    }
+}
+
+/* Counters in the list, checking that each one has a cache line of its own */
+static size_t profile_counter_count(void) {
+    ClassyC_profile_counter *counter = atomic_load(&ClassyC_profile_counters);
+    size_t count = 0;
+    for (; counter; counter = counter->next) {
+        TEST_ASSERT_EQUAL_UINT(0, (uintptr_t)counter % CLASSYC_CACHE_LINE);
+        count++;
+    }
+    return count;
+}
+
+void test_ProfileThreads(void) {
+    size_t counters;
+    TEST_ASSERT_EQUAL_size_t(0, sizeof(ClassyC_profile_counter) % CLASSYC_CACHE_LINE);
+    CLASSYC_PROFILE_RESET();
+    profile_run_threads();
+    TEST_ASSERT_EQUAL_UINT64(PROFILE_THREADS * PROFILE_THREAD_CALLS, CLASSYC_PROFILE_GET(ProfiledBase, "get_value").calls);
+    TEST_ASSERT_EQUAL_UINT64(PROFILE_THREADS, CLASSYC_PROFILE_GET(ProfiledBase, "constructor").calls);
+
+    /* The threads started later reuse the counters of the ended ones, which keep their totals */
+    counters = profile_counter_count();
+    profile_run_threads();
+    profile_run_threads();
+    TEST_ASSERT_EQUAL_size_t(counters, profile_counter_count());
+    TEST_ASSERT_EQUAL_UINT64(3 * PROFILE_THREADS * PROFILE_THREAD_CALLS, CLASSYC_PROFILE_GET(ProfiledBase, "get_value").calls);
+    TEST_ASSERT_EQUAL_UINT64(3 * PROFILE_THREADS, CLASSYC_PROFILE_GET(ProfiledBase, "constructor").calls);
+}
+
+void test_ProfileDump(void) {
+    char report[4096];
+    FILE *file = tmpfile();
+    size_t length;
+    CLASSYC_PROFILE_RESET();
+    ProfiledBase *object = NEW_ALLOC(ProfiledBase, 1);
+    object->sum_to(object, 50);
+    object->get_value(object);
+    DESTROY_FREE(object);
+
+    TEST_ASSERT_NOT_NULL(file);
+    CLASSYC_PROFILE_DUMP(file);
+    rewind(file);
+    length = fread(report, 1, sizeof(report) - 1, file);
+    report[length] = '\0';
+    fclose(file);
+    /* Sorted by total time: the recursive method first, functions not called since the reset are left out */
+    TEST_ASSERT_NOT_NULL(strstr(report, "ProfiledBase::sum_to"));
+    TEST_ASSERT_TRUE(strstr(report, "ProfiledBase::sum_to") < strstr(report, "ProfiledBase::get_value"));
+    TEST_ASSERT_NULL(strstr(report, "ProfiledDerived::get_value"));
+}
+
+
+
+
+
+/* ==========================
+   Unity Setup
+   ========================== */
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_ProfileCounts);
+    RUN_TEST(test_ProfileThreads);
+    RUN_TEST(test_ProfileDump);
+
+    return UNITY_END();
+}
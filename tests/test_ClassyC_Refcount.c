@@ -0,0 +1,148 @@
+// test_ClassyC_Refcount.c
+// Also built with CLASSYC_REFCOUNT_NONATOMIC defined by the makefile
+#define CLASSYC_ENABLE_REFCOUNT
+#include "unity.h"
+#include "../ClassyC.h"
+
+
+
+
+
+
+
+/* Test Case: Reference counted objects are destroyed when the last reference is released */
+#undef CLASS
+#define CLASS Shared
+#define CLASS_Shared(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(int, value) \
+    Method(int, get_value)
+
+static int shared_destruct_calls = 0;
+CONSTRUCTOR(int initial_value)
+    self->value = initial_value;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+    if (!is_base) shared_destruct_calls++;
+END_DESTRUCTOR
+
+METHOD(int, get_value)
+    return self->value;
+END_METHOD
+
+
+#undef CLASS
+#define CLASS SharedDerived
+#define CLASS_SharedDerived(Base, Interface, Data, Event, Method, Override) \
+    Base(Shared) \
+    Data(int, extra)
+
+CONSTRUCTOR(int initial_value)
+    INIT_BASE(initial_value);
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+    if (!is_base) shared_destruct_calls++;
+END_DESTRUCTOR
+
+void test_RefcountNewObjectHasOneReference(void) {
+    shared_destruct_calls = 0;
+    Shared *obj = NEW_ALLOC(Shared, 1);
+    TEST_ASSERT_NOT_NULL(obj);
+    TEST_ASSERT_EQUAL_size_t(1, obj->_refcount);
+    RELEASE(obj);
+    TEST_ASSERT_NULL(obj);
+    TEST_ASSERT_EQUAL_INT(1, shared_destruct_calls);
+
+    Shared *nozero = NEW_ALLOC_NOZERO(Shared, 2);
+    TEST_ASSERT_EQUAL_size_t(1, nozero->_refcount);
+    RELEASE(nozero);
+    TEST_ASSERT_EQUAL_INT(2, shared_destruct_calls);
+}
+
+void test_RefcountRetainAndRelease(void) {
+    shared_destruct_calls = 0;
+    Shared *owner = NEW_ALLOC(Shared, 7);
+    Shared *other_owner = RETAIN(owner);
+    TEST_ASSERT_EQUAL_PTR(owner, other_owner);
+    TEST_ASSERT_EQUAL_size_t(2, owner->_refcount);
+
+    /* The object survives until its last reference is released */
+    RELEASE(owner);
+    TEST_ASSERT_NULL(owner);
+    TEST_ASSERT_EQUAL_INT(0, shared_destruct_calls);
+    TEST_ASSERT_EQUAL_INT(7, CALL(other_owner, get_value));
+    RELEASE(other_owner);
+    TEST_ASSERT_EQUAL_INT(1, shared_destruct_calls);
+
+    /* NULL pointers are ignored */
+    TEST_ASSERT_NULL(RETAIN(owner));
+    RELEASE(owner);
+    TEST_ASSERT_EQUAL_INT(1, shared_destruct_calls);
+}
+
+void test_RefcountThroughBaseClass(void) {
+    shared_destruct_calls = 0;
+    SharedDerived *derived = NEW_ALLOC(SharedDerived, 3);
+    Shared *as_base = RETAIN((Shared *)derived);
+    RELEASE(derived);
+    TEST_ASSERT_EQUAL_INT(0, shared_destruct_calls);
+    /* The last release runs the destructor of the derived class */
+    RELEASE(as_base);
+    TEST_ASSERT_EQUAL_INT(1, shared_destruct_calls);
+}
+
+static Shared *kept_reference = NULL;
+static void scoped_owner(Shared *obj) {
+    AUTODESTROY_PTR(Shared) *scoped = RETAIN(obj);
+    kept_reference = obj;
+    TEST_ASSERT_EQUAL_size_t(2, scoped->_refcount);
+#if CLASSYC_AUTO_DESTROY_SUPPORTED == 0
+    RELEASE(scoped);
+#endif
+}
+
+void test_RefcountAutodestroyDropsReference(void) {
+    shared_destruct_calls = 0;
+    Shared *obj = NEW_ALLOC(Shared, 4);
+    /* Leaving the scope only drops the reference of the scoped pointer */
+    scoped_owner(obj);
+    TEST_ASSERT_EQUAL_INT(0, shared_destruct_calls);
+    TEST_ASSERT_EQUAL_size_t(1, kept_reference->_refcount);
+    RELEASE(kept_reference);
+    TEST_ASSERT_EQUAL_INT(1, shared_destruct_calls);
+    TEST_ASSERT_NULL(kept_reference);
+}
+
+void test_RefcountDestroyFreeIgnoresReferences(void) {
+    shared_destruct_calls = 0;
+    Shared *obj = NEW_ALLOC(Shared, 5);
+    (void)RETAIN(obj);
+    DESTROY_FREE(obj);
+    TEST_ASSERT_NULL(obj);
+    TEST_ASSERT_EQUAL_INT(1, shared_destruct_calls);
+}
+
+
+
+
+
+/* ==========================
+   Unity Setup
+   ========================== */
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_RefcountNewObjectHasOneReference);
+    RUN_TEST(test_RefcountRetainAndRelease);
+    RUN_TEST(test_RefcountThroughBaseClass);
+    RUN_TEST(test_RefcountAutodestroyDropsReference);
+    RUN_TEST(test_RefcountDestroyFreeIgnoresReferences);
+
+    return UNITY_END();
+}
@@ -0,0 +1,186 @@
+// test_ClassyC_SharedVtable.c
+#define CLASSYC_SHARED_VTABLE
+#include "unity.h"
+#include "../ClassyC.h"
+#include <stdlib.h>
+
+
+
+
+
+
+
+/* Test Case: Methods are reached through the shared method table */
+#define I_Priced(Data, Event, Method) \
+    Data(int, price) \
+    Method(int, get_price)
+CREATE_INTERFACE(Priced)
+
+#undef CLASS
+#define CLASS VtBase
+#define CLASS_VtBase(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Interface(Priced) \
+    Data(int, price) \
+    Method(int, get_price) \
+    Method(int, get_overridable_value) \
+    Method(int, get_incremental_value) \
+    Method(void, set_price, int)
+
+CONSTRUCTOR(int initial_price)
+    self->price = initial_price;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(int, get_price)
+    return self->price;
+END_METHOD
+
+METHOD(int, get_overridable_value)
+    return 1;
+END_METHOD
+
+METHOD(int, get_incremental_value)
+    return 1;
+END_METHOD
+
+METHOD(void, set_price, int new_price)
+    self->price = new_price;
+END_METHOD
+
+
+#undef CLASS
+#define CLASS VtDerived
+#define CLASS_VtDerived(Base, Interface, Data, Event, Method, Override) \
+    Base(VtBase) \
+    Data(int, derived_value) \
+    Method(int, get_derived_value) \
+    Override(int, get_overridable_value) \
+    Override(int, get_incremental_value)
+
+CONSTRUCTOR(int initial_price, int derived_initial)
+    INIT_BASE(initial_price);
+    self->derived_value = derived_initial;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(int, get_derived_value)
+    return self->derived_value;
+END_METHOD
+
+METHOD(int, get_overridable_value)
+    return 2;
+END_METHOD
+
+METHOD(int, get_incremental_value)
+    return BASE_METHOD(get_incremental_value) + 2;
+END_METHOD
+
+
+/* Same data as VtBase, no methods */
+#undef CLASS
+#define CLASS VtPlain
+#define CLASS_VtPlain(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(int, price)
+
+CONSTRUCTOR()
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+void test_SharedVtableCalls(void) {
+    AUTODESTROY_PTR(VtBase) *obj = NEW_ALLOC(VtBase, 10);
+    TEST_ASSERT_NOT_NULL(obj);
+    TEST_ASSERT_EQUAL_INT(10, CALL(obj, get_price));
+    CALL(obj, set_price, 30);
+    TEST_ASSERT_EQUAL_INT(30, CALL(obj, get_price));
+    TEST_ASSERT_EQUAL_INT(30, obj->_vt->get_price(obj));
+    DESTROY_FREE(obj);
+}
+
+void test_SharedVtableOverrideAndCast(void) {
+    AUTODESTROY_PTR(VtDerived) *obj = NEW_ALLOC(VtDerived, 100, 200);
+    AUTODESTROY(VtDerived) stack_obj;
+    NEW_INPLACE(VtDerived, &stack_obj, 1, 2);
+    VtBase *base_obj = (VtBase *)obj;
+    TEST_ASSERT_NOT_NULL(obj);
+    TEST_ASSERT_EQUAL_INT(100, CALL(obj, get_price));
+    TEST_ASSERT_EQUAL_INT(200, CALL(obj, get_derived_value));
+    TEST_ASSERT_EQUAL_INT(2, CALL(obj, get_overridable_value));
+    TEST_ASSERT_EQUAL_INT(2, CALL(base_obj, get_overridable_value));
+    TEST_ASSERT_EQUAL_INT(3, CALL(obj, get_incremental_value));
+    TEST_ASSERT_EQUAL_INT(3, CALL(base_obj, get_incremental_value));
+    /* All the objects of a class share the same table: its constant static method table */
+    TEST_ASSERT_EQUAL_PTR(obj->_vt, stack_obj._vt);
+    TEST_ASSERT_EQUAL_PTR(&ClassyC_VtDerived_static_vtable, obj->_vt);
+    DESTROY_FREE(obj);
+}
+
+void test_SharedVtableInterface(void) {
+    AUTODESTROY_PTR(VtDerived) *obj = NEW_ALLOC(VtDerived, 100, 200);
+    Priced priced = CALL(obj, to_Priced);
+    TEST_ASSERT_EQUAL_PTR(obj, priced.self);
+    TEST_ASSERT_EQUAL_INT(100, *priced.price);
+    TEST_ASSERT_EQUAL_INT(100, priced.get_price(priced.self));
+    DESTROY_FREE(obj);
+}
+
+void test_SharedVtableInterfaceReference(void) {
+    AUTODESTROY_PTR(VtDerived) *obj = NEW_ALLOC(VtDerived, 100, 200);
+    VtBase *as_base = (VtBase *)obj;
+    Priced_ref priced = INTERFACE_REF(as_base, Priced);
+    /* The descriptor is stored in the method table */
+    TEST_ASSERT_EQUAL_PTR(obj->_vt->_desc_Priced, priced.desc);
+    TEST_ASSERT_EQUAL_INT(100, REF_CALL(priced, get_price));
+    REF_DATA(priced, Priced, price) = 150;
+    TEST_ASSERT_EQUAL_INT(150, CALL(obj, get_price));
+    DESTROY_FREE(obj);
+}
+
+void test_SharedVtableObjectSize(void) {
+    /* Methods don't take space in the objects */
+    TEST_ASSERT_EQUAL_UINT(sizeof(VtPlain), sizeof(VtBase));
+    /* Neither does the type descriptor: it is reached through the method table */
+    TEST_ASSERT_EQUAL_UINT(sizeof(void *) + sizeof(void (*)(void *)), sizeof(OBJECT));
+}
+
+void test_SharedVtableTypeChecks(void) {
+    AUTODESTROY_PTR(VtDerived) *obj = NEW_ALLOC(VtDerived, 1, 2);
+    VtBase *base_obj = (VtBase *)obj;
+    TEST_ASSERT_EQUAL_PTR(CLASS_INFO(VtDerived), CLASS_OF(base_obj));
+    TEST_ASSERT_TRUE(IS_A(base_obj, VtDerived));
+    TEST_ASSERT_TRUE(IS_A(base_obj, OBJECT));
+    TEST_ASSERT_NULL(DYNAMIC_CAST(base_obj, VtPlain));
+    TEST_ASSERT_NOT_NULL(QUERY_INTERFACE(base_obj, Priced).desc);
+    DESTROY_FREE(obj);
+}
+
+
+
+
+
+/* ==========================
+   Unity Setup
+   ========================== */
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_SharedVtableCalls);
+    RUN_TEST(test_SharedVtableOverrideAndCast);
+    RUN_TEST(test_SharedVtableInterface);
+    RUN_TEST(test_SharedVtableInterfaceReference);
+    RUN_TEST(test_SharedVtableObjectSize);
+    RUN_TEST(test_SharedVtableTypeChecks);
+
+    return UNITY_END();
+}
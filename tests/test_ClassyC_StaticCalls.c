@@ -0,0 +1,185 @@
+// test_ClassyC_StaticCalls.c
+#define CLASSYC_STATIC_CALLS
+#include "unity.h"
+#include "../ClassyC.h"
+#include <stdlib.h>
+
+
+
+
+
+
+
+/* Test Case: CALL is static for the final classes and dynamic for the others */
+#define I_Measurable(Data, Event, Method) \
+    Method(int, measure)
+CREATE_INTERFACE(Measurable)
+
+#undef CLASS
+#define CLASS Shape
+#define CLASS_Shape(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) Interface(Measurable) \
+    Data(int, side) \
+    Method(int, measure) \
+    Method(int, get_side) \
+    Method(int, scaled, int factor)
+
+CONSTRUCTOR(int side)
+    self->side = side;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(int, measure)
+    return self->side;
+END_METHOD
+
+METHOD(int, get_side)
+    return self->side;
+END_METHOD
+
+METHOD(int, scaled, int factor)
+    return self->side * factor;
+END_METHOD
+
+
+#undef CLASS
+#define CLASS Square
+#define CLASS_Square(Base, Interface, Data, Event, Method, Override) \
+    Base(Shape) \
+    Override(int, measure)
+
+CONSTRUCTOR(int side)
+    INIT_BASE(side);
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(int, measure)
+    return self->side * self->side;
+END_METHOD
+
+/* Test Case: method tables of classes with many methods (they have no limit on the number of methods) */
+#define WIDE_METHODS(Method) \
+    Method(int, m0) Method(int, m1) Method(int, m2) Method(int, m3) Method(int, m4) Method(int, m5) Method(int, m6) Method(int, m7) \
+    Method(int, m8) Method(int, m9) Method(int, m10) Method(int, m11) Method(int, m12) Method(int, m13) Method(int, m14) Method(int, m15) \
+    Method(int, m16) Method(int, m17) Method(int, m18) Method(int, m19) Method(int, m20) Method(int, m21) Method(int, m22) Method(int, m23) \
+    Method(int, m24) Method(int, m25) Method(int, m26) Method(int, m27) Method(int, m28) Method(int, m29) Method(int, m30) Method(int, m31) \
+    Method(int, m32) Method(int, m33) Method(int, m34) Method(int, m35) Method(int, m36) Method(int, m37) Method(int, m38) Method(int, m39)
+#undef CLASS
+#define CLASS Wide
+#define CLASS_Wide(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    WIDE_METHODS(Method)
+
+CONSTRUCTOR()
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+#define WIDE_METHOD(ret_type, method_name) METHOD(ret_type, method_name) return 1; END_METHOD
+WIDE_METHODS(WIDE_METHOD)
+
+
+#undef CLASS
+#define CLASS WideDerived
+#define CLASS_WideDerived(Base, Interface, Data, Event, Method, Override) \
+    Base(Wide) \
+    WIDE_METHODS(Override)
+
+CONSTRUCTOR()
+    INIT_BASE();
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+#undef WIDE_METHOD
+#define WIDE_METHOD(ret_type, method_name) METHOD(ret_type, method_name) return 2; END_METHOD
+WIDE_METHODS(WIDE_METHOD)
+
+/* Square is never derived from */
+#define CLASSYC_FINAL_CLASSES(X) X(Square)
+
+/* Replace the method table (or the method pointers) of the object, so dynamic calls can be told apart */
+static void redirect_to_shape_methods(Square *square) {
+#ifdef CLASSYC_SHARED_VTABLE
+    square->_vt = (const ClassyC_Square_vtable *)(const void *)&ClassyC_Shape_static_vtable;
+#else
+    square->measure = ClassyC_Shape_measure;
+#endif
+}
+
+void test_StaticCallsOnFinalClass(void) {
+    AUTODESTROY(Square) square;
+    NEW_INPLACE(Square, &square, 3);
+    Square *square_ptr = &square;
+    TEST_ASSERT_EQUAL_INT(9, CALL(square_ptr, measure));
+    TEST_ASSERT_EQUAL_INT(6, CALL(square_ptr, scaled, 2));
+    TEST_ASSERT_EQUAL_INT(9, CALL(square_ptr, to_Measurable).measure(square_ptr));
+
+    /* Calls on a Square pointer don't read the method pointers of the object */
+    redirect_to_shape_methods(square_ptr);
+    TEST_ASSERT_EQUAL_INT(9, CALL(square_ptr, measure));
+    TEST_ASSERT_EQUAL_INT(6, CALL(square_ptr, scaled, 2));
+    TEST_ASSERT_EQUAL_INT(3, CALL(square_ptr, get_side));
+}
+
+void test_DynamicCallsOnOtherTypes(void) {
+    AUTODESTROY(Square) square;
+    AUTODESTROY(Shape) shape;
+    NEW_INPLACE(Square, &square, 3);
+    NEW_INPLACE(Shape, &shape, 4);
+    Shape *as_shape = (Shape *)&square;
+    Shape *shape_ptr = &shape;
+
+    /* Shape is not final: calls go through the method pointers and see the override */
+    TEST_ASSERT_EQUAL_INT(9, CALL(as_shape, measure));
+    TEST_ASSERT_EQUAL_INT(4, CALL(shape_ptr, measure));
+    TEST_ASSERT_EQUAL_INT(8, CALL(shape_ptr, scaled, 2));
+
+    redirect_to_shape_methods(&square);
+    TEST_ASSERT_EQUAL_INT(3, CALL(as_shape, measure));
+}
+
+void test_StaticCallMacro(void) {
+    AUTODESTROY(Square) square;
+    NEW_INPLACE(Square, &square, 5);
+    TEST_ASSERT_EQUAL_INT(25, CALL_STATIC(Square, measure, &square));
+    TEST_ASSERT_EQUAL_INT(5, CALL_STATIC(Shape, measure, &square));
+    TEST_ASSERT_EQUAL_INT(15, CALL_STATIC(Square, scaled, &square, 3));
+}
+
+void test_ManyMethods(void) {
+    AUTODESTROY(WideDerived) derived;
+    NEW_INPLACE(WideDerived, &derived);
+    TEST_ASSERT_EQUAL_INT(2, CALL_STATIC(WideDerived, m0, &derived));
+    TEST_ASSERT_EQUAL_INT(2, CALL_STATIC(WideDerived, m39, &derived));
+    TEST_ASSERT_EQUAL_INT(1, CALL_STATIC(Wide, m39, &derived));
+    TEST_ASSERT_EQUAL_INT(2, CALL((Wide *)&derived, m20));
+}
+
+
+
+
+
+/* ==========================
+   Unity Setup
+   ========================== */
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_StaticCallsOnFinalClass);
+    RUN_TEST(test_DynamicCallsOnOtherTypes);
+    RUN_TEST(test_StaticCallMacro);
+    RUN_TEST(test_ManyMethods);
+
+    return UNITY_END();
+}
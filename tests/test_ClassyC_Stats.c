@@ -0,0 +1,144 @@
+// test_ClassyC_Stats.c
+#define CLASSYC_STATS
+#include "unity.h"
+#include "../ClassyC.h"
+
+
+
+
+
+
+
+/* Test Case: Constructors and destructors keep the statistics of the class of the objects */
+#undef CLASS
+#define CLASS CountedBase
+#define CLASS_CountedBase(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) \
+    Data(int, value)
+
+CONSTRUCTOR(int initial_value)
+    self->value = initial_value;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+
+#undef CLASS
+#define CLASS CountedDerived
+#define CLASS_CountedDerived(Base, Interface, Data, Event, Method, Override) \
+    Base(CountedBase) \
+    Data(double, weight)
+
+SLOT_MAP()
+
+CONSTRUCTOR(int initial_value)
+    INIT_BASE(initial_value);
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+
+/* Never constructed: it has no statistics in the list */
+#undef CLASS
+#define CLASS Uncounted
+#define CLASS_Uncounted(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT)
+
+CONSTRUCTOR()
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+void test_StatsHeapAndInplace(void) {
+    CountedBase *heap = NEW_ALLOC(CountedBase, 1);
+    CountedBase *nozero = NEW_ALLOC_NOZERO(CountedBase, 2);
+    CountedBase stack;
+    NEW_INPLACE(CountedBase, &stack, 3);
+
+    ClassyC_class_stats_snapshot stats = CLASSYC_STATS_GET(CountedBase);
+    TEST_ASSERT_EQUAL_PTR(CLASS_INFO(CountedBase), stats.class_info);
+    TEST_ASSERT_EQUAL_size_t(3, stats.live);
+    TEST_ASSERT_EQUAL_size_t(3, stats.peak);
+    TEST_ASSERT_EQUAL_size_t(3, stats.constructed);
+    TEST_ASSERT_EQUAL_size_t(0, stats.destroyed);
+    TEST_ASSERT_EQUAL_size_t(2, stats.heap_constructed);
+    TEST_ASSERT_EQUAL_size_t(1, stats.inplace_constructed);
+    TEST_ASSERT_EQUAL_size_t(3 * sizeof(CountedBase), stats.bytes_in_use);
+
+    DESTROY_FREE(heap);
+    DESTROY_FREE(nozero);
+    DESTROY(stack);
+    /* Destroying twice doesn't count twice */
+    DESTROY(stack);
+    stats = CLASSYC_STATS_GET(CountedBase);
+    TEST_ASSERT_EQUAL_size_t(0, stats.live);
+    TEST_ASSERT_EQUAL_size_t(3, stats.peak);
+    TEST_ASSERT_EQUAL_size_t(3, stats.destroyed);
+    TEST_ASSERT_EQUAL_size_t(0, stats.bytes_in_use);
+}
+
+void test_StatsDerivedArraysAndSlotMaps(void) {
+    /* Objects count in their own class, not in their base classes */
+    CountedBase *as_base = (CountedBase *)NEW_ALLOC(CountedDerived, 1);
+    TEST_ASSERT_EQUAL_size_t(1, CLASSYC_STATS_GET(CountedDerived).live);
+    TEST_ASSERT_EQUAL_size_t(0, CLASSYC_STATS_GET(CountedBase).live);
+    /* Destroyed through a base class pointer, counted in the class of the object */
+    DESTROY_FREE(as_base);
+    TEST_ASSERT_EQUAL_size_t(0, CLASSYC_STATS_GET(CountedDerived).live);
+
+    CountedDerived *array = NEW_ARRAY(CountedDerived, 5, 7);
+    ClassyC_handle handle = HANDLE_NEW(CountedDerived, 8);
+    ClassyC_class_stats_snapshot stats = CLASSYC_STATS_GET(CountedDerived);
+    TEST_ASSERT_EQUAL_size_t(6, stats.live);
+    TEST_ASSERT_EQUAL_size_t(7, stats.constructed);
+    TEST_ASSERT_EQUAL_size_t(6, stats.heap_constructed);
+    TEST_ASSERT_EQUAL_size_t(1, stats.inplace_constructed);
+    DESTROY_ARRAY(array);
+    HANDLE_DESTROY(CountedDerived, handle);
+    stats = CLASSYC_STATS_GET(CountedDerived);
+    TEST_ASSERT_EQUAL_size_t(0, stats.live);
+    TEST_ASSERT_EQUAL_size_t(6, stats.peak);
+    TEST_ASSERT_EQUAL_size_t(7, stats.destroyed);
+    SLOT_MAP_RELEASE(CountedDerived);
+}
+
+void test_StatsCollect(void) {
+    ClassyC_class_stats_snapshot snapshots[8];
+    size_t count = CLASSYC_STATS_COLLECT(snapshots, 8);
+    size_t i;
+    bool base_found = false, derived_found = false;
+    TEST_ASSERT_EQUAL_size_t(2, count);
+    for (i = 0; i < count; i++) {
+        TEST_ASSERT_TRUE(snapshots[i].class_info != CLASS_INFO(Uncounted));
+        base_found = base_found || snapshots[i].class_info == CLASS_INFO(CountedBase);
+        derived_found = derived_found || snapshots[i].class_info == CLASS_INFO(CountedDerived);
+    }
+    TEST_ASSERT_TRUE(base_found && derived_found);
+    TEST_ASSERT_EQUAL_size_t(0, CLASSYC_STATS_GET(Uncounted).constructed);
+    /* Only the number of classes is returned when there is no room for them */
+    TEST_ASSERT_EQUAL_size_t(2, CLASSYC_STATS_COLLECT(snapshots, 0));
+}
+
+
+
+
+
+/* ==========================
+   Unity Setup
+   ========================== */
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_StatsHeapAndInplace);
+    RUN_TEST(test_StatsDerivedArraysAndSlotMaps);
+    RUN_TEST(test_StatsCollect);
+
+    return UNITY_END();
+}
@@ -0,0 +1,291 @@
+// test_ClassyC_Trace.c
+#include <stdint.h>
+/* A clock driven by the tests: every reading advances it 1 microsecond, so the spans of a thread never overlap by chance */
+static _Thread_local uint64_t trace_clock = 0;
+#define CLASSYC_TRACE_CLOCK() (trace_clock += 1000)
+#define CLASSYC_TRACE_BUFFER_SPANS 64
+#define CLASSYC_TRACE
+#include "unity.h"
+#include "../ClassyC.h"
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+
+
+
+
+
+
+/* Test Case: Methods, constructor and destructor chains, event raises and event handlers record nested spans */
+#define I_Changer(Data, Event, Method) \
+    Event(on_change, int value)
+CREATE_INTERFACE(Changer)
+
+#undef CLASS
+#define CLASS TraceBase
+#define CLASS_TraceBase(Base, Interface, Data, Event, Method, Override) \
+    Base(OBJECT) Interface(Changer) \
+    Data(int, value) \
+    Event(on_change, int value) \
+    Method(int, get_value)
+
+CONSTRUCTOR(int initial_value)
+    self->value = initial_value;
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(int, get_value)
+    return self->value;
+END_METHOD
+
+
+#undef CLASS
+#define CLASS TraceDerived
+#define CLASS_TraceDerived(Base, Interface, Data, Event, Method, Override) \
+    Base(TraceBase) \
+    Override(int, get_value)
+
+CONSTRUCTOR(int initial_value)
+    INIT_BASE(initial_value);
+END_CONSTRUCTOR
+
+DESTRUCTOR()
+END_DESTRUCTOR
+
+METHOD(int, get_value)
+    return 2 * BASE_METHOD(get_value);
+END_METHOD
+
+static int traced_changes = 0;
+EVENT_HANDLER(TraceBase, on_change, trace_change, int value)
+    traced_changes += value;
+END_EVENT_HANDLER
+
+/* Flush the spans into a string */
+static size_t trace_flush_to(char *json, size_t size) {
+    FILE *file = tmpfile();
+    size_t written, length;
+    TEST_ASSERT_NOT_NULL(file);
+    written = CLASSYC_TRACE_FLUSH(file);
+    rewind(file);
+    length = fread(json, 1, size - 1, file);
+    json[length] = '\0';
+    fclose(file);
+    return written;
+}
+
+/* Find a span of the flushed JSON by name (and is_base argument). Times in nanoseconds. */
+static bool trace_find_span(const char *json, const char *name, bool is_base, uint64_t *start, uint64_t *end) {
+    char key[128];
+    const char *line = json;
+    snprintf(key, sizeof(key), "{\"name\":\"%s\",", name);
+    while ((line = strstr(line, key)) != NULL) {
+        const char *line_end = strchr(line, '\n');
+        const char *args = strstr(line, "\"is_base\":true");
+        unsigned long long ts, ts_fraction, dur, dur_fraction;
+        if ((args != NULL && args < line_end) == is_base &&
+            sscanf(strstr(line, "\"ts\":"), "\"ts\":%llu.%3llu,\"dur\":%llu.%3llu", &ts, &ts_fraction, &dur, &dur_fraction) == 4) {
+            *start = ts * 1000 + ts_fraction;
+            *end = *start + dur * 1000 + dur_fraction;
+            return true;
+        }
+        line += strlen(key);
+    }
+    return false;
+}
+
+/* The inner span must be found, start after the outer one and end before it */
+static void trace_assert_nested(const char *json, const char *outer, bool outer_is_base, const char *inner, bool inner_is_base) {
+    uint64_t outer_start, outer_end, inner_start, inner_end;
+    TEST_ASSERT_TRUE(trace_find_span(json, outer, outer_is_base, &outer_start, &outer_end));
+    TEST_ASSERT_TRUE(trace_find_span(json, inner, inner_is_base, &inner_start, &inner_end));
+    TEST_ASSERT_TRUE(outer_start < inner_start);
+    TEST_ASSERT_TRUE(inner_end < outer_end);
+}
+
+static char trace_json[65536];
+
+void test_TraceChains(void) {
+    uint64_t start, end;
+    TraceDerived *derived = NEW_ALLOC(TraceDerived, 4);
+    TraceBase *base = NEW_ALLOC(TraceBase, 1);
+    /* Leave the constructors out, checked below */
+    trace_flush_to(trace_json, sizeof(trace_json));
+
+    TEST_ASSERT_EQUAL_INT(8, derived->get_value(derived));
+    REGISTER_EVENT(TraceBase, on_change, trace_change, base);
+    RAISE_EVENT(base, on_change, 3);
+    RAISE_INTERFACE_EVENT(base->to_Changer(base), on_change, 4);
+    /* No handlers: no span */
+    RAISE_EVENT(derived, on_change, 5);
+    TEST_ASSERT_EQUAL_INT(7, traced_changes);
+    DESTROY_FREE(derived);
+    DESTROY_FREE(base);
+
+    /* get_value of both classes, 2 raises, 2 handlers and 2 destructor levels of the derived object and 1 of the base */
+    TEST_ASSERT_EQUAL_size_t(2 + 2 + 2 + 3, trace_flush_to(trace_json, sizeof(trace_json)));
+    TEST_ASSERT_EQUAL_INT(0, strncmp(trace_json, "{\"traceEvents\":[", 16));
+    TEST_ASSERT_NOT_NULL(strstr(trace_json, "\n],\"displayTimeUnit\":\"ns\"}\n"));
+    TEST_ASSERT_NOT_NULL(strstr(trace_json, "\"cat\":\"method\",\"ph\":\"X\""));
+    trace_assert_nested(trace_json, "TraceDerived::get_value", false, "TraceBase::get_value", false);
+    trace_assert_nested(trace_json, "on_change", false, "TraceBase::on_change:trace_change", false);
+    trace_assert_nested(trace_json, "TraceDerived::destructor", false, "TraceBase::destructor", true);
+    TEST_ASSERT_TRUE(trace_find_span(trace_json, "TraceBase::destructor", false, &start, &end));
+    TEST_ASSERT_FALSE(trace_find_span(trace_json, "TraceDerived::constructor", false, &start, &end));
+
+    /* The base class level of the constructor chain, flushed again */
+    derived = NEW_ALLOC(TraceDerived, 1);
+    TEST_ASSERT_EQUAL_size_t(2, trace_flush_to(trace_json, sizeof(trace_json)));
+    trace_assert_nested(trace_json, "TraceDerived::constructor", false, "TraceBase::constructor", true);
+    DESTROY_FREE(derived);
+    trace_flush_to(trace_json, sizeof(trace_json));
+
+    /* Nothing new: an empty document */
+    TEST_ASSERT_EQUAL_size_t(0, trace_flush_to(trace_json, sizeof(trace_json)));
+    TEST_ASSERT_EQUAL_STRING("{\"traceEvents\":[\n],\"displayTimeUnit\":\"ns\"}\n", trace_json);
+}
+
+/* A full buffer overwrites the oldest spans */
+void test_TraceRingOverwrite(void) {
+    TraceBase object;
+    uint64_t start, end, last_start, last_end;
+    int i;
+    NEW_INPLACE(TraceBase, &object, 1);
+    trace_flush_to(trace_json, sizeof(trace_json));
+    for (i = 0; i < CLASSYC_TRACE_BUFFER_SPANS + 10; i++) {
+        object.get_value(&object);
+    }
+    DESTROY(object);
+    /* The whole buffer is flushed */
+    TEST_ASSERT_EQUAL_size_t(CLASSYC_TRACE_BUFFER_SPANS, trace_flush_to(trace_json, sizeof(trace_json)));
+    /* The destructor is the newest span, and the first method calls are gone */
+    TEST_ASSERT_TRUE(trace_find_span(trace_json, "TraceBase::destructor", false, &last_start, &last_end));
+    TEST_ASSERT_TRUE(trace_find_span(trace_json, "TraceBase::get_value", false, &start, &end));
+    TEST_ASSERT_EQUAL_UINT64(last_start - 2000 * (CLASSYC_TRACE_BUFFER_SPANS - 1), start);
+}
+
+/* Every thread records in its own buffer, flushed with its thread id */
+#define TRACE_THREADS 4
+#define TRACE_THREAD_CALLS 10
+static int trace_thread_ids[TRACE_THREADS];
+static void *trace_thread(void *argument) {
+    TraceBase object;
+    int i, sum = 0;
+    NEW_INPLACE(TraceBase, &object, 1);
+    for (i = 0; i < TRACE_THREAD_CALLS; i++) {
+        sum += object.get_value(&object);
+    }
+    DESTROY(object);
+    return sum == TRACE_THREAD_CALLS ? argument : NULL;
+}
+
+/* Run the threads, each recording TRACE_THREAD_CALLS methods, its constructor and its destructor */
+static void trace_run_threads(void) {
+    pthread_t threads[TRACE_THREADS];
+    int i;
+    for (i = 0; i < TRACE_THREADS; i++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, trace_thread, &trace_thread_ids[i]));
+    }
+    for (i = 0; i < TRACE_THREADS; i++) {
+        void *result;
+        pthread_join(threads[i], &result);
+        TEST_ASSERT_NOT_NULL(result);
+    }
+}
+
+static size_t trace_buffer_count(void) {
+    size_t count = 0;
+    ClassyC_trace_buffer *buffer = atomic_load(&ADD_PREFIX(trace_buffers));
+    for (; buffer; buffer = buffer->next) {
+        count++;
+    }
+    return count;
+}
+
+void test_TraceThreads(void) {
+    char tid[32];
+    int i, round;
+    trace_flush_to(trace_json, sizeof(trace_json));
+    for (round = 0; round < 3; round++) {
+        trace_run_threads();
+        /* The buffers outlive their threads */
+        TEST_ASSERT_EQUAL_size_t(TRACE_THREADS * (TRACE_THREAD_CALLS + 2), trace_flush_to(trace_json, sizeof(trace_json)));
+        /* The main thread has the first buffer */
+        for (i = 2 + round * TRACE_THREADS; i < 2 + (round + 1) * TRACE_THREADS; i++) {
+            snprintf(tid, sizeof(tid), "\"tid\":%d}", i);
+            TEST_ASSERT_NOT_NULL(strstr(trace_json, tid));
+        }
+        TEST_ASSERT_NULL(strstr(trace_json, "\"tid\":1}"));
+        /* Flushed, the buffers of the ended threads are freed: only the first of the list (added last) is left with */
+        /* the buffer of the main thread */
+        TEST_ASSERT_EQUAL_size_t(2, trace_buffer_count());
+    }
+    /* Nothing left to flush */
+    TEST_ASSERT_EQUAL_size_t(0, trace_flush_to(trace_json, sizeof(trace_json)));
+}
+
+
+/* Flushes while a thread keeps wrapping around its buffer: the spans copied are whole, never mixing two spans. With the */
+/* test clock, the derived method lasts 3 microseconds (it calls the base one) and the base method 1. */
+static _Atomic bool trace_wrap_stop;
+static void *trace_wrap_thread(void *argument) {
+    TraceDerived object;
+    (void)argument;
+    NEW_INPLACE(TraceDerived, &object, 1);
+    while (!atomic_load(&trace_wrap_stop)) {
+        object.get_value(&object);
+    }
+    DESTROY(object);
+    return NULL;
+}
+
+void test_TraceFlushWhileWrapping(void) {
+    pthread_t thread;
+    int round;
+    size_t spans = 0;
+    trace_flush_to(trace_json, sizeof(trace_json));
+    atomic_store(&trace_wrap_stop, false);
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, trace_wrap_thread, NULL));
+    for (round = 0; round < 200; round++) {
+        const char *line = trace_json;
+        spans += trace_flush_to(trace_json, sizeof(trace_json));
+        while ((line = strstr(line, "\n{\"name\":\"")) != NULL) {
+            const char *line_end = strchr(line + 1, '\n');
+            const char *dur = strstr(line, "\"dur\":");
+            line += strlen("\n{\"name\":\"");
+            if (strncmp(line, "TraceDerived::get_value\"", 24) == 0) {
+                TEST_ASSERT_EQUAL_INT(0, strncmp(dur, "\"dur\":3.000,", 12));
+            } else if (strncmp(line, "TraceBase::get_value\"", 21) == 0) {
+                TEST_ASSERT_EQUAL_INT(0, strncmp(dur, "\"dur\":1.000,", 12));
+            }
+            TEST_ASSERT_TRUE(line_end == NULL || dur < line_end);
+        }
+        sched_yield();
+    }
+    atomic_store(&trace_wrap_stop, true);
+    pthread_join(thread, NULL);
+    TEST_ASSERT_TRUE(spans > 0);
+}
+
+
+
+/* ==========================
+   Unity Setup
+   ========================== */
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_TraceChains);
+    RUN_TEST(test_TraceRingOverwrite);
+    RUN_TEST(test_TraceThreads);
+    RUN_TEST(test_TraceFlushWhileWrapping);
+
+    return UNITY_END();
+}